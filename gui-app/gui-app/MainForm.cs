@@ -7,6 +7,7 @@ namespace GuiApp
     using SceneHandle = System.UInt64;
     using CameraHandle = System.UInt64;
     using ImageHandle = System.UInt64;
+    using RenderHandle = System.UInt64;
 
     public partial class MainForm : Form
     {
@@ -168,33 +169,39 @@ namespace GuiApp
             settings.samplesPerPixel = spp;
             settings.maxPathLength   = maxPathLen;
             settings.rayTMin         = 0.0001f;
+            settings.russianRouletteDepth = 3;
             settings.renderMode      = (uint)RaylibWrapper.ERenderMode.Default;
+            settings.sampler         = (uint)RaylibWrapper.ESampler.Sobol;
 
-            // Render the scene.
+            // Render the scene. Aux images for the denoiser come from the same pass.
             loggerBox.AppendText("Render..." + Environment.NewLine);
 
-            RaylibWrapper.Raylib_Render(ref settings, sceneHandle, cameraHandle, mainImage);
+            ImageHandle albedoImage = 0;
+            ImageHandle normalImage = 0;
+            if (bRunDenoiser)
+            {
+                albedoImage = RaylibWrapper.Raylib_CreateImage(viewportWidth, viewportHeight);
+                normalImage = RaylibWrapper.Raylib_CreateImage(viewportWidth, viewportHeight);
+                settings.aovMask = (1u << (int)RaylibWrapper.EAOV.Albedo) | (1u << (int)RaylibWrapper.EAOV.Normal);
+            }
+            ImageHandle[] aovImages = new ImageHandle[(int)RaylibWrapper.EAOV.MAX];
+            aovImages[(int)RaylibWrapper.EAOV.Albedo] = albedoImage;
+            aovImages[(int)RaylibWrapper.EAOV.Normal] = normalImage;
+
+            // Render in background threads so that the window keeps responding.
+            RenderHandle render = RaylibWrapper.Raylib_RenderAsync(ref settings, sceneHandle, cameraHandle, mainImage, aovImages, null, System.IntPtr.Zero);
+            while (RaylibWrapper.Raylib_WaitRender(render, 100) == 0)
+            {
+                Application.DoEvents();
+            }
+            RaylibWrapper.Raylib_DestroyRender(render);
 
             float[] finalImageData = new float[viewportWidth * viewportHeight * 3];
 
             if (bRunDenoiser)
             {
-                ImageHandle albedoImage = RaylibWrapper.Raylib_CreateImage(viewportWidth, viewportHeight);
-                ImageHandle normalImage = RaylibWrapper.Raylib_CreateImage(viewportWidth, viewportHeight);
                 ImageHandle denoisedImage = RaylibWrapper.Raylib_CreateImage(viewportWidth, viewportHeight);
 
-                // Force aperture=0
-                CameraHandle auxCamera = RaylibWrapper.Raylib_CreateCamera();
-                RaylibWrapper.Raylib_CameraCopy(cameraHandle, auxCamera);
-                RaylibWrapper.Raylib_CameraSetLens(auxCamera, 0.0f, 1.0f);
-
-                // Render aux images
-                RaylibWrapper.RendererSettings auxSettings = settings;
-                auxSettings.renderMode = (uint)RaylibWrapper.ERenderMode.Albedo;
-                RaylibWrapper.Raylib_Render(ref auxSettings, sceneHandle, auxCamera, albedoImage);
-                auxSettings.renderMode = (uint)RaylibWrapper.ERenderMode.MicrosurfaceNormal;
-                RaylibWrapper.Raylib_Render(ref auxSettings, sceneHandle, auxCamera, normalImage);
-
                 RaylibWrapper.Raylib_Denoise(mainImage, 1, albedoImage, normalImage, denoisedImage);
                 
                 RaylibWrapper.Raylib_PostProcess(denoisedImage);
@@ -202,7 +209,6 @@ namespace GuiApp
 
                 RaylibWrapper.Raylib_DumpImageData(denoisedImage, finalImageData);
 
-                RaylibWrapper.Raylib_DestroyCamera(auxCamera);
                 RaylibWrapper.Raylib_DestroyImage(albedoImage);
                 RaylibWrapper.Raylib_DestroyImage(normalImage);
                 RaylibWrapper.Raylib_DestroyImage(denoisedImage);
@@ -6,6 +6,7 @@ namespace GuiApp
     using SceneHandle = System.UInt64;
     using CameraHandle = System.UInt64;
     using ImageHandle = System.UInt64;
+    using RenderHandle = System.UInt64;
 
     // Wrapper for raylib.dll which is built from my C++ project.
     // See raylib.h for original definitions.
@@ -24,17 +25,68 @@ namespace GuiApp
 	        MAX
         }
 
+        internal enum EIntegrator : uint
+        {
+            Megakernel = 0, // Recursive path tracing, one path at a time per thread.
+            Wavefront  = 1, // Batches of paths are processed in stages (intersect, sort, shade, ...)
+
+            MAX
+        }
+
+        internal enum EAOV : uint
+        {
+            Albedo     = 0, // First-hit albedo. Mirror-like surfaces show what they reflect.
+            Normal     = 1, // First-hit microsurface normal in world space. In [-1, 1], not encoded as a color.
+            Depth      = 2, // Distance from the camera to the first hit.
+            ObjectID   = 3, // Index of the scene element, starting from 1.
+            MaterialID = 4, // Index of the material in the scene, starting from 1.
+
+            MAX
+        }
+
+        internal enum ESampler : uint
+        {
+            Independent = 0, // White noise.
+            Sobol       = 1, // Owen-scrambled Sobol. Stratified across the samples of each pixel.
+
+            MAX
+        }
+
+        internal enum ESIMDLevel : uint
+        {
+            Auto    = 0, // Best level supported by the CPU.
+            Generic = 1, // Baseline of the build.
+            SSE42   = 2,
+            AVX2    = 3,
+            AVX512  = 4,
+
+            MAX
+        }
+
         [StructLayout(LayoutKind.Sequential)]
         internal struct RendererSettings
         {
             internal uint  viewportWidth;
             internal uint  viewportHeight;
+            internal uint  cropX;
+            internal uint  cropY;
+            internal uint  cropWidth;
+            internal uint  cropHeight;
 
             internal int   samplesPerPixel;
             internal int   maxPathLength;
             internal float rayTMin;
+            internal int   russianRouletteDepth;
+            internal uint  seed;
+            internal int   firstSample;
 
             internal uint  renderMode;
+            internal uint  integrator;
+            internal uint  sampler;
+            internal uint  aovMask;
+            internal uint  numThreads;
+            internal uint  pinThreads;
+            internal uint  pinSlotOffset;
         }
 
         // -----------------------------------------------------------------------
@@ -46,6 +98,12 @@ namespace GuiApp
         [DllImport("raylib.dll")]
         internal static extern int Raylib_Terminate();
 
+        [DllImport("raylib.dll")]
+        internal static extern uint Raylib_SetSIMDLevel(uint level);
+
+        [DllImport("raylib.dll")]
+        internal static extern uint Raylib_GetSIMDLevel();
+
         // -----------------------------------------------------------------------
         // Manage media files
 
@@ -130,6 +188,64 @@ namespace GuiApp
             CameraHandle camera,
             ImageHandle outMainImage);
 
+        // outAOVImages should have EAOV.MAX elements.
+        [DllImport("raylib.dll")]
+        internal static extern void Raylib_RenderWithAOVs(
+            ref RendererSettings settings,
+            SceneHandle scene,
+            CameraHandle camera,
+            ImageHandle outMainImage,
+            ImageHandle[] outAOVImages);
+
+        // Called by a render thread after each tile is written.
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void RenderTileCallback(System.IntPtr userData, uint x, uint y, uint width, uint height);
+
+        // Keep tileCallback alive until the render is done.
+        [DllImport("raylib.dll")]
+        internal static extern RenderHandle Raylib_RenderAsync(
+            ref RendererSettings settings,
+            SceneHandle scene,
+            CameraHandle camera,
+            ImageHandle outMainImage,
+            ImageHandle[] outAOVImages,
+            RenderTileCallback tileCallback,
+            System.IntPtr callbackUserData);
+
+        [DllImport("raylib.dll")]
+        internal static extern float Raylib_GetRenderProgress(RenderHandle render);
+
+        // Returns 1 if the render is done, 0 if timed out. Negative timeout waits indefinitely.
+        [DllImport("raylib.dll")]
+        internal static extern int Raylib_WaitRender(RenderHandle render, int timeoutMilliseconds);
+
+        [DllImport("raylib.dll")]
+        internal static extern void Raylib_CancelRender(RenderHandle render);
+
+        [DllImport("raylib.dll")]
+        internal static extern int Raylib_DestroyRender(RenderHandle render);
+
+        // Arrays have numViews elements; outAOVImages is null or has (numViews * EAOV.MAX) elements.
+        [DllImport("raylib.dll")]
+        internal static extern void Raylib_RenderViews(
+            SceneHandle scene,
+            int numViews,
+            RendererSettings[] settings,
+            CameraHandle[] cameras,
+            ImageHandle[] outMainImages,
+            ImageHandle[] outAOVImages);
+
+        // Returns samples per pixel rendered by this call, or -1 if a checkpoint could not be written.
+        [DllImport("raylib.dll")]
+        internal static extern int Raylib_RenderWithCheckpoints(
+            ref RendererSettings settings,
+            SceneHandle scene,
+            CameraHandle camera,
+            ImageHandle outMainImage,
+            ImageHandle[] outAOVImages,
+            string checkpointPath,
+            float checkpointIntervalSeconds);
+
         [DllImport("raylib.dll")]
         internal static extern int Raylib_Denoise(
             ImageHandle mainImage,
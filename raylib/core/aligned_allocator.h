@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/platform.h"
+#include "core/assertion.h"
+
+#include <cstddef>
+
+#if PLATFORM_WINDOWS
+	#include <malloc.h>
+#else
+	#include <stdlib.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+// std::allocator with a minimum alignment, e.g., to start a buffer at a cache line.
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	using value_type = T;
+
+	template<typename U>
+	struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+	AlignedAllocator() = default;
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t n)
+	{
+		if (n == 0)
+		{
+			return nullptr;
+		}
+		const size_t alignment = (Alignment > alignof(T)) ? Alignment : alignof(T);
+		void* ptr = nullptr;
+#if PLATFORM_WINDOWS
+		ptr = _aligned_malloc(n * sizeof(T), alignment);
+#else
+		if (posix_memalign(&ptr, alignment, n * sizeof(T)) != 0)
+		{
+			ptr = nullptr;
+		}
+#endif
+		CHECKF(ptr != nullptr, "Out of memory");
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t)
+	{
+#if PLATFORM_WINDOWS
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
@@ -0,0 +1,255 @@
+#include "cpu_affinity.h"
+#include "core/platform.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+struct CoreInfo
+{
+	int32 cpu;
+	int32 node;
+};
+
+// Cores of the process affinity mask, ordered to alternate between NUMA nodes.
+static std::vector<int32> OrderCoresByNode(std::vector<CoreInfo> cores)
+{
+	std::stable_sort(cores.begin(), cores.end(),
+		[](const CoreInfo& a, const CoreInfo& b) { return a.node < b.node; });
+
+	// Rank of each core within its node
+	std::vector<std::pair<int32, int32>> rankedCores; // (rank, index)
+	int32 rank = 0;
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		rank = (i > 0 && cores[i].node == cores[i - 1].node) ? rank + 1 : 0;
+		rankedCores.emplace_back(rank, (int32)i);
+	}
+	std::stable_sort(rankedCores.begin(), rankedCores.end(),
+		[](const std::pair<int32, int32>& a, const std::pair<int32, int32>& b) { return a.first < b.first; });
+
+	std::vector<int32> ordered;
+	for (const auto& rankedCore : rankedCores)
+	{
+		ordered.push_back(cores[rankedCore.second].cpu);
+	}
+	return ordered;
+}
+
+////////////////////////////////////////////////////////
+// Platform-specific
+#if PLATFORM_WINDOWS
+
+#include <Windows.h>
+
+static std::vector<CoreInfo> GetAllowedCores()
+{
+	std::vector<CoreInfo> cores;
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+	{
+		return cores;
+	}
+	for (int32 cpu = 0; cpu < (int32)(8 * sizeof(DWORD_PTR)); ++cpu)
+	{
+		if ((processMask & ((DWORD_PTR)1 << cpu)) != 0)
+		{
+			UCHAR node = 0;
+			GetNumaProcessorNode((UCHAR)cpu, &node);
+			cores.push_back(CoreInfo{ cpu, (int32)node });
+		}
+	}
+	return cores;
+}
+
+// Hard cap of the job object, if any.
+static uint32 GetCPUQuotaCores()
+{
+	JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rateControl{};
+	if (!QueryInformationJobObject(NULL, JobObjectCpuRateControlInformation, &rateControl, sizeof(rateControl), NULL))
+	{
+		return 0;
+	}
+	const DWORD flags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+	if ((rateControl.ControlFlags & flags) != flags)
+	{
+		return 0;
+	}
+	// CpuRate is in 1/100 percent of all cores.
+	const uint64 numSystemCores = (uint64)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+	return (uint32)((rateControl.CpuRate * numSystemCores + 9999) / 10000);
+}
+
+static bool PinCurrentThreadToCPU(int32 cpu)
+{
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+}
+
+#elif defined(__linux__)
+
+#include <sched.h>
+#include <stdio.h>
+
+// Parse a list like "0-3,8,10-11".
+static std::vector<int32> ReadCPUList(const char* filepath)
+{
+	std::vector<int32> cpus;
+	FILE* fp = fopen(filepath, "r");
+	if (fp == nullptr)
+	{
+		return cpus;
+	}
+	int32 first, last;
+	while (fscanf(fp, "%d", &first) == 1)
+	{
+		last = first;
+		int c = fgetc(fp);
+		if (c == '-')
+		{
+			if (fscanf(fp, "%d", &last) != 1)
+			{
+				break;
+			}
+			c = fgetc(fp);
+		}
+		for (int32 cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+		if (c != ',')
+		{
+			break;
+		}
+	}
+	fclose(fp);
+	return cpus;
+}
+
+static std::vector<CoreInfo> GetAllowedCores()
+{
+	std::vector<CoreInfo> cores;
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0)
+	{
+		return cores;
+	}
+
+	std::vector<int32> cpuToNode(CPU_SETSIZE, 0);
+	const int32 maxNodes = 64;
+	for (int32 node = 0; node < maxNodes; ++node)
+	{
+		char filepath[64];
+		snprintf(filepath, sizeof(filepath), "/sys/devices/system/node/node%d/cpulist", node);
+		for (int32 cpu : ReadCPUList(filepath))
+		{
+			if (cpu < CPU_SETSIZE)
+			{
+				cpuToNode[cpu] = node;
+			}
+		}
+	}
+
+	for (int32 cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (CPU_ISSET(cpu, &cpuSet))
+		{
+			cores.push_back(CoreInfo{ cpu, cpuToNode[cpu] });
+		}
+	}
+	return cores;
+}
+
+// CFS quota of the cgroup, if any. Containers see their own cgroup at /sys/fs/cgroup.
+static uint32 GetCPUQuotaCores()
+{
+	long long quota = -1, period = 0;
+	if (FILE* fp = fopen("/sys/fs/cgroup/cpu.max", "r")) // cgroup v2: "<quota|max> <period>"
+	{
+		if (fscanf(fp, "%lld %lld", &quota, &period) != 2)
+		{
+			quota = -1; // "max"
+		}
+		fclose(fp);
+	}
+	else if (FILE* fp = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r")) // cgroup v1
+	{
+		if (fscanf(fp, "%lld", &quota) != 1)
+		{
+			quota = -1;
+		}
+		fclose(fp);
+		if (FILE* fp2 = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r"))
+		{
+			if (fscanf(fp2, "%lld", &period) != 1)
+			{
+				period = 0;
+			}
+			fclose(fp2);
+		}
+	}
+	if (quota <= 0 || period <= 0)
+	{
+		return 0;
+	}
+	return (uint32)((quota + period - 1) / period);
+}
+
+static bool PinCurrentThreadToCPU(int32 cpu)
+{
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(cpu, &cpuSet);
+	return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+}
+
+#else
+
+static std::vector<CoreInfo> GetAllowedCores()
+{
+	return std::vector<CoreInfo>();
+}
+
+static uint32 GetCPUQuotaCores()
+{
+	return 0;
+}
+
+static bool PinCurrentThreadToCPU(int32 cpu)
+{
+	return false;
+}
+
+#endif
+////////////////////////////////////////////////////////
+
+static const std::vector<int32>& GetOrderedCores()
+{
+	static const std::vector<int32> orderedCores = OrderCoresByNode(GetAllowedCores());
+	return orderedCores;
+}
+
+uint32 GetNumUsableCores()
+{
+	uint32 numCores = (uint32)GetOrderedCores().size();
+	if (numCores == 0)
+	{
+		numCores = std::max(1u, std::thread::hardware_concurrency());
+	}
+	const uint32 quotaCores = GetCPUQuotaCores();
+	if (quotaCores > 0)
+	{
+		numCores = std::min(numCores, quotaCores);
+	}
+	return numCores;
+}
+
+bool PinCurrentThreadToCore(uint32 slot)
+{
+	const std::vector<int32>& cores = GetOrderedCores();
+	if (cores.size() == 0)
+	{
+		return false;
+	}
+	return PinCurrentThreadToCPU(cores[slot % cores.size()]);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "raylib_types.h"
+#include "core/int_types.h"
+
+// Number of cores this process can actually use:
+// the cores in its affinity mask, limited by the CPU quota of its cgroup (Linux) if any.
+// std::thread::hardware_concurrency() reports all cores of the host instead.
+RAYLIB_API uint32 GetNumUsableCores();
+
+// Pin the calling thread to one core of the process affinity mask.
+// Consecutive slots alternate between NUMA nodes, so any number of threads
+// spreads evenly over the memory controllers. Slots wrap around if there are more than cores.
+// Memory first touched by a pinned thread is then allocated on its node.
+// @return false if the platform doesn't support it or the call failed.
+bool PinCurrentThreadToCore(uint32 slot);
@@ -0,0 +1,94 @@
+#include "cpu_features.h"
+#include "core/platform.h"
+
+////////////////////////////////////////////////////////
+// Platform-specific
+#if PLATFORM_WINDOWS
+
+#include <intrin.h>
+#include <immintrin.h>
+
+static void CPUID(uint32 leaf, uint32 subleaf, uint32 outRegs[4])
+{
+	int regs[4];
+	__cpuidex(regs, (int)leaf, (int)subleaf);
+	for (int32 i = 0; i < 4; ++i)
+	{
+		outRegs[i] = (uint32)regs[i];
+	}
+}
+
+static uint64 XGETBV()
+{
+	return (uint64)_xgetbv(0);
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+
+static void CPUID(uint32 leaf, uint32 subleaf, uint32 outRegs[4])
+{
+	outRegs[0] = outRegs[1] = outRegs[2] = outRegs[3] = 0;
+	__get_cpuid_count(leaf, subleaf, &outRegs[0], &outRegs[1], &outRegs[2], &outRegs[3]);
+}
+
+static uint64 XGETBV()
+{
+	uint32 eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64)edx << 32) | eax;
+}
+
+#else
+
+static void CPUID(uint32 leaf, uint32 subleaf, uint32 outRegs[4])
+{
+	outRegs[0] = outRegs[1] = outRegs[2] = outRegs[3] = 0;
+}
+
+static uint64 XGETBV()
+{
+	return 0;
+}
+
+#endif
+////////////////////////////////////////////////////////
+
+static CPUFeatures QueryCPUFeatures()
+{
+	CPUFeatures features;
+
+	uint32 regs[4]; // eax, ebx, ecx, edx
+	CPUID(0, 0, regs);
+	const uint32 maxLeaf = regs[0];
+	if (maxLeaf < 1)
+	{
+		return features;
+	}
+
+	CPUID(1, 0, regs);
+	features.bSSE42 = (regs[2] & (1u << 20)) != 0;
+	const bool bOSXSAVE = (regs[2] & (1u << 27)) != 0;
+	const bool bCPUAVX = (regs[2] & (1u << 28)) != 0;
+
+	// The OS should save the upper halves of the registers on context switches.
+	const uint64 xcr0 = bOSXSAVE ? XGETBV() : 0;
+	const bool bOSAVX = (xcr0 & 0x6) == 0x6;       // XMM, YMM
+	const bool bOSAVX512 = (xcr0 & 0xE6) == 0xE6;  // XMM, YMM, opmask, ZMM
+
+	features.bAVX = bCPUAVX && bOSAVX;
+	if (maxLeaf >= 7)
+	{
+		CPUID(7, 0, regs);
+		features.bAVX2 = features.bAVX && (regs[1] & (1u << 5)) != 0;
+		features.bAVX512F = features.bAVX2 && bOSAVX512 && (regs[1] & (1u << 16)) != 0;
+	}
+	return features;
+}
+
+const CPUFeatures& GetCPUFeatures()
+{
+	static const CPUFeatures features = QueryCPUFeatures();
+	return features;
+}
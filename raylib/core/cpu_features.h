@@ -0,0 +1,15 @@
+#pragma once
+
+#include "core/int_types.h"
+
+// Instruction sets of the running CPU that the OS also supports (register state saved by XSAVE).
+struct CPUFeatures
+{
+	bool bSSE42   = false;
+	bool bAVX     = false;
+	bool bAVX2    = false;
+	bool bAVX512F = false;
+};
+
+// Queried from CPUID once, on first use.
+const CPUFeatures& GetCPUFeatures();
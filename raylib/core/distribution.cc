@@ -0,0 +1,97 @@
+#include "distribution.h"
+#include "core/assertion.h"
+
+#include <algorithm>
+
+// -------------------------------
+// Distribution1D
+
+Distribution1D::Distribution1D(const float* values, int32 n)
+	: func(values, values + n)
+{
+	CHECK(n > 0);
+
+	cdf.resize(n + 1);
+	cdf[0] = 0.0f;
+	for (int32 i = 1; i <= n; ++i)
+	{
+		cdf[i] = cdf[i - 1] + func[i - 1] / (float)n;
+	}
+
+	funcInt = cdf[n];
+	if (funcInt == 0.0f)
+	{
+		// Fall back to uniform.
+		for (int32 i = 1; i <= n; ++i)
+		{
+			cdf[i] = (float)i / (float)n;
+		}
+	}
+	else
+	{
+		for (int32 i = 1; i <= n; ++i)
+		{
+			cdf[i] /= funcInt;
+		}
+	}
+}
+
+float Distribution1D::SampleContinuous(float u, float& outPdf, int32& outOffset) const
+{
+	// Last entry whose cdf <= u
+	auto it = std::upper_bound(cdf.begin(), cdf.end(), u);
+	int32 offset = (int32)(it - cdf.begin()) - 1;
+	offset = std::max(0, std::min(Count() - 1, offset));
+	outOffset = offset;
+
+	float du = u - cdf[offset];
+	if (cdf[offset + 1] - cdf[offset] > 0.0f)
+	{
+		du /= (cdf[offset + 1] - cdf[offset]);
+	}
+
+	outPdf = (funcInt > 0.0f) ? (func[offset] / funcInt) : 1.0f;
+
+	float x = ((float)offset + du) / (float)Count();
+	return std::min(x, 0.99999994f);
+}
+
+float Distribution1D::Pdf(float x) const
+{
+	int32 offset = std::max(0, std::min(Count() - 1, (int32)(x * Count())));
+	return (funcInt > 0.0f) ? (func[offset] / funcInt) : 1.0f;
+}
+
+// -------------------------------
+// Distribution2D
+
+Distribution2D::Distribution2D(const float* values, int32 nu, int32 nv)
+{
+	conditional.reserve(nv);
+	for (int32 v = 0; v < nv; ++v)
+	{
+		conditional.emplace_back(values + v * nu, nu);
+	}
+	std::vector<float> marginalFunc(nv);
+	for (int32 v = 0; v < nv; ++v)
+	{
+		marginalFunc[v] = conditional[v].GetIntegral();
+	}
+	marginal = Distribution1D(marginalFunc.data(), nv);
+}
+
+void Distribution2D::SampleContinuous(float u0, float u1, float& outU, float& outV, float& outPdf) const
+{
+	float pdfs[2];
+	int32 row, column;
+	outV = marginal.SampleContinuous(u1, pdfs[1], row);
+	outU = conditional[row].SampleContinuous(u0, pdfs[0], column);
+	outPdf = pdfs[0] * pdfs[1];
+}
+
+float Distribution2D::Pdf(float u, float v) const
+{
+	int32 iu = std::max(0, std::min(conditional[0].Count() - 1, (int32)(u * conditional[0].Count())));
+	int32 iv = std::max(0, std::min(marginal.Count() - 1, (int32)(v * marginal.Count())));
+	return conditional[iv].func[iu] / marginal.GetIntegral();
+}
@@ -0,0 +1,53 @@
+// Piecewise-constant distributions for importance sampling tabulated functions.
+// Reference: pbrt-v3, 13.3.1 and 14.2.4
+
+#pragma once
+
+#include "core/int_types.h"
+
+#include <vector>
+
+class Distribution1D
+{
+
+public:
+	Distribution1D() {}
+	Distribution1D(const float* values, int32 n);
+
+	inline int32 Count() const { return (int32)func.size(); }
+	inline float GetIntegral() const { return funcInt; }
+
+	// Sample a point in [0, 1).
+	// outPdf is the density at the sample. outOffset is the index of the segment that contains it.
+	float SampleContinuous(float u, float& outPdf, int32& outOffset) const;
+
+	// Density at x in [0, 1).
+	float Pdf(float x) const;
+
+private:
+	std::vector<float> func;
+	std::vector<float> cdf; // Count() + 1 entries
+	float funcInt = 0.0f;
+
+	friend class Distribution2D;
+};
+
+// Defined over [0, 1)^2. values are in row-major order (nu columns, nv rows).
+class Distribution2D
+{
+
+public:
+	Distribution2D() {}
+	Distribution2D(const float* values, int32 nu, int32 nv);
+
+	inline bool IsValid() const { return marginal.Count() > 0 && marginal.GetIntegral() > 0.0f; }
+
+	// Sample (u, v) in [0, 1)^2. outPdf is the density with respect to (u, v).
+	void SampleContinuous(float u0, float u1, float& outU, float& outV, float& outPdf) const;
+
+	float Pdf(float u, float v) const;
+
+private:
+	std::vector<Distribution1D> conditional; // p(u | v)
+	Distribution1D marginal;                 // p(v)
+};
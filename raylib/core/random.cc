@@ -1,25 +1,21 @@
 #include "core/random.h"
 
+static thread_local PCG32 randoms;
+
 vec3 RandomInUnitSphere()
 {
-	static thread_local RNG randoms(4096);
-
 #if 0 // original impl. of the tutorial
 	vec3 p;
 	do
 	{
-		p = 2.0f * vec3(randoms.Peek(), randoms.Peek(), randoms.Peek()) - vec3(1.0f, 1.0f, 1.0f);
+		p = 2.0f * vec3(randoms.NextFloat(), randoms.NextFloat(), randoms.NextFloat()) - vec3(1.0f, 1.0f, 1.0f);
 	} while (p.LengthSquared() >= 1.0f);
 	return p;
 #endif
 
-	// PBR Ch. 13
-	float u1 = randoms.Peek();
-	float u2 = randoms.Peek();
-	float z = 1.0f - 2.0f * u1;
-	float r = sqrt(std::max(0.0f, 1.0f - z * z));
-	float phi = 2.0f * 3.141592f * u2;
-	return vec3(r * cos(phi), r * sin(phi), z);
+	float u1 = randoms.NextFloat();
+	float u2 = randoms.NextFloat();
+	return SampleUnitSphere(u1, u2);
 }
 
 vec3 RandomInHemisphere(const vec3& axis)
@@ -34,24 +30,41 @@ vec3 RandomInHemisphere(const vec3& axis)
 
 float Random()
 {
-	static thread_local RNG randoms(4096 * 8);
-
-	return randoms.Peek();
+	return randoms.NextFloat();
 }
 
 vec3 RandomInUnitDisk()
 {
-	static thread_local RNG randoms(4096 * 8);
-	float u1 = randoms.Peek();
-	float u2 = randoms.Peek();
+	float u1 = randoms.NextFloat();
+	float u2 = randoms.NextFloat();
+	return SampleUnitDisk(u1, u2);
+}
+
+vec3 RandomInCosineHemisphere() {
+	float u1 = Random();
+	float u2 = Random();
+	return SampleCosineHemisphere(u1, u2);
+}
+
+vec3 SampleUnitSphere(float u1, float u2)
+{
+	// PBR Ch. 13
+	float z = 1.0f - 2.0f * u1;
+	float r = sqrt(std::max(0.0f, 1.0f - z * z));
+	float phi = 2.0f * 3.141592f * u2;
+	return vec3(r * cos(phi), r * sin(phi), z);
+}
+
+vec3 SampleUnitDisk(float u1, float u2)
+{
 	float r = sqrt(u1);
 	float theta = 2.0f * (float)M_PI * u2;
 	return vec3(r * cos(theta), r * sin(theta), 0.0f);
 }
 
-vec3 RandomInCosineHemisphere() {
-	float u1 = 2.0f * Random() - 1.0f;
-	float u2 = 2.0f * Random() - 1.0f;
+vec3 SampleCosineHemisphere(float u1, float u2) {
+	u1 = 2.0f * u1 - 1.0f;
+	u2 = 2.0f * u2 - 1.0f;
 	// Concentric disk samples
 	{
 		float theta, r;
@@ -4,66 +4,88 @@
 #include "core/int_types.h"
 #include "core/vec3.h"
 
-#include <random>
-#include <vector>
 #include <algorithm>
 
-#define RESET_RNG_ON_STARVATION 1
+// Largest float below 1.0
+#define RANDOM_ONE_MINUS_EPSILON 0.99999994f
 
-class RNG
+#define PCG32_DEFAULT_STATE  0x853c49e6748fea9bULL
+#define PCG32_DEFAULT_STREAM 0xda3e39cb94b95bdbULL
+#define PCG32_MULT           0x5851f42d4c957f2dULL
+
+// Finalizer of MurmurHash3; a cheap 64-bit hash.
+inline uint64 MixBits(uint64 v)
+{
+	v ^= (v >> 31);
+	v *= 0x7fb5d329728ea185ULL;
+	v ^= (v >> 27);
+	v *= 0x81dadef4bc2dd44dULL;
+	v ^= (v >> 33);
+	return v;
+}
+
+// PCG32 random number generator (https://www.pcg-random.org).
+// 16 bytes of state; no tables and no system calls.
+// Any position of any sequence can be reached in O(log n) by Advance(),
+// so values can be addressed by (sequence, offset) like a counter-based generator.
+class PCG32
 {
 
 public:
-	RNG(uint32 nSamples)
-	{
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<> dist(0.0, 1.0);
+	PCG32() : state(PCG32_DEFAULT_STATE), inc(PCG32_DEFAULT_STREAM) {}
+	PCG32(uint64 sequenceIndex, uint64 seed) { SetSequence(sequenceIndex, seed); }
 
-		samples.resize(nSamples);
-		for(uint32 i = 0; i < nSamples; ++i)
-		{
-			samples[i] = (float)dist(gen);
-		}
-
-		Seek(0);
+	inline void SetSequence(uint64 sequenceIndex, uint64 seed)
+	{
+		state = 0u;
+		inc = (sequenceIndex << 1u) | 1u;
+		NextUint32();
+		state += seed;
+		NextUint32();
 	}
 
-	inline void Seek(int32 ix)
+	inline uint32 NextUint32()
 	{
-		index = ix;
+		uint64 oldState = state;
+		state = oldState * PCG32_MULT + inc;
+		uint32 xorShifted = (uint32)(((oldState >> 18u) ^ oldState) >> 27u);
+		uint32 rot = (uint32)(oldState >> 59u);
+		return (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31));
 	}
 
-	inline float Peek()
+	// Uniform in [0, 1)
+	inline float NextFloat()
 	{
-		float x = samples[index];
-
-		index = (index + 1) % samples.size();
+		return std::min((float)(NextUint32() >> 8) * (1.0f / 16777216.0f), RANDOM_ONE_MINUS_EPSILON);
+	}
 
-#if RESET_RNG_ON_STARVATION
-		if (index == 0)
+	// Skip delta values. Same as calling NextUint32() delta times.
+	inline void Advance(uint64 delta)
+	{
+		uint64 curMult = PCG32_MULT, curPlus = inc;
+		uint64 accMult = 1u, accPlus = 0u;
+		while (delta > 0)
 		{
-			std::mt19937 gen(rd());
-			std::uniform_real_distribution<> dist(0.0, 1.0);
-
-			uint32 nSamples = (uint32)samples.size();
-			for (uint32 i = 0; i < nSamples; ++i)
+			if (delta & 1)
 			{
-				samples[i] = (float)dist(gen);
+				accMult *= curMult;
+				accPlus = accPlus * curMult + curPlus;
 			}
+			curPlus = (curMult + 1) * curPlus;
+			curMult *= curMult;
+			delta /= 2;
 		}
-#endif
-
-		return x;
+		state = accMult * state + accPlus;
 	}
 
 private:
-	std::vector<float> samples;
-	std::random_device rd;
-
-	mutable int32 index;
+	uint64 state;
+	uint64 inc;
 
 };
 
+// White noise from a thread-local PCG32 with a fixed seed. Every thread starts the same sequence,
+// so results are reproducible, but don't use these for rendering; path tracing should use a Sampler.
 // #todo-raylib: Temp RAYLIB_API
 RAYLIB_API float Random();
 RAYLIB_API vec3 RandomInUnitSphere();
@@ -71,3 +93,9 @@ vec3 RandomInHemisphere(const vec3& axis);
 vec3 RandomInUnitDisk();
 // Cosine-weighted samples on a hemisphere around (0,0,1)
 vec3 RandomInCosineHemisphere();
+
+// Same distributions as above, but warped from given uniform values in [0, 1)
+// (e.g., from a Sampler) instead of drawing them from Random().
+vec3 SampleUnitSphere(float u1, float u2);
+vec3 SampleUnitDisk(float u1, float u2);
+vec3 SampleCosineHemisphere(float u1, float u2);
@@ -0,0 +1,132 @@
+#include "sampler.h"
+
+#include <algorithm>
+
+// Dimensions available to each sample of IndependentSampler before it overlaps the next sample.
+#define INDEPENDENT_SAMPLER_MAX_DIMENSIONS 65536
+
+// -------------------------------
+// Scrambling helpers
+
+static inline uint32 ReverseBits(uint32 x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// Bijective hash where each bit only depends on lower bits.
+static inline uint32 LaineKarrasPermutation(uint32 x, uint32 seed)
+{
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return x;
+}
+
+// Owen scrambling of a fixed point number in [0, 1).
+static inline uint32 NestedUniformScramble(uint32 x, uint32 seed)
+{
+	return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+}
+
+static inline uint32 HashCombine(uint32 seed, uint32 v)
+{
+	return seed ^ (v + (seed << 6) + (seed >> 2));
+}
+
+// lowbias32 by Chris Wellons
+static inline uint32 Hash(uint32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// First two dimensions of the Sobol sequence, as 0.32 fixed point.
+static inline uint32 Sobol0(uint32 index)
+{
+	return ReverseBits(index);
+}
+static inline uint32 Sobol1(uint32 index)
+{
+	uint32 x = 0;
+	for (uint32 v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+	{
+		if (index & 1) x ^= v;
+	}
+	return x;
+}
+
+static inline float FixedPointToFloat(uint32 x)
+{
+	return std::min((float)(x >> 8) * (1.0f / 16777216.0f), RANDOM_ONE_MINUS_EPSILON);
+}
+
+// -------------------------------
+// IndependentSampler
+
+void IndependentSampler::StartPixelSample(int32 x, int32 y, int32 sampleIndex, int32 dimension)
+{
+	uint64 pixelHash = MixBits(((uint64)(uint32)x << 32) | (uint64)(uint32)y);
+	rng.SetSequence(pixelHash, MixBits((uint64)seed));
+	rng.Advance((uint64)sampleIndex * INDEPENDENT_SAMPLER_MAX_DIMENSIONS + (uint64)dimension);
+	currentDimension = dimension;
+}
+
+void IndependentSampler::SetDimension(int32 dimension)
+{
+	// Wraps around for negative deltas, which is also a valid jump as the period is 2^64.
+	rng.Advance((uint64)((int64)dimension - (int64)currentDimension));
+	currentDimension = dimension;
+}
+
+float IndependentSampler::Get1D()
+{
+	currentDimension += 1;
+	return rng.NextFloat();
+}
+
+void IndependentSampler::Get2D(float& outU0, float& outU1)
+{
+	currentDimension += 2;
+	outU0 = rng.NextFloat();
+	outU1 = rng.NextFloat();
+}
+
+// -------------------------------
+// SobolSampler
+
+void SobolSampler::StartPixelSample(int32 x, int32 y, int32 sampleIndex, int32 dimension)
+{
+	pixelSeed = Hash(HashCombine(HashCombine(Hash((uint32)x), (uint32)y), seed));
+	currentSample = (uint32)sampleIndex;
+	currentDimension = dimension;
+}
+
+float SobolSampler::Get1D()
+{
+	uint32 seed = Hash(HashCombine(pixelSeed, (uint32)currentDimension));
+	currentDimension += 1;
+
+	uint32 index = NestedUniformScramble(currentSample, seed);
+	return FixedPointToFloat(NestedUniformScramble(Sobol0(index), Hash(seed)));
+}
+
+void SobolSampler::Get2D(float& outU0, float& outU1)
+{
+	uint32 seed = Hash(HashCombine(pixelSeed, (uint32)currentDimension));
+	currentDimension += 2;
+
+	// Shuffle the order of points, then scramble each dimension independently.
+	uint32 index = NestedUniformScramble(currentSample, seed);
+	outU0 = FixedPointToFloat(NestedUniformScramble(Sobol0(index), Hash(HashCombine(seed, 1))));
+	outU1 = FixedPointToFloat(NestedUniformScramble(Sobol1(index), Hash(HashCombine(seed, 2))));
+}
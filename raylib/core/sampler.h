@@ -0,0 +1,74 @@
+// Samplers provide the random numbers a path consumes.
+// Values are addressed by (pixel, sample index, dimension) so that the samples of a pixel
+// can be stratified against each other, which white noise (Random()) can't do.
+// They only depend on that address and the seed, so images are reproducible
+// regardless of thread count or the order in which tiles are rendered.
+//
+// Usage:
+//   sampler.StartPixelSample(x, y, sampleIndex);
+//   float u = sampler.Get1D();          // dimension 0
+//   sampler.Get2D(u0, u1);              // dimensions 1, 2
+//   sampler.SetDimension(firstDim);     // realign, e.g., at the start of each bounce
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/random.h"
+
+class Sampler
+{
+
+public:
+	virtual ~Sampler() {}
+
+	// Different seeds give different (but equally distributed) values. Takes effect from the next StartPixelSample().
+	inline void SetSeed(uint32 inSeed) { seed = inSeed; }
+
+	// Begin the sampleIndex-th sample of the pixel (x, y) from the given dimension.
+	virtual void StartPixelSample(int32 x, int32 y, int32 sampleIndex, int32 dimension = 0) = 0;
+	virtual void SetDimension(int32 dimension) = 0;
+
+	// Values are in [0, 1). Each call consumes one (Get1D) or two (Get2D) dimensions.
+	virtual float Get1D() = 0;
+	virtual void Get2D(float& outU0, float& outU1) = 0;
+
+protected:
+	uint32 seed = 0;
+};
+
+// White noise; every value is independent of the others.
+// Each pixel has its own PCG32 sequence and each (sample, dimension) is an offset in it.
+class IndependentSampler : public Sampler
+{
+
+public:
+	virtual void StartPixelSample(int32 x, int32 y, int32 sampleIndex, int32 dimension = 0) override;
+	virtual void SetDimension(int32 dimension) override;
+	virtual float Get1D() override;
+	virtual void Get2D(float& outU0, float& outU1) override;
+
+private:
+	PCG32 rng;
+	int32 currentDimension = 0;
+};
+
+// Owen-scrambled Sobol points. Get2D() draws from the first two Sobol dimensions,
+// which are well stratified as a pair, and every dimension gets its own
+// index shuffle and scramble seeded by the pixel, so dimensions and pixels are decorrelated.
+// Reference: Burley, "Practical Hash-based Owen Scrambling" (JCGT 2020)
+//
+// Stratification is best when samples per pixel is a power of two.
+class SobolSampler : public Sampler
+{
+
+public:
+	virtual void StartPixelSample(int32 x, int32 y, int32 sampleIndex, int32 dimension = 0) override;
+	virtual void SetDimension(int32 dimension) override { currentDimension = dimension; }
+	virtual float Get1D() override;
+	virtual void Get2D(float& outU0, float& outU1) override;
+
+private:
+	uint32 pixelSeed = 0;
+	uint32 currentSample = 0;
+	int32 currentDimension = 0;
+};
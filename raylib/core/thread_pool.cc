@@ -1,4 +1,5 @@
 #include "thread_pool.h"
+#include "cpu_affinity.h"
 #include <assert.h>
 
 static void* pooledThreadMain(void* _param)
@@ -9,6 +10,12 @@ static void* pooledThreadMain(void* _param)
 
 	//log("Thread %d started to work", threadID);
 
+	// Before any work, so that per-thread scratch memory is first touched on the local NUMA node.
+	if(pool->bPinThreads)
+	{
+		PinCurrentThreadToCore(pool->pinSlotOffset + (uint32)threadID);
+	}
+
 	bool hasWork = true;
 
 	while(hasWork)
@@ -27,22 +34,27 @@ static void* pooledThreadMain(void* _param)
 	}
 
 	//log("Thread %d has finished", threadID);
-	param->done = true;
 
 	return 0;
 }
 
 ThreadPool::ThreadPool()
 	: queueIx(-1)
+	, bPinThreads(false)
+	, pinSlotOffset(0)
 {
 }
 
 ThreadPool::~ThreadPool()
 {
+	Join();
 }
 
-void ThreadPool::Initialize(int32 numWorkerThreads)
+void ThreadPool::Initialize(int32 numWorkerThreads, bool inPinThreads, uint32 inPinSlotOffset)
 {
+	bPinThreads = inPinThreads;
+	pinSlotOffset = inPinSlotOffset;
+
 	threads.resize(numWorkerThreads);
 	threadParams.resize(numWorkerThreads);
 
@@ -67,27 +79,24 @@ void ThreadPool::Start(bool blocking)
 	for(int32 i=0; i<n; ++i)
 	{
 		threads[i] = std::thread(pooledThreadMain, (void*)&threadParams[i]);
-		threads[i].detach();
 		threadParams[i].started = true;
 	}
 
 	if(blocking)
 	{
-		for(int32 i=0; i<n; ++i)
-		{
-			threads[i].join();
-		}
+		Join();
 	}
 }
 
-bool ThreadPool::IsDone() const
+void ThreadPool::Join()
 {
-	bool done = true;
-	for(auto i=0u; i<threadParams.size(); ++i)
+	for(auto i=0u; i<threads.size(); ++i)
 	{
-		done = done && threadParams[i].done;
+		if(threads[i].joinable())
+		{
+			threads[i].join();
+		}
 	}
-	return done;
 }
 
 bool ThreadPool::PopWork(ThreadPoolWork& work)
@@ -28,14 +28,12 @@ struct PooledThreadParam
 		: threadID(-1)
 		, pool(nullptr)
 		, started(false)
-		, done(false)
 	{
 	}
 
 	int32             threadID;
 	ThreadPool*       pool;
 	bool              started;
-	bool              done;
 };
 
 // Passed to the WorkItemRoutine as a sole parameter
@@ -53,13 +51,16 @@ public:
 	RAYLIB_API ThreadPool();
 	RAYLIB_API ~ThreadPool();
 
-	RAYLIB_API void Initialize(int32 numWorkerThreads);
+	// @param bPinThreads Pin each worker thread to its own core. See PinCurrentThreadToCore().
+	// @param pinSlotOffset Core slot of the first worker thread if pinned.
+	RAYLIB_API void Initialize(int32 numWorkerThreads, bool bPinThreads = false, uint32 pinSlotOffset = 0);
 
 	// Do not add any work after Start()
 	RAYLIB_API void AddWork(const ThreadPoolWork& workItem);
 
 	RAYLIB_API void Start(bool blocking);
-	RAYLIB_API bool IsDone() const;
+	// Wait for all worker threads to exit. Also called by the destructor.
+	RAYLIB_API void Join();
 
 	// Returns false if no work
 	RAYLIB_API bool PopWork(ThreadPoolWork& work);
@@ -76,4 +77,6 @@ public:
 	std::vector<ThreadPoolWork>              queue;
 	std::mutex                               queueLock;
 	int32                                    queueIx;
+	bool                                     bPinThreads;
+	uint32                                   pinSlotOffset;
 };
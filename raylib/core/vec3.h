@@ -165,6 +165,11 @@ inline vec3 saturate(const vec3& v) {
 	return max(vec3(0.0f), min(1.0f, v));
 }
 
+// Relative luminance of linear RGB (Rec. 709)
+inline float luminance(const vec3& v) {
+	return dot(v, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
 inline bool isnan(const vec3& v) {
 	return isnan(v.x) || isnan(v.y) || isnan(v.z);
 }
@@ -0,0 +1,186 @@
+// 4-wide SSE vector and 4x4 matrix.
+// Same operator surface as vec3, but every operation runs on all 4 lanes at once.
+// Lanes are stored in an __m128, so vec4 must be 16-byte aligned.
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/assertion.h"
+#include "core/vec3.h"
+
+#include <xmmintrin.h>
+
+struct alignas(16) vec4
+{
+	__m128 m;
+
+	vec4() : m(_mm_setzero_ps()) {}
+	explicit vec4(__m128 v) : m(v) {}
+	vec4(float e0) : m(_mm_set1_ps(e0)) {}
+	vec4(float e0, float e1, float e2, float e3) : m(_mm_setr_ps(e0, e1, e2, e3)) {}
+	explicit vec4(const vec3& v, float w = 0.0f) : m(_mm_setr_ps(v.x, v.y, v.z, w)) {}
+
+	// Loads 4 floats from 16-byte aligned memory.
+	static inline vec4 Load(const float* ptr) { return vec4(_mm_load_ps(ptr)); }
+	static inline vec4 LoadUnaligned(const float* ptr) { return vec4(_mm_loadu_ps(ptr)); }
+	inline void Store(float* ptr) const { _mm_store_ps(ptr, m); }
+	inline void StoreUnaligned(float* ptr) const { _mm_storeu_ps(ptr, m); }
+
+	inline float x() const { return _mm_cvtss_f32(m); }
+	inline float y() const { return _mm_cvtss_f32(_mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))); }
+	inline float z() const { return _mm_cvtss_f32(_mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2))); }
+	inline float w() const { return _mm_cvtss_f32(_mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))); }
+	inline vec3 xyz() const {
+		alignas(16) float e[4];
+		Store(e);
+		return vec3(e[0], e[1], e[2]);
+	}
+
+	inline const vec4& operator+() const { return *this; }
+	inline vec4 operator-() const { return vec4(_mm_xor_ps(m, _mm_set1_ps(-0.0f))); }
+
+	inline vec4& operator+=(const vec4& v2) { m = _mm_add_ps(m, v2.m); return *this; }
+	inline vec4& operator-=(const vec4& v2) { m = _mm_sub_ps(m, v2.m); return *this; }
+	inline vec4& operator*=(const vec4& v2) { m = _mm_mul_ps(m, v2.m); return *this; }
+	inline vec4& operator/=(const vec4& v2) { m = _mm_div_ps(m, v2.m); return *this; }
+	inline vec4& operator+=(const float t) { m = _mm_add_ps(m, _mm_set1_ps(t)); return *this; }
+	inline vec4& operator-=(const float t) { m = _mm_sub_ps(m, _mm_set1_ps(t)); return *this; }
+	inline vec4& operator*=(const float t) { m = _mm_mul_ps(m, _mm_set1_ps(t)); return *this; }
+	// Multiplies by the reciprocal, like vec3.
+	inline vec4& operator/=(const float t) { m = _mm_mul_ps(m, _mm_set1_ps(1.0f / t)); return *this; }
+
+	inline float operator[](int32 ix) const {
+		CHECK(0 <= ix && ix < 4);
+		alignas(16) float e[4];
+		Store(e);
+		return e[ix];
+	}
+};
+
+inline vec4 operator+(const vec4& v1, const vec4& v2) { return vec4(_mm_add_ps(v1.m, v2.m)); }
+inline vec4 operator-(const vec4& v1, const vec4& v2) { return vec4(_mm_sub_ps(v1.m, v2.m)); }
+inline vec4 operator*(const vec4& v1, const vec4& v2) { return vec4(_mm_mul_ps(v1.m, v2.m)); }
+inline vec4 operator/(const vec4& v1, const vec4& v2) { return vec4(_mm_div_ps(v1.m, v2.m)); }
+
+inline vec4 operator+(const vec4& v1, float t) { return vec4(_mm_add_ps(v1.m, _mm_set1_ps(t))); }
+inline vec4 operator+(float t, const vec4& v1) { return vec4(_mm_add_ps(_mm_set1_ps(t), v1.m)); }
+inline vec4 operator-(const vec4& v1, float t) { return vec4(_mm_sub_ps(v1.m, _mm_set1_ps(t))); }
+inline vec4 operator-(float t, const vec4& v1) { return vec4(_mm_sub_ps(_mm_set1_ps(t), v1.m)); }
+inline vec4 operator*(const vec4& v1, float t) { return vec4(_mm_mul_ps(v1.m, _mm_set1_ps(t))); }
+inline vec4 operator*(float t, const vec4& v1) { return vec4(_mm_mul_ps(_mm_set1_ps(t), v1.m)); }
+inline vec4 operator/(const vec4& v1, float t) { return vec4(_mm_div_ps(v1.m, _mm_set1_ps(t))); }
+inline vec4 operator/(float t, const vec4& v1) { return vec4(_mm_div_ps(_mm_set1_ps(t), v1.m)); }
+
+// Comparisons return lane masks (all bits set where true) for select() and MoveMask().
+inline vec4 operator<(const vec4& v1, const vec4& v2) { return vec4(_mm_cmplt_ps(v1.m, v2.m)); }
+inline vec4 operator<=(const vec4& v1, const vec4& v2) { return vec4(_mm_cmple_ps(v1.m, v2.m)); }
+inline vec4 operator>(const vec4& v1, const vec4& v2) { return vec4(_mm_cmpgt_ps(v1.m, v2.m)); }
+inline vec4 operator>=(const vec4& v1, const vec4& v2) { return vec4(_mm_cmpge_ps(v1.m, v2.m)); }
+inline vec4 operator&(const vec4& v1, const vec4& v2) { return vec4(_mm_and_ps(v1.m, v2.m)); }
+inline vec4 operator|(const vec4& v1, const vec4& v2) { return vec4(_mm_or_ps(v1.m, v2.m)); }
+
+// Bit i is set if lane i of the mask is true.
+inline int32 MoveMask(const vec4& mask) { return _mm_movemask_ps(mask.m); }
+
+// Lanes of a where mask is true, otherwise lanes of b.
+inline vec4 select(const vec4& mask, const vec4& a, const vec4& b) {
+	return vec4(_mm_or_ps(_mm_and_ps(mask.m, a.m), _mm_andnot_ps(mask.m, b.m)));
+}
+
+// NOTE: Like MINPS/MAXPS, returns v2 if either lane is NaN.
+inline vec4 min(const vec4& v1, const vec4& v2) { return vec4(_mm_min_ps(v1.m, v2.m)); }
+inline vec4 max(const vec4& v1, const vec4& v2) { return vec4(_mm_max_ps(v1.m, v2.m)); }
+inline vec4 abs(const vec4& v) { return vec4(_mm_andnot_ps(_mm_set1_ps(-0.0f), v.m)); }
+inline vec4 sqrt(const vec4& v) { return vec4(_mm_sqrt_ps(v.m)); }
+inline vec4 saturate(const vec4& v) { return max(vec4(0.0f), min(vec4(1.0f), v)); }
+inline vec4 mix(const vec4& v1, const vec4& v2, float a) { return (1.0f - a) * v1 + a * v2; }
+
+// Horizontal reductions over x, y, z. w is ignored.
+inline float hmin3(const vec4& v) {
+	__m128 m = _mm_min_ss(v.m, _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+inline float hmax3(const vec4& v) {
+	__m128 m = _mm_max_ss(v.m, _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+
+// Sums in the same order as dot(vec3, vec3), so the results are identical.
+inline float dot3(const vec4& v1, const vec4& v2) {
+	__m128 m = _mm_mul_ps(v1.m, v2.m);
+	__m128 s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+inline float dot(const vec4& v1, const vec4& v2) {
+	__m128 m = _mm_mul_ps(v1.m, v2.m);
+	__m128 s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+	s = _mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+	return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))));
+}
+
+// Cross product of xyz. w of the result is 0.
+inline vec4 cross3(const vec4& v1, const vec4& v2) {
+	__m128 a_yzx = _mm_shuffle_ps(v1.m, v1.m, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(v2.m, v2.m, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(v1.m, b_yzx), _mm_mul_ps(a_yzx, v2.m));
+	return vec4(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+inline vec4 normalize3(const vec4& v) {
+	return v * (1.0f / sqrtf(dot3(v, v)));
+}
+
+// -------------------------------
+// mat4
+
+// Column-major 4x4 matrix. M * v = cols[0] * v.x + cols[1] * v.y + cols[2] * v.z + cols[3] * v.w
+struct alignas(16) mat4
+{
+	vec4 cols[4];
+
+	mat4() : mat4(vec4(1.0f, 0.0f, 0.0f, 0.0f), vec4(0.0f, 1.0f, 0.0f, 0.0f), vec4(0.0f, 0.0f, 1.0f, 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f)) {}
+	mat4(const vec4& c0, const vec4& c1, const vec4& c2, const vec4& c3) {
+		cols[0] = c0;
+		cols[1] = c1;
+		cols[2] = c2;
+		cols[3] = c3;
+	}
+
+	static inline mat4 Identity() { return mat4(); }
+	// Rows given as vec3s; no translation.
+	static inline mat4 FromRows(const vec3& r0, const vec3& r1, const vec3& r2) {
+		return mat4(
+			vec4(r0.x, r1.x, r2.x, 0.0f),
+			vec4(r0.y, r1.y, r2.y, 0.0f),
+			vec4(r0.z, r1.z, r2.z, 0.0f),
+			vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	inline mat4 Transpose() const {
+		__m128 c0 = cols[0].m, c1 = cols[1].m, c2 = cols[2].m, c3 = cols[3].m;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		return mat4(vec4(c0), vec4(c1), vec4(c2), vec4(c3));
+	}
+
+	// Ignores translation.
+	inline vec3 TransformVector(const vec3& v) const {
+		vec4 r = cols[0] * v.x + cols[1] * v.y + cols[2] * v.z;
+		return r.xyz();
+	}
+	inline vec3 TransformPoint(const vec3& p) const {
+		vec4 r = cols[0] * p.x + cols[1] * p.y + cols[2] * p.z + cols[3];
+		return r.xyz();
+	}
+};
+
+inline vec4 operator*(const mat4& M, const vec4& v) {
+	__m128 x = _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 y = _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 z = _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 w = _mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(3, 3, 3, 3));
+	return M.cols[0] * vec4(x) + M.cols[1] * vec4(y) + M.cols[2] * vec4(z) + M.cols[3] * vec4(w);
+}
+
+inline mat4 operator*(const mat4& A, const mat4& B) {
+	return mat4(A * B.cols[0], A * B.cols[1], A * B.cols[2], A * B.cols[3]);
+}
@@ -0,0 +1,121 @@
+// 8-wide float vector for processing 8 rays (lanes) at once.
+// Uses AVX if the compiler targets it (/arch:AVX or -mavx), otherwise a pair of SSE registers.
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/vec4.h"
+
+#if defined(__AVX__)
+	#define VEC8_USE_AVX 1
+	#include <immintrin.h>
+#else
+	#define VEC8_USE_AVX 0
+#endif
+
+struct alignas(32) vec8
+{
+#if VEC8_USE_AVX
+	__m256 m;
+
+	vec8() : m(_mm256_setzero_ps()) {}
+	explicit vec8(__m256 v) : m(v) {}
+	vec8(float e0) : m(_mm256_set1_ps(e0)) {}
+	vec8(const vec4& lo, const vec4& hi) : m(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.m), hi.m, 1)) {}
+
+	static inline vec8 Load(const float* ptr) { return vec8(_mm256_load_ps(ptr)); }
+	inline void Store(float* ptr) const { _mm256_store_ps(ptr, m); }
+
+	inline vec4 Low() const { return vec4(_mm256_castps256_ps128(m)); }
+	inline vec4 High() const { return vec4(_mm256_extractf128_ps(m, 1)); }
+#else
+	vec4 lo;
+	vec4 hi;
+
+	vec8() {}
+	vec8(float e0) : lo(e0), hi(e0) {}
+	vec8(const vec4& inLo, const vec4& inHi) : lo(inLo), hi(inHi) {}
+
+	// ptr should be 32-byte aligned, same as AVX.
+	static inline vec8 Load(const float* ptr) { return vec8(vec4::Load(ptr), vec4::Load(ptr + 4)); }
+	inline void Store(float* ptr) const { lo.Store(ptr); hi.Store(ptr + 4); }
+
+	inline vec4 Low() const { return lo; }
+	inline vec4 High() const { return hi; }
+#endif
+
+	inline vec8& operator+=(const vec8& v2);
+	inline vec8& operator-=(const vec8& v2);
+	inline vec8& operator*=(const vec8& v2);
+	inline vec8& operator/=(const vec8& v2);
+
+	inline float operator[](int32 ix) const {
+		CHECK(0 <= ix && ix < 8);
+		alignas(32) float e[8];
+		Store(e);
+		return e[ix];
+	}
+};
+
+#if VEC8_USE_AVX
+	#define VEC8_BINARY_OP(func, avxOp, sseOp) \
+		inline vec8 func(const vec8& v1, const vec8& v2) { return vec8(avxOp(v1.m, v2.m)); }
+#else
+	#define VEC8_BINARY_OP(func, avxOp, sseOp) \
+		inline vec8 func(const vec8& v1, const vec8& v2) { return vec8(sseOp(v1.lo, v2.lo), sseOp(v1.hi, v2.hi)); }
+#endif
+
+VEC8_BINARY_OP(operator+, _mm256_add_ps, operator+)
+VEC8_BINARY_OP(operator-, _mm256_sub_ps, operator-)
+VEC8_BINARY_OP(operator*, _mm256_mul_ps, operator*)
+VEC8_BINARY_OP(operator/, _mm256_div_ps, operator/)
+VEC8_BINARY_OP(operator&, _mm256_and_ps, operator&)
+VEC8_BINARY_OP(operator|, _mm256_or_ps, operator|)
+// NOTE: Like MINPS/MAXPS, returns v2 if either lane is NaN.
+VEC8_BINARY_OP(min, _mm256_min_ps, min)
+VEC8_BINARY_OP(max, _mm256_max_ps, max)
+
+#undef VEC8_BINARY_OP
+
+inline vec8 operator+(const vec8& v1, float t) { return v1 + vec8(t); }
+inline vec8 operator-(const vec8& v1, float t) { return v1 - vec8(t); }
+inline vec8 operator-(float t, const vec8& v1) { return vec8(t) - v1; }
+inline vec8 operator*(const vec8& v1, float t) { return v1 * vec8(t); }
+inline vec8 operator*(float t, const vec8& v1) { return vec8(t) * v1; }
+inline vec8 operator/(const vec8& v1, float t) { return v1 / vec8(t); }
+
+inline vec8& vec8::operator+=(const vec8& v2) { *this = *this + v2; return *this; }
+inline vec8& vec8::operator-=(const vec8& v2) { *this = *this - v2; return *this; }
+inline vec8& vec8::operator*=(const vec8& v2) { *this = *this * v2; return *this; }
+inline vec8& vec8::operator/=(const vec8& v2) { *this = *this / v2; return *this; }
+
+// Comparisons return lane masks (all bits set where true) for select() and MoveMask().
+#if VEC8_USE_AVX
+inline vec8 operator<(const vec8& v1, const vec8& v2) { return vec8(_mm256_cmp_ps(v1.m, v2.m, _CMP_LT_OQ)); }
+inline vec8 operator<=(const vec8& v1, const vec8& v2) { return vec8(_mm256_cmp_ps(v1.m, v2.m, _CMP_LE_OQ)); }
+inline vec8 operator>(const vec8& v1, const vec8& v2) { return vec8(_mm256_cmp_ps(v1.m, v2.m, _CMP_GT_OQ)); }
+inline vec8 operator>=(const vec8& v1, const vec8& v2) { return vec8(_mm256_cmp_ps(v1.m, v2.m, _CMP_GE_OQ)); }
+inline int32 MoveMask(const vec8& mask) { return _mm256_movemask_ps(mask.m); }
+inline vec8 select(const vec8& mask, const vec8& a, const vec8& b) { return vec8(_mm256_blendv_ps(b.m, a.m, mask.m)); }
+inline vec8 sqrt(const vec8& v) { return vec8(_mm256_sqrt_ps(v.m)); }
+#else
+inline vec8 operator<(const vec8& v1, const vec8& v2) { return vec8(v1.lo < v2.lo, v1.hi < v2.hi); }
+inline vec8 operator<=(const vec8& v1, const vec8& v2) { return vec8(v1.lo <= v2.lo, v1.hi <= v2.hi); }
+inline vec8 operator>(const vec8& v1, const vec8& v2) { return vec8(v1.lo > v2.lo, v1.hi > v2.hi); }
+inline vec8 operator>=(const vec8& v1, const vec8& v2) { return vec8(v1.lo >= v2.lo, v1.hi >= v2.hi); }
+inline int32 MoveMask(const vec8& mask) { return MoveMask(mask.lo) | (MoveMask(mask.hi) << 4); }
+inline vec8 select(const vec8& mask, const vec8& a, const vec8& b) { return vec8(select(mask.lo, a.lo, b.lo), select(mask.hi, a.hi, b.hi)); }
+inline vec8 sqrt(const vec8& v) { return vec8(sqrt(v.lo), sqrt(v.hi)); }
+#endif
+
+// Horizontal reductions over all 8 lanes.
+inline float hmin(const vec8& v) {
+	vec4 m = min(v.Low(), v.High());
+	m = min(m, vec4(_mm_movehl_ps(m.m, m.m)));
+	return _mm_cvtss_f32(_mm_min_ss(m.m, _mm_shuffle_ps(m.m, m.m, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+inline float hmax(const vec8& v) {
+	vec4 m = max(v.Low(), v.High());
+	m = max(m, vec4(_mm_movehl_ps(m.m, m.m)));
+	return _mm_cvtss_f32(_mm_max_ss(m.m, _mm_shuffle_ps(m.m, m.m, _MM_SHUFFLE(1, 1, 1, 1))));
+}
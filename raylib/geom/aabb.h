@@ -1,4 +1,7 @@
+#pragma once
+
 #include "core/vec3.h"
+#include "core/vec4.h"
 #include "geom/ray.h"
 
 class AABB
@@ -37,20 +40,19 @@ public:
 
 		return false;
 #else
-		// Ray Tracing in The Next Week
-		for (int32 a = 0; a < 3; ++a)
-		{
-			float invD = 1.0f / r.d[a];
-			float t0 = (minBounds[a] - r.o[a]) * invD;
-			float t1 = (maxBounds[a] - r.o[a]) * invD;
-			if (invD < 0.0f) std::swap(t0, t1);
-			tMin = t0 > tMin ? t0 : tMin;
-			tMax = t1 < tMax ? t1 : tMax;
-			// #todo: 2D AABB can't pass this test (tMax == tMin)
-			//if (tMax <= tMin) return false;
-			if (tMax < tMin) return false;
-		}
-		return true;
+		// Ray Tracing in The Next Week, all axes at once.
+		// Same result as the per-axis loop: tMin only grows and tMax only shrinks.
+		const vec4 O(r.o);
+		const vec4 invD = 1.0f / vec4(r.d, 1.0f);
+		const vec4 t0 = (vec4(minBounds) - O) * invD;
+		const vec4 t1 = (vec4(maxBounds) - O) * invD;
+		const vec4 bSwap = invD < vec4(0.0f);
+		// max()/min() keep tMin/tMax for NaN lanes, like the ternaries of the scalar version.
+		const vec4 tNear = max(select(bSwap, t1, t0), vec4(tMin));
+		const vec4 tFar = min(select(bSwap, t0, t1), vec4(tMax));
+		// #todo: 2D AABB can't pass this test (tMax == tMin)
+		//return hmax3(tNear) < hmin3(tFar);
+		return !(hmin3(tFar) < hmax3(tNear));
 #endif
 	}
 
@@ -1,4 +1,5 @@
 #include "bvh.h"
+#include "ray_packet.h"
 #include "core/random.h"
 #include <algorithm>
 
@@ -79,31 +80,34 @@ BVHNode::BVHNode(Hitable** list, int32 n, float t0, float t1)
 	box = leftBox + rightBox;
 }
 
-bool BVHNode::Hit(const ray& r, float tMin, float tMax, HitResult& outResult) const
+bool BVHNode::Intersect(const ray& r, float tMin, float tMax, TraversalHit& outHit) const
 {
-	if (box.Hit(r, tMin, tMax))
+	if (!box.Hit(r, tMin, tMax))
 	{
-		HitResult leftResult, rightResult;
-		bool leftHit = left->Hit(r, tMin, tMax, leftResult);
-		// NOTE: Skip right if same node
-		bool rightHit = (left == right) ? false : right->Hit(r, tMin, tMax, rightResult);
-		if (leftHit && rightHit)
-		{
-			outResult = (leftResult.t < rightResult.t) ? leftResult : rightResult;
-			return true;
-		}
-		else if (leftHit)
-		{
-			outResult = leftResult;
-			return true;
-		}
-		else if (rightHit)
-		{
-			outResult = rightResult;
-			return true;
-		}
+		return false;
+	}
+	// Right child only needs to beat the hit of left child.
+	bool bHit = left->Intersect(r, tMin, tMax, outHit);
+	// NOTE: Skip right if same node
+	if (left != right && right->Intersect(r, tMin, bHit ? outHit.t : tMax, outHit))
+	{
+		bHit = true;
+	}
+	return bHit;
+}
+
+void BVHNode::HitPacket(RayPacket& packet, float tMin, TraversalHit* outHits) const
+{
+	if (packet.FrustumCullBox(box) || !packet.HitBox(box, tMin))
+	{
+		return;
+	}
+	left->HitPacket(packet, tMin, outHits);
+	// NOTE: Skip right if same node
+	if (left != right)
+	{
+		right->HitPacket(packet, tMin, outHits);
 	}
-	return false;
 }
 
 bool BVHNode::BoundingBox(float t0, float t1, AABB& outBox) const
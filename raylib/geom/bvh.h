@@ -9,7 +9,9 @@ class BVHNode : public Hitable
 public:
 	RAYLIB_API BVHNode(HitableList* list, float t0, float t1);
 
-	RAYLIB_API virtual bool Hit(const ray& r, float tMin, float tMax, HitResult& outResult) const override;
+	RAYLIB_API virtual bool Intersect(const ray& r, float tMin, float tMax, TraversalHit& outHit) const override;
+
+	RAYLIB_API virtual void HitPacket(RayPacket& packet, float tMin, TraversalHit* outHits) const override;
 
 	RAYLIB_API virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override;
 
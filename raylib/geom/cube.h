@@ -29,10 +29,21 @@ public:
 
 	Cube() : Cube(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f), 0.0f, vec3(0.0f, 0.0f, 0.0f), nullptr) {}
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const;
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const override;
+	RAYLIB_API virtual void ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const override;
 
 	RAYLIB_API virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override;
 
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const override
+	{
+		outMaterials.push_back(material);
+	}
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) override;
+
+private:
+	// Ray times of the 6 slab planes in t[1..6], entry and exit in t[7] and t[8].
+	void IntersectSlabs(const ray& r, float t[9]) const;
+
 public:
 	vec3 minBounds;
 	vec3 maxBounds;
@@ -1,4 +1,6 @@
 #include "hit.h"
+#include "ray_packet.h"
+#include "render/material.h"
 
 // -------------------------------
 // HitResult
@@ -17,6 +19,10 @@ void HitResult::BuildOrthonormalBasis() {
 	CalcOrthonormalBasis(n, tangent, bitangent);
 }
 
+void HitResult::EvaluateBSDF() {
+	material->EvaluateBSDF(*this, bsdf);
+}
+
 vec3 HitResult::LocalToWorld(const vec3& v) const {
 	float wx = dot(vec3(tangent.x, bitangent.x, n.x), v);
 	float wy = dot(vec3(tangent.y, bitangent.y, n.y), v);
@@ -28,23 +34,118 @@ vec3 HitResult::WorldToLocal(const vec3& v) const {
 	return vec3(dot(v, tangent), dot(v, bitangent), dot(v, n));
 }
 
+// -------------------------------
+// Hitable
+
+bool Hitable::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const
+{
+	TraversalHit hit;
+	if (!Intersect(r, t_min, t_max, hit))
+	{
+		return false;
+	}
+	hit.object->ComputeSurfaceInteraction(r, hit, outResult);
+	return true;
+}
+
+void Hitable::HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const
+{
+	for (int32 i = 0; i < packet.numRays; ++i)
+	{
+		if (Intersect(packet.GetRay(i), t_min, packet.tMax[i], outHits[i]))
+		{
+			packet.tMax[i] = outHits[i].t;
+			packet.hit[i] = true;
+		}
+	}
+}
+
+bool Hitable::SampleSurfaceFrom(const vec3& refPoint, float u0, float u1, HitResult& outSample, float& outPdf) const
+{
+	if (!SampleSurface(u0, u1, outSample))
+	{
+		return false;
+	}
+	outPdf = SurfacePdfFrom(refPoint, outSample);
+	return outPdf > 0.0f;
+}
+
+float Hitable::SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const
+{
+	// Convert area measure to solid angle measure.
+	float area = GetSurfaceArea();
+	vec3 toSurface = surfacePoint.p - refPoint;
+	float distanceSq = toSurface.LengthSquared();
+	if (area <= 0.0f || distanceSq <= 0.0f)
+	{
+		return 0.0f;
+	}
+	float cosTheta = absDot(surfacePoint.n, toSurface) / sqrtf(distanceSq);
+	if (cosTheta <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return distanceSq / (cosTheta * area);
+}
+
 // -------------------------------
 // HitableList
 
-bool HitableList::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const
+bool HitableList::Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const
 {
-	HitResult temp;
 	bool anyHit = false;
 	float closest = t_max;
 	int32 n = (int32)hitables.size();
 	for (int32 i = 0; i < n; ++i)
 	{
-		if (hitables[i]->Hit(r, t_min, closest, temp))
+		if (hitables[i]->Intersect(r, t_min, closest, outHit))
 		{
 			anyHit = true;
-			closest = temp.t;
-			outResult = temp;
+			closest = outHit.t;
 		}
 	}
 	return anyHit;
 }
+
+void HitableList::HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const
+{
+	// packet.tMax keeps the closest hit among all hitables.
+	int32 n = (int32)hitables.size();
+	for (int32 i = 0; i < n; ++i)
+	{
+		hitables[i]->HitPacket(packet, t_min, outHits);
+	}
+}
+
+void HitableList::GatherEmitters(std::vector<const Hitable*>& outEmitters) const
+{
+	for (const Hitable* hitable : hitables)
+	{
+		hitable->GatherEmitters(outEmitters);
+	}
+}
+
+void HitableList::SetObjectID(uint32 inObjectID)
+{
+	objectID = inObjectID;
+	for (Hitable* hitable : hitables)
+	{
+		hitable->SetObjectID(inObjectID);
+	}
+}
+
+void HitableList::GatherMaterials(std::vector<const Material*>& outMaterials) const
+{
+	for (const Hitable* hitable : hitables)
+	{
+		hitable->GatherMaterials(outMaterials);
+	}
+}
+
+void HitableList::AssignMaterialIDs(const Scene* scene)
+{
+	for (Hitable* hitable : hitables)
+	{
+		hitable->AssignMaterialIDs(scene);
+	}
+}
@@ -12,7 +12,37 @@
 #define FLOAT_MAX std::numeric_limits<float>::max()
 
 class Material;
+class Hitable;
+class Scene;
+struct HitResult;
+struct RayPacket;
+
+// Closest hit found by ray traversal. Only what is needed to compare hits;
+// the rest of the surface data is computed once for the final hit (see HitResult).
+struct TraversalHit
+{
+	float          t;      // Ray hit time (ray.at(t) = p)
+	const Hitable* object; // Primitive that was hit
+	// Barycentrics for triangles. Unused by other primitives.
+	float          u;
+	float          v;
+};
+
+// Material parameters at a hit, evaluated once per shading point (see HitResult::EvaluateBSDF())
+// so that later material calls for the same hit don't sample the textures again.
+struct BSDFRecord
+{
+	vec3  albedo;
+	float roughness;
+	float metallic;
+	vec3  normal;   // Microsurface normal in local tangent space
+	vec3  emission; // Emission of all materials is isotropic.
+};
+
+// Fills the BSDF record of a hit on the given material. See Material::GetBSDFKernel().
+using EvaluateBSDFKernel = void(*)(const Material& material, const HitResult& hitResult, BSDFRecord& outBSDF);
 
+// Full surface data at a hit, filled by Hitable::ComputeSurfaceInteraction().
 struct HitResult
 {
 	float     t; // Ray hit time (ray.at(t) = p)
@@ -24,9 +54,16 @@ struct HitResult
 	float     paramV;
 
 	Material* material;
+	// Primitive that was hit. Used to find the light source when an emissive surface is hit.
+	const Hitable* object;
+
+	// Only valid after EvaluateBSDF().
+	BSDFRecord bsdf;
 
 public:
 	RAYLIB_API void BuildOrthonormalBasis();
+	// Call before shading. Material methods that take a HitResult read the BSDF record instead of textures.
+	RAYLIB_API void EvaluateBSDF();
 	RAYLIB_API vec3 LocalToWorld(const vec3& localDirection) const;
 	RAYLIB_API vec3 WorldToLocal(const vec3& worldDirection) const;
 private:
@@ -41,11 +78,75 @@ class Hitable
 public:
 	virtual ~Hitable() = default;
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const = 0;
+	// Find the closest hit in (t_min, t_max). outHit is only written if there is a hit.
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const = 0;
+
+	// Intersect all rays in the packet. For each lane that finds a hit closer than packet.tMax[lane],
+	// updates packet.tMax[lane], packet.hit[lane], and outHits[lane].
+	// Default implementation traces the rays one by one.
+	RAYLIB_API virtual void HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const;
+
+	// Fill the surface data of a hit found by Intersect() of this primitive.
+	// Only primitives implement this; composite hitables never appear in TraversalHit::object.
+	RAYLIB_API virtual void ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const
+	{
+		CHECK_NO_ENTRY();
+	}
+
+	// Intersect() followed by ComputeSurfaceInteraction() of the closest primitive.
+	RAYLIB_API bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const;
 
 	// Returns false if bounding box is not supported
 	virtual bool BoundingBox(float t0, float t1, AABB& outBox) const = 0;
 
+	// -------------------------------
+	// Area lights
+	// Primitives that support the sampling functions below can be used as area lights.
+
+	// Append primitives with emissive materials.
+	RAYLIB_API virtual void GatherEmitters(std::vector<const Hitable*>& outEmitters) const {}
+
+	RAYLIB_API virtual float GetSurfaceArea() const { return 0.0f; }
+
+	// Uniformly sample a point on the surface (pdf = 1 / area).
+	// outSample.t is not used. Returns false if not supported.
+	RAYLIB_API virtual bool SampleSurface(float u0, float u1, HitResult& outSample) const { return false; }
+
+	// Sample a point on the surface as seen from refPoint.
+	// outPdf is in solid angle measure. Default implementation converts SampleSurface().
+	RAYLIB_API virtual bool SampleSurfaceFrom(const vec3& refPoint, float u0, float u1, HitResult& outSample, float& outPdf) const;
+
+	// Solid angle pdf of SampleSurfaceFrom() generating surfacePoint, which is on this surface.
+	RAYLIB_API virtual float SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const;
+
+	// Cone (axis, cos of half angle) that bounds the surface normals. Used by the light BVH.
+	// Default is the entire sphere.
+	RAYLIB_API virtual void GetNormalBounds(vec3& outAxis, float& outCosTheta) const
+	{
+		outAxis = vec3(0.0f, 0.0f, 1.0f);
+		outCosTheta = -1.0f;
+	}
+
+	// -------------------------------
+	// Identification (object and material ID AOVs)
+
+	// Index of the scene element that owns this primitive. 0 if not assigned.
+	// Assigned by Scene::Finalize(); composite hitables forward it to their primitives.
+	RAYLIB_API virtual void SetObjectID(uint32 inObjectID) { objectID = inObjectID; }
+	inline uint32 GetObjectID() const { return objectID; }
+
+	// Append materials used by this hitable. May contain duplicates.
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const {}
+
+	// ID of the material of this primitive in the scene. 0 if not assigned.
+	// Assigned by Scene::Finalize(); composite hitables forward it to their primitives.
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) {}
+	inline uint32 GetMaterialID() const { return materialID; }
+
+protected:
+	uint32 objectID = 0;
+	uint32 materialID = 0;
+
 };
 
 class HitableList : public Hitable
@@ -57,7 +158,9 @@ public:
 		: hitables(inList)
 	{}
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const;
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const override;
+
+	RAYLIB_API virtual void HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const override;
 
 	virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override
 	{
@@ -85,5 +188,11 @@ public:
 		return true;
 	}
 
+	RAYLIB_API virtual void GatherEmitters(std::vector<const Hitable*>& outEmitters) const override;
+
+	RAYLIB_API virtual void SetObjectID(uint32 inObjectID) override;
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const override;
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) override;
+
 	std::vector<Hitable*> hitables;
 };
@@ -0,0 +1,371 @@
+#include "light_bvh.h"
+#include "geom/hit.h"
+#include "core/assertion.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LIGHT_BVH_NUM_BUCKETS 12
+// Max depth is limited by the bit trail. Below half of it, nodes are split
+// at the median instead of by SAOH so that the depth stays within the limit.
+#define LIGHT_BVH_MAX_DEPTH 64
+
+static const float PI = 3.14159265359f;
+static const float ONE_MINUS_EPSILON = 0.99999994f;
+
+inline float SafeSqrt(float x) { return sqrtf(std::max(0.0f, x)); }
+inline float SafeACos(float x) { return acosf(std::max(-1.0f, std::min(1.0f, x))); }
+
+// cos(max(0, a - b)) and sin(max(0, a - b)), given sines and cosines of a and b.
+inline float CosSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+	return (cosA > cosB) ? 1.0f : (cosA * cosB + sinA * sinB);
+}
+inline float SinSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+	return (cosA > cosB) ? 0.0f : (sinA * cosB - cosA * sinB);
+}
+
+// Rodrigues' rotation formula. axis should be normalized.
+inline vec3 RotateAroundAxis(const vec3& v, const vec3& axis, float theta)
+{
+	float cosT = cosf(theta), sinT = sinf(theta);
+	return v * cosT + cross(axis, v) * sinT + axis * (dot(axis, v) * (1.0f - cosT));
+}
+
+inline float SurfaceArea(const AABB& box)
+{
+	vec3 d = box.maxBounds - box.minBounds;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// -------------------------------
+// DirectionCone
+
+DirectionCone DirectionCone::EntireSphere()
+{
+	DirectionCone cone;
+	cone.cosTheta = -1.0f;
+	cone.bEmpty = false;
+	return cone;
+}
+
+DirectionCone DirectionCone::Union(const DirectionCone& a, const DirectionCone& b)
+{
+	if (a.bEmpty) return b;
+	if (b.bEmpty) return a;
+
+	// If one cone is inside the other, return the bigger one.
+	float theta_a = SafeACos(a.cosTheta);
+	float theta_b = SafeACos(b.cosTheta);
+	float theta_d = SafeACos(dot(a.w, b.w));
+	if (std::min(theta_d + theta_b, PI) <= theta_a) return a;
+	if (std::min(theta_d + theta_a, PI) <= theta_b) return b;
+
+	float theta_o = (theta_a + theta_d + theta_b) / 2.0f;
+	if (theta_o >= PI)
+	{
+		return EntireSphere();
+	}
+
+	// Rotate a.w towards b.w
+	float theta_r = theta_o - theta_a;
+	vec3 wr = cross(a.w, b.w);
+	if (wr.LengthSquared() == 0.0f)
+	{
+		return EntireSphere();
+	}
+	DirectionCone cone;
+	cone.w = normalize(RotateAroundAxis(a.w, normalize(wr), theta_r));
+	cone.cosTheta = cosf(theta_o);
+	cone.bEmpty = false;
+	return cone;
+}
+
+// -------------------------------
+// LightBounds
+
+float LightBounds::Importance(const vec3& refPoint) const
+{
+	// Receiver normal is not considered; pdfs are evaluated only from positions.
+	vec3 center = 0.5f * (bounds.minBounds + bounds.maxBounds);
+	vec3 toPoint = refPoint - center;
+	float d2 = toPoint.LengthSquared();
+	d2 = std::max(d2, 0.5f * (bounds.maxBounds - bounds.minBounds).Length());
+
+	vec3 wi = (toPoint.LengthSquared() > 0.0f) ? normalize(toPoint) : vec3(0.0f, 0.0f, 1.0f);
+	float cosTheta_w = dot(normals.w, wi);
+	if (bTwoSided)
+	{
+		cosTheta_w = std::abs(cosTheta_w);
+	}
+	float sinTheta_w = SafeSqrt(1.0f - cosTheta_w * cosTheta_w);
+
+	// Angle subtended by the bounds as seen from refPoint.
+	float radiusSq = (bounds.maxBounds - center).LengthSquared();
+	float cosTheta_b = -1.0f;
+	if (toPoint.LengthSquared() > radiusSq)
+	{
+		cosTheta_b = SafeSqrt(1.0f - radiusSq / toPoint.LengthSquared());
+	}
+	float sinTheta_b = SafeSqrt(1.0f - cosTheta_b * cosTheta_b);
+
+	// Minimum angle between the emitter normals and the direction to refPoint.
+	float cosTheta_o = normals.cosTheta;
+	float sinTheta_o = SafeSqrt(1.0f - cosTheta_o * cosTheta_o);
+	float cosTheta_x = CosSubClamped(sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o);
+	float sinTheta_x = SinSubClamped(sinTheta_w, cosTheta_w, sinTheta_o, cosTheta_o);
+	float cosThetap = CosSubClamped(sinTheta_x, cosTheta_x, sinTheta_b, cosTheta_b);
+	if (cosThetap <= cosThetaE)
+	{
+		return 0.0f;
+	}
+
+	return phi * cosThetap / d2;
+}
+
+LightBounds LightBounds::Union(const LightBounds& a, const LightBounds& b)
+{
+	if (a.phi == 0.0f) return b;
+	if (b.phi == 0.0f) return a;
+
+	LightBounds result;
+	result.bounds = a.bounds + b.bounds;
+	result.phi = a.phi + b.phi;
+	result.normals = DirectionCone::Union(a.normals, b.normals);
+	result.cosThetaE = std::min(a.cosThetaE, b.cosThetaE);
+	result.bTwoSided = a.bTwoSided || b.bTwoSided;
+	return result;
+}
+
+// Solid angle measure of the directions that the bounds emit to.
+static float OrientationMeasure(const LightBounds& lb)
+{
+	float theta_o = SafeACos(lb.normals.cosTheta);
+	float theta_e = SafeACos(lb.cosThetaE);
+	float theta_w = std::min(theta_o + theta_e, PI);
+	float sinTheta_o = SafeSqrt(1.0f - lb.normals.cosTheta * lb.normals.cosTheta);
+	return 2.0f * PI * (1.0f - lb.normals.cosTheta)
+		+ PI / 2.0f * (2.0f * theta_w * sinTheta_o - cosf(theta_o - 2.0f * theta_w) - 2.0f * theta_o * sinTheta_o + lb.normals.cosTheta);
+}
+
+// -------------------------------
+// LightBVH
+
+void LightBVH::Build(const std::vector<const Hitable*>& lights, const std::vector<float>& lightPowers)
+{
+	CHECK(lights.size() == lightPowers.size());
+
+	nodes.clear();
+	bitTrails.assign(lights.size(), 0);
+
+	std::vector<BuildItem> items;
+	items.reserve(lights.size());
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		BuildItem item;
+		item.lightIndex = (int32)i;
+		if (!lights[i]->BoundingBox(0.0f, 0.0f, item.lightBounds.bounds))
+		{
+			// Lights should have bounds.
+			CHECK_NO_ENTRY();
+		}
+		item.lightBounds.phi = lightPowers[i];
+		lights[i]->GetNormalBounds(item.lightBounds.normals.w, item.lightBounds.normals.cosTheta);
+		item.lightBounds.normals.bEmpty = false;
+		// Diffuse emission on both sides
+		item.lightBounds.cosThetaE = 0.0f;
+		item.lightBounds.bTwoSided = true;
+		item.centroid = 0.5f * (item.lightBounds.bounds.minBounds + item.lightBounds.bounds.maxBounds);
+		items.push_back(item);
+	}
+
+	if (items.size() > 0)
+	{
+		nodes.reserve(2 * items.size() - 1);
+		BuildRecursive(items, 0, (int32)items.size(), 0, 0);
+	}
+}
+
+int32 LightBVH::BuildRecursive(std::vector<BuildItem>& items, int32 begin, int32 end, uint64 bitTrail, int32 depth)
+{
+	CHECK(begin < end && depth < LIGHT_BVH_MAX_DEPTH);
+
+	const int32 nodeIndex = (int32)nodes.size();
+	nodes.push_back(Node());
+
+	if (end - begin == 1)
+	{
+		Node& leaf = nodes[nodeIndex];
+		leaf.lightBounds = items[begin].lightBounds;
+		leaf.childOrLightIndex = items[begin].lightIndex;
+		leaf.bIsLeaf = true;
+		bitTrails[items[begin].lightIndex] = bitTrail;
+		return nodeIndex;
+	}
+
+	LightBounds nodeBounds;
+	AABB centroidBounds(items[begin].centroid, items[begin].centroid);
+	for (int32 i = begin; i < end; ++i)
+	{
+		nodeBounds = LightBounds::Union(nodeBounds, items[i].lightBounds);
+		centroidBounds = centroidBounds + AABB(items[i].centroid, items[i].centroid);
+	}
+
+	// Find the split with the minimal surface area orientation heuristic (SAOH).
+	float minCost = FLOAT_MAX;
+	int32 minCostAxis = -1, minCostBucket = -1;
+	const vec3 extent = centroidBounds.maxBounds - centroidBounds.minBounds;
+	const float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+	for (int32 axis = 0; axis < 3 && depth < LIGHT_BVH_MAX_DEPTH / 2; ++axis)
+	{
+		if (extent[axis] <= 0.0f)
+		{
+			continue;
+		}
+		LightBounds buckets[LIGHT_BVH_NUM_BUCKETS];
+		for (int32 i = begin; i < end; ++i)
+		{
+			float t = (items[i].centroid[axis] - centroidBounds.minBounds[axis]) / extent[axis];
+			int32 b = std::min((int32)(t * LIGHT_BVH_NUM_BUCKETS), LIGHT_BVH_NUM_BUCKETS - 1);
+			buckets[b] = LightBounds::Union(buckets[b], items[i].lightBounds);
+		}
+		// Prefer splitting along long axes.
+		const float Kr = maxExtent / extent[axis];
+		for (int32 split = 0; split < LIGHT_BVH_NUM_BUCKETS - 1; ++split)
+		{
+			LightBounds below, above;
+			for (int32 b = 0; b <= split; ++b) below = LightBounds::Union(below, buckets[b]);
+			for (int32 b = split + 1; b < LIGHT_BVH_NUM_BUCKETS; ++b) above = LightBounds::Union(above, buckets[b]);
+			float cost = 0.0f;
+			if (below.phi > 0.0f) cost += below.phi * OrientationMeasure(below) * SurfaceArea(below.bounds);
+			if (above.phi > 0.0f) cost += above.phi * OrientationMeasure(above) * SurfaceArea(above.bounds);
+			cost *= Kr;
+			if (below.phi > 0.0f && above.phi > 0.0f && cost < minCost)
+			{
+				minCost = cost;
+				minCostAxis = axis;
+				minCostBucket = split;
+			}
+		}
+	}
+
+	int32 mid;
+	if (minCostAxis == -1)
+	{
+		// All centroids coincide or too deep. Split in the middle.
+		mid = (begin + end) / 2;
+	}
+	else
+	{
+		const int32 axis = minCostAxis;
+		auto it = std::partition(items.begin() + begin, items.begin() + end,
+			[&](const BuildItem& item)
+			{
+				float t = (item.centroid[axis] - centroidBounds.minBounds[axis]) / extent[axis];
+				int32 b = std::min((int32)(t * LIGHT_BVH_NUM_BUCKETS), LIGHT_BVH_NUM_BUCKETS - 1);
+				return b <= minCostBucket;
+			});
+		mid = (int32)(it - items.begin());
+		if (mid == begin || mid == end)
+		{
+			mid = (begin + end) / 2;
+		}
+	}
+
+	BuildRecursive(items, begin, mid, bitTrail, depth + 1);
+	int32 secondChild = BuildRecursive(items, mid, end, bitTrail | (1ull << depth), depth + 1);
+
+	Node& node = nodes[nodeIndex];
+	node.lightBounds = nodeBounds;
+	node.childOrLightIndex = secondChild;
+	node.bIsLeaf = false;
+	return nodeIndex;
+}
+
+int32 LightBVH::Sample(const vec3& refPoint, float u, float& outPmf) const
+{
+	if (IsEmpty())
+	{
+		return -1;
+	}
+
+	int32 nodeIndex = 0;
+	float pmf = 1.0f;
+	while (true)
+	{
+		const Node& node = nodes[nodeIndex];
+		if (node.bIsLeaf)
+		{
+			if (nodeIndex > 0 || node.lightBounds.Importance(refPoint) > 0.0f)
+			{
+				outPmf = pmf;
+				return node.childOrLightIndex;
+			}
+			return -1;
+		}
+
+		float importance0 = nodes[nodeIndex + 1].lightBounds.Importance(refPoint);
+		float importance1 = nodes[node.childOrLightIndex].lightBounds.Importance(refPoint);
+		if (importance0 == 0.0f && importance1 == 0.0f)
+		{
+			return -1;
+		}
+		float p0 = importance0 / (importance0 + importance1);
+		if (u < p0)
+		{
+			nodeIndex = nodeIndex + 1;
+			u = std::min(u / p0, ONE_MINUS_EPSILON);
+			pmf *= p0;
+		}
+		else
+		{
+			nodeIndex = node.childOrLightIndex;
+			u = std::min((u - p0) / (1.0f - p0), ONE_MINUS_EPSILON);
+			pmf *= 1.0f - p0;
+		}
+	}
+}
+
+float LightBVH::Pmf(const vec3& refPoint, int32 lightIndex) const
+{
+	if (IsEmpty())
+	{
+		return 0.0f;
+	}
+
+	uint64 bitTrail = bitTrails[lightIndex];
+	int32 nodeIndex = 0;
+	float pmf = 1.0f;
+	while (true)
+	{
+		const Node& node = nodes[nodeIndex];
+		if (node.bIsLeaf)
+		{
+			CHECK(node.childOrLightIndex == lightIndex);
+			if (nodeIndex == 0)
+			{
+				return node.lightBounds.Importance(refPoint) > 0.0f ? 1.0f : 0.0f;
+			}
+			return pmf;
+		}
+
+		float importance0 = nodes[nodeIndex + 1].lightBounds.Importance(refPoint);
+		float importance1 = nodes[node.childOrLightIndex].lightBounds.Importance(refPoint);
+		if (importance0 == 0.0f && importance1 == 0.0f)
+		{
+			return 0.0f;
+		}
+		if (bitTrail & 1)
+		{
+			pmf *= importance1 / (importance0 + importance1);
+			nodeIndex = node.childOrLightIndex;
+		}
+		else
+		{
+			pmf *= importance0 / (importance0 + importance1);
+			nodeIndex = nodeIndex + 1;
+		}
+		bitTrail >>= 1;
+	}
+}
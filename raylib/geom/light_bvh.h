@@ -0,0 +1,80 @@
+// Light hierarchy over emissive primitives.
+// Each node bounds position, power, and emission directions of the lights below it,
+// so that one light can be importance sampled for a shading point in O(log N).
+//
+// Reference: Conty Estevez and Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting" (2018)
+// and its adaptation in pbrt-v4 (BVHLightSampler).
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/vec3.h"
+#include "geom/aabb.h"
+
+#include <vector>
+
+class Hitable;
+
+// Cone of directions. cosTheta = -1 means the entire sphere.
+struct DirectionCone
+{
+	vec3  w        = vec3(0.0f, 0.0f, 1.0f);
+	float cosTheta = -1.0f;
+	bool  bEmpty   = true;
+
+	static DirectionCone EntireSphere();
+	static DirectionCone Union(const DirectionCone& a, const DirectionCone& b);
+};
+
+struct LightBounds
+{
+	AABB          bounds;
+	float         phi = 0.0f;        // Power
+	DirectionCone normals;           // Bounds surface normals of the emitters.
+	float         cosThetaE = 0.0f;  // Emission spread around each normal (cos(pi/2) for diffuse emitters).
+	bool          bTwoSided = true;
+
+	// Conservative estimate of the contribution to refPoint.
+	float Importance(const vec3& refPoint) const;
+
+	static LightBounds Union(const LightBounds& a, const LightBounds& b);
+};
+
+class LightBVH
+{
+
+public:
+	// lightPowers[i] is the power of lights[i]. Lights without power should be excluded by the caller.
+	void Build(const std::vector<const Hitable*>& lights, const std::vector<float>& lightPowers);
+
+	inline bool IsEmpty() const { return nodes.size() == 0; }
+
+	// Pick a light for refPoint. outPmf is the probability of picking it.
+	// @return Index into the light array given to Build(), or -1 if no light can contribute.
+	int32 Sample(const vec3& refPoint, float u, float& outPmf) const;
+
+	// Probability of Sample() picking the light.
+	float Pmf(const vec3& refPoint, int32 lightIndex) const;
+
+private:
+	struct Node
+	{
+		LightBounds lightBounds;
+		// Leaf: index of the light. Interior: index of the second child (first child is the next node).
+		int32       childOrLightIndex;
+		bool        bIsLeaf;
+	};
+
+	struct BuildItem
+	{
+		int32       lightIndex;
+		LightBounds lightBounds;
+		vec3        centroid;
+	};
+
+	int32 BuildRecursive(std::vector<BuildItem>& items, int32 begin, int32 end, uint64 bitTrail, int32 depth);
+
+	std::vector<Node> nodes;
+	// Path from the root to each light's leaf. Bit i is the branch taken at depth i (1 = second child).
+	std::vector<uint64> bitTrails;
+};
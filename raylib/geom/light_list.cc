@@ -0,0 +1,110 @@
+#include "light_list.h"
+#include "render/material.h"
+
+#include <algorithm>
+
+// Emission is averaged over (n * n) surface samples to estimate the power of each emitter.
+#define POWER_ESTIMATION_GRID 2
+
+// Pick lights with a light hierarchy that considers distance and orientation to the shading point.
+// Otherwise lights are picked only by their power.
+#define USE_LIGHT_BVH 1
+
+void LightList::Build(const std::vector<const Hitable*>& emitters)
+{
+	lights.clear();
+	powers.clear();
+	pmf.clear();
+	cdf.clear();
+	lightIndices.clear();
+
+	float totalPower = 0.0f;
+	for (const Hitable* emitter : emitters)
+	{
+		float avgLuminance = 0.0f;
+		for (int32 i = 0; i < POWER_ESTIMATION_GRID * POWER_ESTIMATION_GRID; ++i)
+		{
+			float u0 = ((float)(i % POWER_ESTIMATION_GRID) + 0.5f) / POWER_ESTIMATION_GRID;
+			float u1 = ((float)(i / POWER_ESTIMATION_GRID) + 0.5f) / POWER_ESTIMATION_GRID;
+			HitResult sample;
+			if (emitter->SampleSurface(u0, u1, sample))
+			{
+				avgLuminance += luminance(sample.material->Emitted(sample, -sample.n));
+			}
+		}
+		avgLuminance /= (float)(POWER_ESTIMATION_GRID * POWER_ESTIMATION_GRID);
+
+		float power = avgLuminance * emitter->GetSurfaceArea();
+		if (power > 0.0f)
+		{
+			lightIndices.insert(std::make_pair(emitter, (int32)lights.size()));
+			lights.push_back(emitter);
+			powers.push_back(power);
+			totalPower += power;
+		}
+	}
+
+#if USE_LIGHT_BVH
+	lightBVH.Build(lights, powers);
+#else
+	float accum = 0.0f;
+	for (float power : powers)
+	{
+		pmf.push_back(power / totalPower);
+		accum += pmf.back();
+		cdf.push_back(accum);
+	}
+#endif
+}
+
+bool LightList::Sample(const vec3& refPoint, float u0, float u1, float u2, HitResult& outSample, float& outPdf) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+#if USE_LIGHT_BVH
+	float lightPmf;
+	int32 lightIx = lightBVH.Sample(refPoint, u0, lightPmf);
+	if (lightIx < 0)
+	{
+		return false;
+	}
+#else
+	auto it = std::upper_bound(cdf.begin(), cdf.end(), u0);
+	int32 lightIx = std::min((int32)(it - cdf.begin()), Num() - 1);
+	float lightPmf = pmf[lightIx];
+#endif
+
+	float pdf;
+	if (!lights[lightIx]->SampleSurfaceFrom(refPoint, u1, u2, outSample, pdf))
+	{
+		return false;
+	}
+	outPdf = lightPmf * pdf;
+	return outPdf > 0.0f;
+}
+
+float LightList::LightPmf(const vec3& refPoint, int32 lightIx) const
+{
+#if USE_LIGHT_BVH
+	return lightBVH.Pmf(refPoint, lightIx);
+#else
+	return pmf[lightIx];
+#endif
+}
+
+float LightList::Pdf(const vec3& refPoint, const HitResult& emitterPoint) const
+{
+	auto it = lightIndices.find(emitterPoint.object);
+	if (it == lightIndices.end())
+	{
+		return 0.0f;
+	}
+	float lightPmf = LightPmf(refPoint, it->second);
+	if (lightPmf <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return lightPmf * emitterPoint.object->SurfacePdfFrom(refPoint, emitterPoint);
+}
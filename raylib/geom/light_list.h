@@ -0,0 +1,44 @@
+// Emissive primitives of a scene, used for direct sampling of area lights.
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/vec3.h"
+#include "geom/hit.h"
+#include "geom/light_bvh.h"
+
+#include <vector>
+#include <unordered_map>
+
+class LightList
+{
+
+public:
+	// Emitters should stay alive and not move in memory while the list is in use.
+	void Build(const std::vector<const Hitable*>& emitters);
+
+	inline bool IsEmpty() const { return lights.size() == 0; }
+	inline int32 Num() const { return (int32)lights.size(); }
+
+	// Pick an emitter by its importance to refPoint and sample a point on it as seen from refPoint.
+	// outPdf is in solid angle measure and includes the probability of picking the emitter.
+	bool Sample(const vec3& refPoint, float u0, float u1, float u2, HitResult& outSample, float& outPdf) const;
+
+	// Pdf of Sample() generating emitterPoint. Zero if emitterPoint.object is not in this list.
+	float Pdf(const vec3& refPoint, const HitResult& emitterPoint) const;
+
+private:
+	// Probability of picking the light for refPoint.
+	float LightPmf(const vec3& refPoint, int32 lightIx) const;
+
+	std::vector<const Hitable*> lights;
+	std::vector<float> powers;
+	std::unordered_map<const Hitable*, int32> lightIndices;
+
+	// Used if USE_LIGHT_BVH
+	LightBVH lightBVH;
+
+	// Used if !USE_LIGHT_BVH. Lights are picked in proportion to their power, regardless of refPoint.
+	std::vector<float> pmf;
+	std::vector<float> cdf; // cdf[i] = sum of pmf[0..i]
+};
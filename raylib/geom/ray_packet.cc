@@ -0,0 +1,105 @@
+#include "ray_packet.h"
+#include "geom/hit.h"
+#include "render/simd_kernels.h"
+
+#include <algorithm>
+
+void RayPacket::Finalize(int32 inNumRays)
+{
+	CHECK(0 < inNumRays && inNumRays <= RAY_PACKET_SIZE);
+	numRays = inNumRays;
+
+	for (int32 i = 0; i < RAY_PACKET_SIZE; ++i)
+	{
+		if (i >= numRays)
+		{
+			ox[i] = oy[i] = oz[i] = 0.0f;
+			dx[i] = dy[i] = 0.0f; dz[i] = 1.0f;
+			time[i] = 0.0f;
+		}
+		invDx[i] = 1.0f / dx[i];
+		invDy[i] = 1.0f / dy[i];
+		invDz[i] = 1.0f / dz[i];
+		// Padding lanes reject everything.
+		tMax[i] = (i < numRays) ? FLOAT_MAX : -FLOAT_MAX;
+		hit[i] = false;
+	}
+
+	// Frustum culling requires a common origin.
+	bValidFrustum = false;
+	for (int32 i = 1; i < numRays; ++i)
+	{
+		if (ox[i] != ox[0] || oy[i] != oy[0] || oz[i] != oz[0])
+		{
+			return;
+		}
+	}
+
+	vec3 center(0.0f);
+	for (int32 i = 0; i < numRays; ++i)
+	{
+		center += vec3(dx[i], dy[i], dz[i]);
+	}
+	if (center.LengthSquared() < 1e-8f)
+	{
+		return;
+	}
+	center.Normalize();
+
+	vec3 U = (std::abs(center.x) > 0.9f) ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+	vec3 V = normalize(cross(center, U));
+	U = cross(V, center);
+
+	// Bound slopes of all rays in the (U, V) plane at unit distance along the center.
+	float minU = FLOAT_MAX, maxU = -FLOAT_MAX;
+	float minV = FLOAT_MAX, maxV = -FLOAT_MAX;
+	for (int32 i = 0; i < numRays; ++i)
+	{
+		vec3 d(dx[i], dy[i], dz[i]);
+		float dc = dot(d, center);
+		if (dc <= 0.0f)
+		{
+			return; // Too divergent; can't bound with a frustum.
+		}
+		float su = dot(d, U) / dc;
+		float sv = dot(d, V) / dc;
+		minU = std::min(minU, su); maxU = std::max(maxU, su);
+		minV = std::min(minV, sv); maxV = std::max(maxV, sv);
+	}
+
+	frustumOrigin = vec3(ox[0], oy[0], oz[0]);
+	frustumNormals[0] = U - maxU * center;
+	frustumNormals[1] = minU * center - U;
+	frustumNormals[2] = V - maxV * center;
+	frustumNormals[3] = minV * center - V;
+	bValidFrustum = true;
+}
+
+bool RayPacket::HitBox(const AABB& box, float tMin) const
+{
+	return GetSIMDKernels().packetHitBox(*this, box, tMin);
+}
+
+bool RayPacket::FrustumCullBox(const AABB& box) const
+{
+	if (!bValidFrustum)
+	{
+		return false;
+	}
+	const vec3 minB = box.minBounds - frustumOrigin;
+	const vec3 maxB = box.maxBounds - frustumOrigin;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		// Corner of the box that is the most inside for this plane.
+		const vec3& N = frustumNormals[i];
+		vec3 corner(
+			N.x > 0.0f ? minB.x : maxB.x,
+			N.y > 0.0f ? minB.y : maxB.y,
+			N.z > 0.0f ? minB.z : maxB.z);
+		if (dot(corner, N) > 0.0f)
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,56 @@
+// Packet of coherent rays (e.g., camera rays of a work cell) traced together.
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/vec3.h"
+#include "geom/ray.h"
+#include "geom/aabb.h"
+
+#include <xmmintrin.h>
+
+// Max number of rays in a packet. Should be a multiple of 16 (widest kernel, see simd_kernels.h) and at most 64.
+#define RAY_PACKET_SIZE 64
+
+// SoA layout so that up to 16 lanes can be processed at once.
+// Lanes in [numRays, RAY_PACKET_SIZE) are padding and never hit anything.
+struct alignas(64) RayPacket
+{
+	float ox[RAY_PACKET_SIZE], oy[RAY_PACKET_SIZE], oz[RAY_PACKET_SIZE];
+	float dx[RAY_PACKET_SIZE], dy[RAY_PACKET_SIZE], dz[RAY_PACKET_SIZE];
+	float invDx[RAY_PACKET_SIZE], invDy[RAY_PACKET_SIZE], invDz[RAY_PACKET_SIZE];
+	float time[RAY_PACKET_SIZE];
+	// Closest hit so far. Traversal only accepts hits closer than this.
+	float tMax[RAY_PACKET_SIZE];
+	bool  hit[RAY_PACKET_SIZE];
+
+	int32 numRays = 0;
+
+	// Frustum that bounds all rays. Only valid if all rays share an origin (pinhole camera).
+	// A point x is inside if dot(x - frustumOrigin, frustumNormals[i]) <= 0 for all i.
+	bool bValidFrustum = false;
+	vec3 frustumOrigin;
+	vec3 frustumNormals[4];
+
+	inline ray GetRay(int32 lane) const
+	{
+		return ray(vec3(ox[lane], oy[lane], oz[lane]), vec3(dx[lane], dy[lane], dz[lane]), time[lane]);
+	}
+
+	inline void SetRay(int32 lane, const ray& r)
+	{
+		ox[lane] = r.o.x; oy[lane] = r.o.y; oz[lane] = r.o.z;
+		dx[lane] = r.d.x; dy[lane] = r.d.y; dz[lane] = r.d.z;
+		time[lane] = r.t;
+	}
+
+	// Call after all rays are set by SetRay().
+	// Fills padding lanes, resets hit state, and builds the frustum if possible.
+	void Finalize(int32 inNumRays);
+
+	// @return true if any active ray of the packet may hit the box within [tMin, tMax[lane]].
+	bool HitBox(const AABB& box, float tMin) const;
+
+	// Conservative test. @return true if the box is entirely outside the frustum.
+	bool FrustumCullBox(const AABB& box) const;
+};
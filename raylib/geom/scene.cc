@@ -1,10 +1,67 @@
 #include "scene.h"
 #include "bvh.h"
+#include "transform.h"
+#include "render/image.h"
+#include "render/material.h"
+#include "core/random.h"
+
+// Row 0: the material is only known per hit.
+static void EvaluateBSDF_Unregistered(const Material& material, const HitResult& hitResult, BSDFRecord& outBSDF)
+{
+	material.EvaluateBSDF(hitResult, outBSDF);
+}
+
+void MaterialTable::Clear()
+{
+	materials.clear();
+	bEmissive.clear();
+	features.clear();
+	evaluateBSDF.clear();
+	albedo.clear();
+	roughness.clear();
+	metallic.clear();
+	emission.clear();
+
+	const BSDFRecord zero{ vec3(0.0f), 1.0f, 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f) };
+	AddRow(nullptr, true, MATERIAL_FEATURE_ALL, EvaluateBSDF_Unregistered, zero);
+}
+
+uint32 MaterialTable::Add(const Material* material)
+{
+	uint32 materialFeatures;
+	BSDFRecord constants;
+	EvaluateBSDFKernel kernel = material->GetBSDFKernel(materialFeatures, constants);
+	AddRow(material, material->IsEmissive(), materialFeatures, kernel, constants);
+	return Size() - 1;
+}
+
+void MaterialTable::AddRow(const Material* material, bool bMaterialEmissive, uint32 materialFeatures,
+	EvaluateBSDFKernel kernel, const BSDFRecord& constants)
+{
+	materials.push_back(material);
+	bEmissive.push_back(bMaterialEmissive ? 1 : 0);
+	features.push_back(materialFeatures);
+	evaluateBSDF.push_back(kernel);
+	albedo.push_back(constants.albedo);
+	roughness.push_back(constants.roughness);
+	metallic.push_back(constants.metallic);
+	emission.push_back(constants.emission);
+}
 
 Scene::Scene()
 {
 	sunIlluminance = vec3(0.0f);
 	sunDirection = normalize(vec3(0.0f, -1.0f, -0.5f));
+	materialTable.Clear();
+
+	// #todo-wip: Control sky image rotation in Scene.
+	Rotator rot;
+	rot.yaw = 90.0f;
+	vec3 columns[3] = { rot.rotate(vec3(1.0f, 0.0f, 0.0f)), rot.rotate(vec3(0.0f, 1.0f, 0.0f)), rot.rotate(vec3(0.0f, 0.0f, 1.0f)) };
+	for (int32 i = 0; i < 3; ++i)
+	{
+		skyRotation[i] = vec3(columns[0][i], columns[1][i], columns[2][i]);
+	}
 }
 
 Scene::~Scene()
@@ -26,6 +83,213 @@ BVHNode* Scene::Finalize()
 	{
 		bFinalized = true;
 		accelStruct = new BVHNode(&hitableList, 0.0f, 0.0f);
+
+		std::vector<const Material*> materials;
+		materialTable.Clear();
+		for (size_t i = 0; i < hitableList.hitables.size(); ++i)
+		{
+			hitableList.hitables[i]->SetObjectID((uint32)i + 1);
+			hitableList.hitables[i]->GatherMaterials(materials);
+		}
+		for (const Material* material : materials)
+		{
+			if (material != nullptr && materialIDs.find(material) == materialIDs.end())
+			{
+				uint32 materialID = materialTable.Add(material);
+				materialIDs.insert(std::make_pair(material, materialID));
+			}
+		}
+		hitableList.AssignMaterialIDs(this);
+
+		std::vector<const Hitable*> emissivePrimitives;
+		hitableList.GatherEmitters(emissivePrimitives);
+		emitters.Build(emissivePrimitives);
 	}
 	return accelStruct;
 }
+
+uint32 Scene::GetMaterialID(const Material* material) const
+{
+	auto it = materialIDs.find(material);
+	return (it != materialIDs.end()) ? it->second : 0;
+}
+
+void Scene::SetSkyPanorama(ImageHandle skyImage)
+{
+	skyPanorama = skyImage;
+	skyDistribution = Distribution2D();
+
+	Image2D* skyLight = (Image2D*)skyPanorama;
+	if (skyLight == nullptr || skyLight->GetWidth() < 2 || skyLight->GetHeight() < 2)
+	{
+		return;
+	}
+
+	// Same texel grid as GetSkyRadianceUV().
+	// Weighted by cos(latitude) as texels near the poles cover smaller solid angles.
+	const int32 nu = skyLight->GetWidth() - 1;
+	const int32 nv = skyLight->GetHeight() - 1;
+	std::vector<float> values(nu * nv);
+	for (int32 y = 0; y < nv; ++y)
+	{
+		float latitude = (((float)y + 0.5f) / (float)nv - 0.5f) * BRDF::PI;
+		float cosLatitude = cosf(latitude);
+		for (int32 x = 0; x < nu; ++x)
+		{
+			values[y * nu + x] = luminance(skyLight->GetPixel(x, y).RGBToVec3()) * cosLatitude;
+		}
+	}
+	skyDistribution = Distribution2D(values.data(), nu, nv);
+}
+
+vec3 Scene::GetSkyRadiance(const vec3& direction) const
+{
+	if (skyPanorama == NULL)
+	{
+		// #todo-wip: Fallback sky
+		//float t = 0.5f * (dir.y + 1.0f);
+		//return ((1.0f - t) * vec3(1.0f, 1.0f, 1.0f) + t * vec3(0.5f, 0.7f, 1.0f));
+		return vec3(0.0f);
+	}
+
+	float u, v;
+	SkyDirectionToUV(direction, u, v);
+	return GetSkyRadianceUV(u, v);
+}
+
+vec3 Scene::GetSkyRadianceUV(float u, float v) const
+{
+	Image2D* skyLight = (Image2D*)skyPanorama;
+	int32 x = (int32)(u * (skyLight->GetWidth() - 1));
+	int32 y = (int32)(v * (skyLight->GetHeight() - 1));
+
+	return skyLight->GetPixel(x, y).RGBToVec3();
+}
+
+void Scene::SkyDirectionToUV(const vec3& direction, float& outU, float& outV) const
+{
+	vec3 D(dot(skyRotation[0], direction), dot(skyRotation[1], direction), dot(skyRotation[2], direction));
+	D.Normalize();
+
+	// #todo-wip: Is there a case uv goes to inf or nan?
+	float u = std::atan2(D.z, D.x), v = std::asin(std::max(-1.0f, std::min(1.0f, D.y)));
+	u *= 0.5f / BRDF::PI; v *= 1.0f / BRDF::PI;
+	u += 0.5f; v += 0.5f;
+
+	outU = std::max(0.0f, std::min(u, 0.99999994f));
+	outV = std::max(0.0f, std::min(v, 0.99999994f));
+}
+
+vec3 Scene::SkyUVToDirection(float u, float v) const
+{
+	float azimuth = (u - 0.5f) * 2.0f * BRDF::PI;
+	float latitude = (v - 0.5f) * BRDF::PI;
+	vec3 D(cosf(latitude) * cosf(azimuth), sinf(latitude), cosf(latitude) * sinf(azimuth));
+	// Inverse rotation
+	return D.x * skyRotation[0] + D.y * skyRotation[1] + D.z * skyRotation[2];
+}
+
+float Scene::SkyDirectionPdf(float u, float v) const
+{
+	if (!skyDistribution.IsValid())
+	{
+		return 1.0f / (4.0f * BRDF::PI);
+	}
+	// (u, v) -> (azimuth, latitude) -> solid angle
+	float cosLatitude = cosf((v - 0.5f) * BRDF::PI);
+	if (cosLatitude <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return skyDistribution.Pdf(u, v) / (2.0f * BRDF::PI * BRDF::PI * cosLatitude);
+}
+
+int32 Scene::GetNumLightTypes() const
+{
+	int32 num = 0;
+	if (sunIlluminance != vec3(0.0f)) num += 1;
+	if (skyPanorama != NULL) num += 1;
+	if (!emitters.IsEmpty()) num += 1;
+	return num;
+}
+
+bool Scene::SampleLight(const vec3& refPoint, float uLight, float u0, float u1, LightSample& outSample) const
+{
+	const int32 numTypes = GetNumLightTypes();
+	if (numTypes == 0)
+	{
+		return false;
+	}
+	const float pickPdf = 1.0f / (float)numTypes;
+	int32 pick = std::min((int32)(uLight * numTypes), numTypes - 1);
+	// Reuse the remainder to pick an emitter.
+	uLight = std::min(uLight * numTypes - (float)pick, RANDOM_ONE_MINUS_EPSILON);
+
+	if (sunIlluminance != vec3(0.0f) && pick-- == 0)
+	{
+		outSample.Wi = -sunDirection;
+		outSample.distance = FLOAT_MAX;
+		outSample.Li = sunIlluminance;
+		outSample.pdf = pickPdf;
+		outSample.bDeltaLight = true;
+		return true;
+	}
+	if (skyPanorama != NULL && pick-- == 0)
+	{
+		float u, v;
+		if (skyDistribution.IsValid())
+		{
+			float pdfUV;
+			skyDistribution.SampleContinuous(u0, u1, u, v, pdfUV);
+			outSample.Wi = SkyUVToDirection(u, v);
+		}
+		else
+		{
+			outSample.Wi = SampleUnitSphere(u0, u1);
+			SkyDirectionToUV(outSample.Wi, u, v);
+		}
+		outSample.distance = FLOAT_MAX;
+		outSample.Li = GetSkyRadianceUV(u, v);
+		outSample.pdf = pickPdf * SkyDirectionPdf(u, v);
+		outSample.bDeltaLight = false;
+		return outSample.pdf > 0.0f;
+	}
+
+	HitResult emitterHit;
+	float pdf;
+	if (!emitters.Sample(refPoint, uLight, u0, u1, emitterHit, pdf))
+	{
+		return false;
+	}
+	vec3 toLight = emitterHit.p - refPoint;
+	outSample.distance = toLight.Length();
+	if (outSample.distance <= 0.0f)
+	{
+		return false;
+	}
+	outSample.Wi = toLight / outSample.distance;
+	outSample.Li = emitterHit.material->Emitted(emitterHit, outSample.Wi);
+	outSample.pdf = pickPdf * pdf;
+	outSample.bDeltaLight = false;
+	return true;
+}
+
+float Scene::EmitterPdf(const vec3& refPoint, const HitResult& emitterHit) const
+{
+	if (emitters.IsEmpty())
+	{
+		return 0.0f;
+	}
+	return emitters.Pdf(refPoint, emitterHit) / (float)GetNumLightTypes();
+}
+
+float Scene::SkyPdf(const vec3& direction) const
+{
+	if (skyPanorama == NULL)
+	{
+		return 0.0f;
+	}
+	float u, v;
+	SkyDirectionToUV(direction, u, v);
+	return SkyDirectionPdf(u, v) / (float)GetNumLightTypes();
+}
@@ -5,6 +5,56 @@
 #include "raylib_types.h"
 #include "hit.h"
 #include "bvh.h"
+#include "light_list.h"
+#include "core/distribution.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Direction towards a light source chosen by Scene::SampleLight().
+struct LightSample
+{
+	vec3  Wi;          // From the reference point towards the light (normalized)
+	float distance;    // FLOAT_MAX for distant lights
+	vec3  Li;          // Incoming radiance (illuminance for the sun)
+	float pdf;         // Solid angle pdf, including the probability of picking the light
+	bool  bDeltaLight; // Sun. Can't be hit by scattered rays, so no MIS is needed.
+};
+
+// Materials of a scene indexed by material ID, one array per column.
+// Lets batched shading look up per-material data without touching the Material objects.
+// Built by Scene::Finalize(); materials should not be modified afterwards.
+// Index 0 is reserved for materials that are not in the scene; its kernel dispatches through the hit's material.
+struct MaterialTable
+{
+	std::vector<const Material*> materials;
+	std::vector<uint8> bEmissive;                   // Material::IsEmissive()
+	std::vector<uint32> features;                   // EMaterialFeature; parameters that vary over the surface
+	std::vector<EvaluateBSDFKernel> evaluateBSDF;   // Fills the BSDF record of a hit if features != 0
+	// Parameters of the BSDF record that are not in features
+	std::vector<vec3> albedo;
+	std::vector<float> roughness;
+	std::vector<float> metallic;
+	std::vector<vec3> emission;
+
+	inline uint32 Size() const { return (uint32)materials.size(); }
+	void Clear();
+	// @return ID of the new entry
+	uint32 Add(const Material* material);
+	// BSDF record of every hit on the material if features[materialID] == 0.
+	inline void GetConstantBSDF(uint32 materialID, BSDFRecord& outBSDF) const
+	{
+		outBSDF.albedo = albedo[materialID];
+		outBSDF.roughness = roughness[materialID];
+		outBSDF.metallic = metallic[materialID];
+		outBSDF.normal = vec3(0.0f, 0.0f, 1.0f);
+		outBSDF.emission = emission[materialID];
+	}
+
+private:
+	void AddRow(const Material* material, bool bMaterialEmissive, uint32 materialFeatures,
+		EvaluateBSDFKernel kernel, const BSDFRecord& constants);
+};
 
 class Scene
 {
@@ -14,8 +64,8 @@ public:
 
 	void AddSceneElement(Hitable* hitable);
 
-	// Equirectangular map
-	inline void SetSkyPanorama(ImageHandle skyImage) { skyPanorama = skyImage; }
+	// Equirectangular map. Also builds a luminance distribution to importance sample it.
+	void SetSkyPanorama(ImageHandle skyImage);
 	inline void SetSunIlluminance(const vec3& illuminance) { sunIlluminance = illuminance; }
 	inline void SetSunDirection(const vec3& direction) { sunDirection = normalize(direction); }
 
@@ -23,6 +73,8 @@ public:
 	BVHNode* Finalize();
 
 	inline ImageHandle GetSkyPanorama() const { return skyPanorama; }
+	// Radiance from the sky panorama along the given direction. Zero if no panorama.
+	vec3 GetSkyRadiance(const vec3& direction) const;
 	inline void GetSun(vec3& outIlluminance, vec3& outDirection) const
 	{
 		outIlluminance = sunIlluminance;
@@ -31,12 +83,44 @@ public:
 
 	inline const BVHNode* GetAccelStruct() const { return accelStruct; }
 
+	// IDs start from 1 in the order of scene elements. 0 if not in this scene (or not finalized yet).
+	// Object and material IDs are also stored in each primitive; see Hitable::GetObjectID() and GetMaterialID().
+	uint32 GetMaterialID(const Material* material) const;
+	inline const MaterialTable& GetMaterialTable() const { return materialTable; }
+
+	// Light sampling
+	// Sun, sky, and emissive surfaces are picked with equal probability.
+
+	// Pick a light source and sample a direction towards it. Returns false if no light.
+	// uLight picks the light, (u0, u1) samples a point on it. All in [0, 1).
+	bool SampleLight(const vec3& refPoint, float uLight, float u0, float u1, LightSample& outSample) const;
+	// Solid angle pdf of SampleLight() choosing the given point on an emissive surface.
+	float EmitterPdf(const vec3& refPoint, const HitResult& emitterHit) const;
+	// Solid angle pdf of SampleLight() choosing the sky along the direction.
+	float SkyPdf(const vec3& direction) const;
+	// SampleLight() always fails if false.
+	inline bool HasLightSources() const { return GetNumLightTypes() > 0; }
+
 private:
+	int32 GetNumLightTypes() const;
+
+	// Sky panorama parameterization; (u, v) in [0, 1)^2
+	void SkyDirectionToUV(const vec3& direction, float& outU, float& outV) const;
+	vec3 SkyUVToDirection(float u, float v) const;
+	vec3 GetSkyRadianceUV(float u, float v) const;
+	// Solid angle pdf of sampling the sky panorama, without the probability of picking the sky.
+	float SkyDirectionPdf(float u, float v) const;
+
 	HitableList hitableList;
 	BVHNode* accelStruct = nullptr;
+	LightList emitters;
+	std::unordered_map<const Material*, uint32> materialIDs;
+	MaterialTable materialTable;
 
 	// Distant lighting
 	ImageHandle skyPanorama = NULL;
+	vec3 skyRotation[3]; // Rows of the rotation applied before the panorama lookup
+	Distribution2D skyDistribution;
 	vec3 sunIlluminance;
 	vec3 sunDirection;
 
@@ -1,6 +1,8 @@
 #include "sphere.h"
+#include "scene.h"
+#include "render/material.h"
 
-bool Sphere::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const
+bool Sphere::Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const
 {
 	vec3 oc = r.o - center;
 	float a = dot(r.d, r.d);
@@ -10,43 +12,116 @@ bool Sphere::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) c
 
 	if (D > 0.0f)
 	{
-		bool bHit = false;
-
 		float temp = (-b - sqrtf(b * b - a * c)) / a;
-		if (t_min < temp && temp < t_max)
-		{
-			outResult.t = temp;
-			outResult.p = r.at(outResult.t);
-			outResult.n = (outResult.p - center) / radius;
-			outResult.material = material;
-			bHit = true;
-		}
-		if (!bHit)
+		if (!(t_min < temp && temp < t_max))
 		{
 			temp = (-b + sqrtf(b * b - a * c)) / a;
-			if (t_min < temp && temp < t_max)
+			if (!(t_min < temp && temp < t_max))
 			{
-				outResult.t = temp;
-				outResult.p = r.at(outResult.t);
-				outResult.n = (outResult.p - center) / radius;
-				outResult.material = material;
-				bHit = true;
+				return false;
 			}
 		}
-		if (bHit)
-		{
-			vec3 op = outResult.p - center;
-			outResult.paramU = ::atanf(op.y / op.x);
-			outResult.paramV = ::acosf(op.z / radius);
-		}
-		return bHit;
+		outHit.t = temp;
+		outHit.object = this;
+		return true;
 	}
 	return false;
 }
 
+void Sphere::ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const
+{
+	FillSurfacePoint(r.at(hit.t), outResult);
+	outResult.t = hit.t;
+}
+
 bool Sphere::BoundingBox(float t0, float t1, AABB& outBox) const
 {
 	vec3 R = vec3(radius, radius, radius);
 	outBox = AABB(center - R, center + R);
 	return true;
 }
+
+void Sphere::GatherEmitters(std::vector<const Hitable*>& outEmitters) const
+{
+	if (material->IsEmissive())
+	{
+		outEmitters.push_back(this);
+	}
+}
+
+void Sphere::GatherMaterials(std::vector<const Material*>& outMaterials) const
+{
+	outMaterials.push_back(material);
+}
+
+void Sphere::AssignMaterialIDs(const Scene* scene)
+{
+	materialID = scene->GetMaterialID(material);
+}
+
+float Sphere::GetSurfaceArea() const
+{
+	return 4.0f * BRDF::PI * radius * radius;
+}
+
+bool Sphere::SampleSurface(float u0, float u1, HitResult& outSample) const
+{
+	float z = 1.0f - 2.0f * u0;
+	float r = sqrtf(std::max(0.0f, 1.0f - z * z));
+	float phi = 2.0f * BRDF::PI * u1;
+	FillSurfacePoint(center + radius * vec3(r * cosf(phi), r * sinf(phi), z), outSample);
+	return true;
+}
+
+bool Sphere::SampleSurfaceFrom(const vec3& refPoint, float u0, float u1, HitResult& outSample, float& outPdf) const
+{
+	vec3 toCenter = center - refPoint;
+	float distanceSq = toCenter.LengthSquared();
+	if (distanceSq <= radius * radius)
+	{
+		// Inside the sphere; every direction sees it.
+		return Hitable::SampleSurfaceFrom(refPoint, u0, u1, outSample, outPdf);
+	}
+
+	float sinThetaMaxSq = radius * radius / distanceSq;
+	float cosThetaMax = sqrtf(std::max(0.0f, 1.0f - sinThetaMaxSq));
+	float cosTheta = (1.0f - u0) + u0 * cosThetaMax;
+	float sinThetaSq = std::max(0.0f, 1.0f - cosTheta * cosTheta);
+	float sinTheta = sqrtf(sinThetaSq);
+	float phi = 2.0f * BRDF::PI * u1;
+
+	HitResult frame;
+	frame.n = toCenter / sqrtf(distanceSq);
+	frame.BuildOrthonormalBasis();
+	vec3 dir = frame.LocalToWorld(vec3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta));
+
+	// Nearest intersection of the sampled direction with the sphere.
+	float distance = sqrtf(distanceSq);
+	float t = distance * cosTheta - sqrtf(std::max(0.0f, radius * radius - distanceSq * sinThetaSq));
+	FillSurfacePoint(refPoint + t * dir, outSample);
+	outPdf = 1.0f / (2.0f * BRDF::PI * (1.0f - cosThetaMax));
+	return true;
+}
+
+float Sphere::SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const
+{
+	float distanceSq = (center - refPoint).LengthSquared();
+	if (distanceSq <= radius * radius)
+	{
+		return Hitable::SurfacePdfFrom(refPoint, surfacePoint);
+	}
+	float cosThetaMax = sqrtf(std::max(0.0f, 1.0f - radius * radius / distanceSq));
+	return 1.0f / (2.0f * BRDF::PI * (1.0f - cosThetaMax));
+}
+
+void Sphere::FillSurfacePoint(const vec3& p, HitResult& outResult) const
+{
+	vec3 op = p - center;
+	outResult.t = 0.0f;
+	outResult.p = p;
+	outResult.n = op / radius;
+	outResult.paramU = ::atanf(op.y / op.x);
+	outResult.paramV = ::acosf(op.z / radius);
+	outResult.material = material;
+	outResult.object = this;
+}
@@ -15,10 +15,23 @@ public:
 	{
 	}
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& result) const;
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const override;
+	RAYLIB_API virtual void ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const override;
 
 	RAYLIB_API virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override;
 
+	RAYLIB_API virtual void GatherEmitters(std::vector<const Hitable*>& outEmitters) const override;
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const override;
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) override;
+	RAYLIB_API virtual float GetSurfaceArea() const override;
+	RAYLIB_API virtual bool SampleSurface(float u0, float u1, HitResult& outSample) const override;
+	// Samples the cone of directions subtended by the sphere.
+	RAYLIB_API virtual bool SampleSurfaceFrom(const vec3& refPoint, float u0, float u1, HitResult& outSample, float& outPdf) const override;
+	RAYLIB_API virtual float SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const override;
+
+private:
+	void FillSurfacePoint(const vec3& p, HitResult& outResult) const;
+
 public:
 	vec3 center;
 	float radius;
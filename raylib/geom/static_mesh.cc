@@ -1,5 +1,6 @@
 #include "static_mesh.h"
 #include "geom/bvh.h"
+#include "geom/ray_packet.h"
 
 #define USE_BVH 1
 
@@ -94,7 +95,7 @@ void StaticMesh::Finalize()
 	}
 }
 
-bool StaticMesh::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const
+bool StaticMesh::Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const
 {
 	if (!boundsValid)
 	{
@@ -106,21 +107,17 @@ bool StaticMesh::Hit(const ray& r, float t_min, float t_max, HitResult& outResul
 	}
 
 #if USE_BVH
-	return bvh->Hit(r, t_min, t_max, outResult);
+	return bvh->Intersect(r, t_min, t_max, outHit);
 #else
-	HitResult temp;
 	bool anyHit = false;
 	float closest = t_max;
 	int32 n = (int32)triangles.size();
-	int32 ix;
 	for (int32 i = 0; i < n; ++i)
 	{
-		if (triangles[i].Hit(r, t_min, closest, temp))
+		if (triangles[i].Intersect(r, t_min, closest, outHit))
 		{
 			anyHit = true;
-			closest = temp.t;
-			outResult = temp;
-			ix = i;
+			closest = outHit.t;
 		}
 	}
 
@@ -128,8 +125,71 @@ bool StaticMesh::Hit(const ray& r, float t_min, float t_max, HitResult& outResul
 #endif
 }
 
+void StaticMesh::HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const
+{
+	if (!boundsValid)
+	{
+		CHECK_NO_ENTRY();
+	}
+	else if (packet.FrustumCullBox(bounds) || !packet.HitBox(bounds, t_min))
+	{
+		return;
+	}
+
+#if USE_BVH
+	bvh->HitPacket(packet, t_min, outHits);
+#else
+	Hitable::HitPacket(packet, t_min, outHits);
+#endif
+}
+
 bool StaticMesh::BoundingBox(float t0, float t1, AABB& outBox) const
 {
 	outBox = bounds;
 	return boundsValid;
 }
+
+void StaticMesh::GatherEmitters(std::vector<const Hitable*>& outEmitters) const
+{
+	// Triangles can still move in memory if not locked.
+	if (!bLocked)
+	{
+		return;
+	}
+	for (const Triangle& T : triangles)
+	{
+		T.GatherEmitters(outEmitters);
+	}
+}
+
+void StaticMesh::SetObjectID(uint32 inObjectID)
+{
+	objectID = inObjectID;
+	for (Triangle& T : triangles)
+	{
+		T.SetObjectID(inObjectID);
+	}
+}
+
+void StaticMesh::GatherMaterials(std::vector<const Material*>& outMaterials) const
+{
+	const size_t firstIx = outMaterials.size();
+	for (const Triangle& T : triangles)
+	{
+		T.GatherMaterials(outMaterials);
+		// Neighboring triangles mostly share a material.
+		const size_t n = outMaterials.size();
+		if (n >= firstIx + 2 && outMaterials[n - 1] == outMaterials[n - 2])
+		{
+			outMaterials.pop_back();
+		}
+	}
+}
+
+void StaticMesh::AssignMaterialIDs(const Scene* scene)
+{
+	for (Triangle& T : triangles)
+	{
+		T.AssignMaterialIDs(scene);
+	}
+}
@@ -26,10 +26,18 @@ public:
 	// Lock modification and build acceleration structure
 	RAYLIB_API void Finalize();
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const override;
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const override;
+
+	RAYLIB_API virtual void HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const override;
 
 	RAYLIB_API virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override;
 
+	RAYLIB_API virtual void GatherEmitters(std::vector<const Hitable*>& outEmitters) const override;
+
+	RAYLIB_API virtual void SetObjectID(uint32 inObjectID) override;
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const override;
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) override;
+
 private:
 	std::vector<Triangle> triangles;
 
@@ -44,11 +44,12 @@ vec3 Rotator::toDirection() const
 	return vec3(sinf(theta) * cosPhi, sinf(phi), cosf(theta) * cosPhi);
 }
 
-vec3 Rotator::rotate(const vec3& position) const
+// Rows of the rotation matrix
+static void GetRotationRows(const Rotator& rotator, vec3 outRows[3])
 {
-	const float rad_yaw = toRadians(yaw);
-	const float rad_pitch = toRadians(pitch);
-	const float rad_roll = toRadians(roll);
+	const float rad_yaw = toRadians(rotator.yaw);
+	const float rad_pitch = toRadians(rotator.pitch);
+	const float rad_roll = toRadians(rotator.roll);
 	const float ch = cosf(rad_yaw);
 	const float sh = sinf(rad_yaw);
 	const float cp = cosf(rad_pitch);
@@ -56,14 +57,25 @@ vec3 Rotator::rotate(const vec3& position) const
 	const float cb = cosf(rad_roll);
 	const float sb = sinf(rad_roll);
 
-	vec3 M[3] = {
-		vec3{ch * cb + sh * sp * sb, sb * cp, -sh * cb + ch * sp * sb},
-		vec3{-ch * sb + sh * sp * cb, cb * cp, sb * sh + ch * sp * cb},
-		vec3{sh * cp, -sp, ch * cp}
-	};
+	outRows[0] = vec3{ch * cb + sh * sp * sb, sb * cp, -sh * cb + ch * sp * sb};
+	outRows[1] = vec3{-ch * sb + sh * sp * cb, cb * cp, sb * sh + ch * sp * cb};
+	outRows[2] = vec3{sh * cp, -sp, ch * cp};
+}
+
+vec3 Rotator::rotate(const vec3& position) const
+{
+	vec3 M[3];
+	GetRotationRows(*this, M);
 	return vec3(dot(M[0], position), dot(M[1], position), dot(M[2], position));
 }
 
+mat4 Rotator::toMatrix() const
+{
+	vec3 M[3];
+	GetRotationRows(*this, M);
+	return mat4::FromRows(M[0], M[1], M[2]);
+}
+
 /////////////////////////////////////////////////////////////////
 // Transform
 
@@ -72,6 +84,7 @@ void Transform::Init(const vec3& inLocation, const Rotator& inRotation, const ve
 	location = inLocation;
 	rotation = inRotation;
 	scale = inScale;
+	rotationMatrix = rotation.toMatrix();
 }
 
 void Transform::TransformVectors(const std::vector<vec3>& inVectors, std::vector<vec3>& outVectors) const
@@ -81,7 +94,7 @@ void Transform::TransformVectors(const std::vector<vec3>& inVectors, std::vector
 
 	for (int32 i = 0; i < n; ++i)
 	{
-		outVectors[i] = (rotation.rotate(inVectors[i]) * scale) + location;
+		outVectors[i] = (rotationMatrix.TransformVector(inVectors[i]) * scale) + location;
 	}
 }
 
@@ -90,6 +103,6 @@ void Transform::TransformVectors(std::vector<vec3>& vectors) const
 	int32 n = (int32)vectors.size();
 	for (int32 i = 0; i < n; ++i)
 	{
-		vectors[i] = (rotation.rotate(vectors[i]) * scale) + location;
+		vectors[i] = (rotationMatrix.TransformVector(vectors[i]) * scale) + location;
 	}
 }
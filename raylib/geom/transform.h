@@ -3,6 +3,7 @@
 #include "raylib_types.h"
 #include "core/int_types.h"
 #include "core/vec3.h"
+#include "core/vec4.h"
 #include <vector>
 
 struct Rotator
@@ -10,6 +11,8 @@ struct Rotator
 	static Rotator directionToYawPitch(const vec3& dir);
 	vec3 toDirection() const;
 	RAYLIB_API vec3 rotate(const vec3& position) const;
+	// Same rotation as rotate(), for transforming many vectors.
+	mat4 toMatrix() const;
 
 	Rotator()
 		: yaw(0.0f)
@@ -28,8 +31,6 @@ struct Rotator
 	float roll;  // [-180, 180]
 };
 
-// #todo: Generate matrix internally
-// #todo: Utilize SIMD
 class Transform
 {
 	
@@ -58,4 +59,6 @@ private:
 	Rotator rotation;
 	vec3 scale;
 
+	mat4 rotationMatrix; // Generated from rotation
+
 };
@@ -1,5 +1,8 @@
 #include "triangle.h"
+#include "geom/ray_packet.h"
+#include "geom/scene.h"
 #include "render/material.h"
+#include "render/simd_kernels.h"
 
 Triangle::Triangle(
 	const vec3& inV0, const vec3& inV1, const vec3& inV2,
@@ -14,55 +17,148 @@ Triangle::Triangle(
 	bounds = AABB(min(min(v0, v1), v2), max(max(v0, v1), v2));
 }
 
-// http://geomalgorithms.com/a06-_intersect-2.html
-bool Triangle::Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const
+inline bool Triangle::AlphaTest(float baryU, float baryV) const
 {
-	float paramU, paramV;
+	float s, t;
+	Interpolate(baryU, baryV, s, t);
+	return material->AlphaTest(s, t);
+}
 
-	float t = dot((v0 - r.o), n) / dot(r.d, n);
-	vec3 p = r.o + t * r.d;
+// http://geomalgorithms.com/a06-_intersect-2.html
+bool Triangle::Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const
+{
+	const vec4 O(r.o), D(r.d);
 
+	float t = dot3(simdV0 - O, simdN) / dot3(D, simdN);
 	if (t < t_min || t > t_max)
 	{
 		return false;
 	}
 
-	vec3 u = v1 - v0;
-	vec3 v = v2 - v0;
-	vec3 w = p - v0;
-
-	float uv = dot(u, v);
-	float wv = dot(w, v);
-	float uu = dot(u, u);
-	float vv = dot(v, v);
-	float wu = dot(w, u);
+	vec4 w = (O + t * D) - simdV0;
+	float wv = dot3(w, edgeV);
+	float wu = dot3(w, edgeU);
 	float uvuv = uv * uv;
 	float uuvv = uu * vv;
 
-	paramU = (uv * wv - vv * wu) / (uvuv - uuvv);
-	paramV = (uv * wu - uu * wv) / (uvuv - uuvv);
+	float paramU = (uv * wv - vv * wu) / (uvuv - uuvv);
+	float paramV = (uv * wu - uu * wv) / (uvuv - uuvv);
 
-	if (0.0f <= paramU && 0.0f <= paramV && paramU + paramV <= 1.0f)
+	if (0.0f <= paramU && 0.0f <= paramV && paramU + paramV <= 1.0f && AlphaTest(paramU, paramV))
 	{
-		outResult.t = t;
-		outResult.p = p;
-		outResult.n = normalize((1 - paramU - paramV) * n0 + paramU * n1 + paramV * n2);
-		outResult.paramU = (1 - paramU - paramV) * s0 + paramU * s1 + paramV * s2;
-		outResult.paramV = (1 - paramU - paramV) * t0 + paramU * t1 + paramV * t2;
-		outResult.material = material;
-
-		return material->AlphaTest(outResult.paramU, outResult.paramV);
+		outHit.t = t;
+		outHit.object = this;
+		outHit.u = paramU;
+		outHit.v = paramV;
+		return true;
 	}
 
 	return false;
 }
 
+void Triangle::ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const
+{
+	const float paramU = hit.u;
+	const float paramV = hit.v;
+	outResult.t = hit.t;
+	outResult.p = r.at(hit.t);
+	outResult.n = normalize((1 - paramU - paramV) * n0 + paramU * n1 + paramV * n2);
+	Interpolate(paramU, paramV, outResult.paramU, outResult.paramV);
+	outResult.material = material;
+	outResult.object = this;
+}
+
+// Same test as Intersect(), 8 rays at a time.
+void Triangle::HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const
+{
+	const TriangleKernelData kernelData = {
+		{ v0.x, v0.y, v0.z },
+		{ n.x, n.y, n.z },
+		{ edgeU.x(), edgeU.y(), edgeU.z() },
+		{ edgeV.x(), edgeV.y(), edgeV.z() },
+		uu, uv, vv,
+	};
+
+	alignas(64) float tArr[RAY_PACKET_SIZE], uArr[RAY_PACKET_SIZE], vArr[RAY_PACKET_SIZE];
+	uint64 laneMask = GetSIMDKernels().packetHitTriangle(packet, kernelData, t_min, tArr, uArr, vArr);
+
+	for (int32 lane = 0; laneMask != 0; ++lane, laneMask >>= 1)
+	{
+		if ((laneMask & 1) == 0)
+		{
+			continue;
+		}
+		if (AlphaTest(uArr[lane], vArr[lane]))
+		{
+			packet.tMax[lane] = tArr[lane];
+			packet.hit[lane] = true;
+			outHits[lane].t = tArr[lane];
+			outHits[lane].object = this;
+			outHits[lane].u = uArr[lane];
+			outHits[lane].v = vArr[lane];
+		}
+	}
+}
+
 bool Triangle::BoundingBox(float t0, float t1, AABB& outBox) const
 {
 	outBox = bounds;
 	return true;
 }
 
+void Triangle::GatherEmitters(std::vector<const Hitable*>& outEmitters) const
+{
+	if (material->IsEmissive())
+	{
+		outEmitters.push_back(this);
+	}
+}
+
+void Triangle::GatherMaterials(std::vector<const Material*>& outMaterials) const
+{
+	outMaterials.push_back(material);
+}
+
+void Triangle::AssignMaterialIDs(const Scene* scene)
+{
+	materialID = scene->GetMaterialID(material);
+}
+
+float Triangle::GetSurfaceArea() const
+{
+	return 0.5f * cross(v1 - v0, v2 - v0).Length();
+}
+
+bool Triangle::SampleSurface(float u0, float u1, HitResult& outSample) const
+{
+	// Uniform barycentrics; same convention as Hit().
+	float su = sqrtf(u0);
+	float paramU = u1 * su;
+	float paramV = 1.0f - su;
+
+	outSample.t = 0.0f;
+	outSample.p = (1 - paramU - paramV) * v0 + paramU * v1 + paramV * v2;
+	outSample.n = normalize((1 - paramU - paramV) * n0 + paramU * n1 + paramV * n2);
+	Interpolate(paramU, paramV, outSample.paramU, outSample.paramV);
+	outSample.material = material;
+	outSample.object = this;
+	return true;
+}
+
+float Triangle::SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const
+{
+	// Use the face normal, not the interpolated one.
+	float area = GetSurfaceArea();
+	vec3 toSurface = surfacePoint.p - refPoint;
+	float distanceSq = toSurface.LengthSquared();
+	float cosTheta = absDot(n, toSurface) / sqrtf(distanceSq);
+	if (area <= 0.0f || distanceSq <= 0.0f || cosTheta <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return distanceSq / (cosTheta * area);
+}
+
 void Triangle::GetVertices(vec3& outV0, vec3& outV1, vec3& outV2) const
 {
 	outV0 = v0;
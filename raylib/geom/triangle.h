@@ -2,6 +2,7 @@
 
 #include "raylib_types.h"
 #include "geom/hit.h"
+#include "core/vec4.h"
 
 class Material;
 
@@ -14,10 +15,26 @@ public:
 		const vec3& inN0, const vec3& inN1, const vec3& inN2,
 		Material* inMaterial);
 
-	RAYLIB_API virtual bool Hit(const ray& r, float t_min, float t_max, HitResult& outResult) const;
+	RAYLIB_API virtual bool Intersect(const ray& r, float t_min, float t_max, TraversalHit& outHit) const override;
+
+	RAYLIB_API virtual void HitPacket(RayPacket& packet, float t_min, TraversalHit* outHits) const override;
+
+	RAYLIB_API virtual void ComputeSurfaceInteraction(const ray& r, const TraversalHit& hit, HitResult& outResult) const override;
 
 	RAYLIB_API virtual bool BoundingBox(float t0, float t1, AABB& outBox) const override;
 
+	RAYLIB_API virtual void GatherEmitters(std::vector<const Hitable*>& outEmitters) const override;
+	RAYLIB_API virtual void GatherMaterials(std::vector<const Material*>& outMaterials) const override;
+	RAYLIB_API virtual void AssignMaterialIDs(const Scene* scene) override;
+	RAYLIB_API virtual float GetSurfaceArea() const override;
+	RAYLIB_API virtual bool SampleSurface(float u0, float u1, HitResult& outSample) const override;
+	RAYLIB_API virtual float SurfacePdfFrom(const vec3& refPoint, const HitResult& surfacePoint) const override;
+	RAYLIB_API virtual void GetNormalBounds(vec3& outAxis, float& outCosTheta) const override
+	{
+		outAxis = n;
+		outCosTheta = 1.0f;
+	}
+
 	inline void SetParameterization(float inS0, float inT0, float inS1, float inT1, float inS2, float inT2)
 	{
 		s0 = inS0; t0 = inT0;
@@ -38,10 +55,33 @@ public:
 	RAYLIB_API void SetNormals(const vec3& inN0, const vec3& inN1, const vec3& inN2);
 
 private:
+	// Texture coordinates at barycentrics (baryU, baryV).
+	inline void Interpolate(float baryU, float baryV, float& outS, float& outT) const
+	{
+		outS = (1 - baryU - baryV) * s0 + baryU * s1 + baryV * s2;
+		outT = (1 - baryU - baryV) * t0 + baryU * t1 + baryV * t2;
+	}
+
+	// Alpha-tested materials need texture coordinates during traversal.
+	bool AlphaTest(float baryU, float baryV) const;
+
 	inline void UpdateNormal()
 	{
 		n = cross(v1 - v0, v2 - v0);
 		n.Normalize();
+		UpdateIntersectionData();
+	}
+
+	// Vertex-only terms of the intersection test.
+	inline void UpdateIntersectionData()
+	{
+		simdV0 = vec4(v0);
+		simdN = vec4(n);
+		edgeU = vec4(v1 - v0);
+		edgeV = vec4(v2 - v0);
+		uu = dot3(edgeU, edgeU);
+		uv = dot3(edgeU, edgeV);
+		vv = dot3(edgeV, edgeV);
 	}
 
 	vec3 v0;
@@ -57,6 +97,12 @@ private:
 
 	AABB bounds;
 
+	vec4 simdV0;
+	vec4 simdN;
+	vec4 edgeU; // v1 - v0
+	vec4 edgeV; // v2 - v0
+	float uu, uv, vv;
+
 	// Surface parameterization
 	float s0, t0, s1, t1, s2, t2; 
 	
@@ -8,10 +8,15 @@
 #include "render/camera.h"
 #include "render/image.h"
 #include "render/renderer.h"
+#include "render/render_job.h"
+#include "render/simd_kernels.h"
 #include "loader/obj_loader.h"
 #include "loader/dll_loader.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 // -----------------------------------------------------------------------
 
@@ -20,6 +25,14 @@ static concurrent_vector<Camera*>   g_cameras;
 static concurrent_vector<Image2D*>  g_images;
 static concurrent_vector<Scene*>    g_scenes;
 
+// Outlives the job, as work cells point to aovImages.
+struct AsyncRender
+{
+	Image2D* aovImages[RAYLIB_AOV_MAX];
+	RenderJob* job;
+};
+static concurrent_vector<AsyncRender*> g_asyncRenders;
+
 // -----------------------------------------------------------------------
 
 int32_t Raylib_Initialize()
@@ -37,6 +50,8 @@ int32_t Raylib_Initialize()
 
 	OBJLoader::Initialize();
 
+	SetSIMDLevel(ParseSIMDLevel(getenv("RAYLIB_SIMD")));
+
 	return 1;
 }
 
@@ -50,6 +65,16 @@ int32_t Raylib_Terminate()
 	return 0;
 }
 
+uint32_t Raylib_SetSIMDLevel(uint32_t level)
+{
+	return (uint32_t)SetSIMDLevel((ESIMDLevel)level);
+}
+
+uint32_t Raylib_GetSIMDLevel()
+{
+	return (uint32_t)GetSIMDLevel();
+}
+
 // -----------------------------------------------------------------------
 // Manage media files
 
@@ -238,6 +263,120 @@ void Raylib_Render(
 	renderer.RenderScene(settings, (Scene*)scene, (Camera*)camera, (Image2D*)outMainImage);
 }
 
+void Raylib_RenderWithAOVs(
+	const RendererSettings* settings,
+	SceneHandle scene,
+	CameraHandle camera,
+	ImageHandle outMainImage,
+	const ImageHandle* outAOVImages)
+{
+	Image2D* aovImages[RAYLIB_AOV_MAX];
+	for (int32 i = 0; i < (int32)RAYLIB_AOV_MAX; ++i)
+	{
+		aovImages[i] = (outAOVImages != nullptr) ? (Image2D*)outAOVImages[i] : nullptr;
+	}
+	Renderer renderer;
+	renderer.RenderScene(settings, (Scene*)scene, (Camera*)camera, (Image2D*)outMainImage, aovImages);
+}
+
+void Raylib_RenderViews(
+	SceneHandle scene,
+	int32_t numViews,
+	const RendererSettings* settings,
+	const CameraHandle* cameras,
+	const ImageHandle* outMainImages,
+	const ImageHandle* outAOVImages)
+{
+	std::vector<Image2D*> aovImages((size_t)std::max(0, numViews) * RAYLIB_AOV_MAX, nullptr);
+	std::vector<RenderView> views(std::max(0, numViews));
+	for (int32 viewIx = 0; viewIx < numViews; ++viewIx)
+	{
+		Image2D** viewAOVImages = &aovImages[viewIx * RAYLIB_AOV_MAX];
+		for (int32 i = 0; i < (int32)RAYLIB_AOV_MAX && outAOVImages != nullptr; ++i)
+		{
+			viewAOVImages[i] = (Image2D*)outAOVImages[viewIx * RAYLIB_AOV_MAX + i];
+		}
+		views[viewIx].settings = &settings[viewIx];
+		views[viewIx].camera = (Camera*)cameras[viewIx];
+		views[viewIx].outImage = (Image2D*)outMainImages[viewIx];
+		views[viewIx].outAOVImages = viewAOVImages;
+	}
+	Renderer renderer;
+	renderer.RenderViews((Scene*)scene, views.data(), numViews);
+}
+
+RenderHandle Raylib_RenderAsync(
+	const RendererSettings* settings,
+	SceneHandle scene,
+	CameraHandle camera,
+	ImageHandle outMainImage,
+	const ImageHandle* outAOVImages,
+	RenderTileCallback tileCallback,
+	void* callbackUserData)
+{
+	AsyncRender* render = new AsyncRender;
+	for (int32 i = 0; i < (int32)RAYLIB_AOV_MAX; ++i)
+	{
+		render->aovImages[i] = (outAOVImages != nullptr) ? (Image2D*)outAOVImages[i] : nullptr;
+	}
+	RenderView view{ settings, (Camera*)camera, (Image2D*)outMainImage, render->aovImages };
+	Renderer renderer;
+	render->job = renderer.StartRenderViews((Scene*)scene, &view, 1, tileCallback, callbackUserData);
+	g_asyncRenders.push_back(render);
+	return (RenderHandle)render;
+}
+
+float Raylib_GetRenderProgress(RenderHandle renderHandle)
+{
+	AsyncRender* render = (AsyncRender*)renderHandle;
+	return render->job->GetProgress();
+}
+
+int32_t Raylib_WaitRender(RenderHandle renderHandle, int32_t timeoutMilliseconds)
+{
+	AsyncRender* render = (AsyncRender*)renderHandle;
+	return render->job->Wait(timeoutMilliseconds);
+}
+
+void Raylib_CancelRender(RenderHandle renderHandle)
+{
+	AsyncRender* render = (AsyncRender*)renderHandle;
+	render->job->Cancel();
+}
+
+int32_t Raylib_DestroyRender(RenderHandle renderHandle)
+{
+	AsyncRender* render = (AsyncRender*)renderHandle;
+	if (g_asyncRenders.erase_first(render))
+	{
+		delete render->job;
+		delete render;
+		return true;
+	}
+	return false;
+}
+
+int32_t Raylib_RenderWithCheckpoints(
+	const RendererSettings* settings,
+	SceneHandle scene,
+	CameraHandle camera,
+	ImageHandle outMainImage,
+	const ImageHandle* outAOVImages,
+	const char* checkpointPath,
+	float checkpointIntervalSeconds)
+{
+	Image2D* aovImages[RAYLIB_AOV_MAX];
+	for (int32 i = 0; i < (int32)RAYLIB_AOV_MAX; ++i)
+	{
+		aovImages[i] = (outAOVImages != nullptr) ? (Image2D*)outAOVImages[i] : nullptr;
+	}
+	Renderer renderer;
+	return renderer.RenderSceneWithCheckpoints(
+		settings, (Scene*)scene, (Camera*)camera, (Image2D*)outMainImage,
+		(outAOVImages != nullptr) ? aovImages : nullptr,
+		checkpointPath, checkpointIntervalSeconds);
+}
+
 int32_t Raylib_Denoise(
 	ImageHandle inMainImage,
 	int32_t bMainImageHDR,
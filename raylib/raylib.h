@@ -25,6 +25,14 @@ extern "C" {
 	// @return 1 if successful, 0 otherwise.
 	RAYLIB_API int32_t Raylib_Terminate();
 
+	// Instruction set of the hot kernels. See ESIMDLevel.
+	// Raylib_Initialize() selects the best level of the CPU, or the level in RAYLIB_SIMD env var
+	// ("generic", "sse42", "avx2", "avx512") if set. Don't call while rendering.
+	// @return Level in use. Lower than the requested one if the CPU doesn't support it.
+	RAYLIB_API uint32_t Raylib_SetSIMDLevel(uint32_t level);
+
+	RAYLIB_API uint32_t Raylib_GetSIMDLevel();
+
 	// -----------------------------------------------------------------------
 	// Manage media files
 
@@ -99,7 +107,10 @@ extern "C" {
 	// Rendering
 
 	// Render `scene` viewed from `camera` with given `settings`.
-	// @param settings     [in] Rendering settings. (viewport size, SPP, render mode, ...)
+	// If settings has a crop window and outMainImage is already of the viewport size,
+	// only the crop window is overwritten, so a region of an existing image can be re-rendered.
+	// Otherwise the image is reallocated to the viewport size first.
+	// @param settings     [in] Rendering settings. (viewport size, crop window, SPP, render mode, ...)
 	// @param scene        [in] The scene to render.
 	// @param camera       [in] Camera from which to look at the scene.
 	// @param outMainImage [out] Rendered image.
@@ -109,7 +120,86 @@ extern "C" {
 		CameraHandle camera,
 		ImageHandle  outMainImage);
 
-	// Denoise a noisy path traced image using Intel OpenImageDenoise.
+	// Same as Raylib_Render(), but also fills AOV images (albedo, normal, depth, IDs)
+	// from the same primary hits, without extra render passes.
+	// @param outAOVImages [out] Array of RAYLIB_AOV_MAX images indexed by EAOV.
+	//                           Images for AOVs requested by settings->aovMask should be valid; others can be 0.
+	RAYLIB_API void Raylib_RenderWithAOVs(
+		const RendererSettings* settings,
+		SceneHandle  scene,
+		CameraHandle camera,
+		ImageHandle  outMainImage,
+		const ImageHandle* outAOVImages);
+
+	// Same as Raylib_RenderWithAOVs(), but returns immediately and renders in background threads.
+	// The scene, camera and images should not be destroyed or modified until the render is done.
+	// @param tileCallback     [in] Called by a render thread after each tile is written. Can be null.
+	// @param callbackUserData [in] Passed to tileCallback.
+	// @return Handle to query and control the render. Destroy it by Raylib_DestroyRender().
+	RAYLIB_API RenderHandle Raylib_RenderAsync(
+		const RendererSettings* settings,
+		SceneHandle  scene,
+		CameraHandle camera,
+		ImageHandle  outMainImage,
+		const ImageHandle* outAOVImages,
+		RenderTileCallback tileCallback,
+		void* callbackUserData);
+
+	// @return Ratio of finished tiles in [0, 1]. Skipped tiles of a cancelled render count as finished.
+	RAYLIB_API float Raylib_GetRenderProgress(RenderHandle render);
+
+	// Block until the render is done or the timeout expires.
+	// @param timeoutMilliseconds [in] Negative to wait without timeout.
+	// @return 1 if the render is done (finished or cancelled), 0 if timed out.
+	RAYLIB_API int32_t Raylib_WaitRender(RenderHandle render, int32_t timeoutMilliseconds);
+
+	// Stop the render at tile boundaries. Tiles being rendered are finished and others are left as they are.
+	// Returns immediately; wait for the render to be done before using the images.
+	RAYLIB_API void Raylib_CancelRender(RenderHandle render);
+
+	// Cancel the render if it is not done, wait for render threads and release the handle.
+	// Should not be called from tileCallback, as it joins the thread calling it.
+	// @return 1 if successful, 0 otherwise.
+	RAYLIB_API int32_t Raylib_DestroyRender(RenderHandle render);
+
+	// Render several views of one scene at once, e.g., turntables or multi-camera shots.
+	// Tiles of all views are scheduled in one job queue, so cores are kept busy across views.
+	// Returns when all views are done. Each view works like Raylib_RenderWithAOVs().
+	// @param numViews      [in] Number of views.
+	// @param settings      [in] Array of numViews settings.
+	// @param cameras       [in] Array of numViews cameras.
+	// @param outMainImages [out] Array of numViews images. Views should not share images.
+	// @param outAOVImages  [out] Null, or array of (numViews * RAYLIB_AOV_MAX) images;
+	//                            RAYLIB_AOV_MAX consecutive images for each view.
+	RAYLIB_API void Raylib_RenderViews(
+		SceneHandle scene,
+		int32_t numViews,
+		const RendererSettings* settings,
+		const CameraHandle* cameras,
+		const ImageHandle* outMainImages,
+		const ImageHandle* outAOVImages);
+
+	// Same as Raylib_RenderWithAOVs(), but renders in passes and keeps the accumulated samples
+	// in a checkpoint file, so a long render can be resumed after a crash or preemption.
+	// If checkpointPath has a checkpoint made with the same settings (except samplesPerPixel),
+	// only the samples it doesn't have yet are rendered. Calling again with a larger samplesPerPixel
+	// adds samples to a finished image. The scene and camera are not checked; keep them the same.
+	// The crop window can differ between calls; each pixel keeps its own sample count.
+	// @param outAOVImages              [out] Can be null. AOVs are kept in the checkpoint as well.
+	// @param checkpointPath            [in] Checkpoint file to resume from and to write.
+	// @param checkpointIntervalSeconds [in] Minimum time between checkpoints. Always written at the end.
+	// @return Samples per pixel rendered by this call, or -1 if a checkpoint could not be written.
+	RAYLIB_API int32_t Raylib_RenderWithCheckpoints(
+		const RendererSettings* settings,
+		SceneHandle  scene,
+		CameraHandle camera,
+		ImageHandle  outMainImage,
+		const ImageHandle* outAOVImages,
+		const char*  checkpointPath,
+		float        checkpointIntervalSeconds);
+
+	// Denoise a noisy path traced image using Intel OpenImageDenoise,
+	// or a built-in edge-avoiding filter where oidn is not integrated.
 	// You can provide optional aux images (albedo and normal) for better quality.
 	// @param inMainImage      [in] Noisy path traced image.
 	// @param bMainImageHDR    [in] 1 if the main image has HDR values, 0 otherwise.
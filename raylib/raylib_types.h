@@ -15,6 +15,10 @@ typedef uintptr_t ImageHandle;
 typedef uintptr_t SceneHandle;
 typedef uintptr_t SceneElementHandle;
 typedef uintptr_t CameraHandle;
+typedef uintptr_t RenderHandle;
+
+// Called by a render thread after the pixels of the tile [x, x + width) * [y, y + height) are written.
+typedef void (*RenderTileCallback)(void* userData, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 
 enum ERenderMode
 {
@@ -29,6 +33,51 @@ enum ERenderMode
 	RAYLIB_RENDERMODE_MAX
 };
 
+// Only relevant to RAYLIB_RENDERMODE_Default.
+enum EIntegrator
+{
+	RAYLIB_INTEGRATOR_Megakernel = 0, // Recursive path tracing, one path at a time per thread.
+	RAYLIB_INTEGRATOR_Wavefront  = 1, // Batches of paths are processed in stages (intersect, sort, shade, ...)
+
+	RAYLIB_INTEGRATOR_MAX
+};
+
+// Arbitrary output variables. Filled from the same primary hits as the main image
+// if (1 << EAOV) is set in RendererSettings::aovMask. Misses write zero.
+// Albedo and normal are averaged over the samples of each pixel; others are from the first sample.
+enum EAOV
+{
+	RAYLIB_AOV_Albedo     = 0, // First-hit albedo. Mirror-like surfaces show what they reflect.
+	RAYLIB_AOV_Normal     = 1, // First-hit microsurface normal in world space. In [-1, 1], not encoded as a color.
+	RAYLIB_AOV_Depth      = 2, // Distance from the camera to the first hit.
+	RAYLIB_AOV_ObjectID   = 3, // Index of the scene element, starting from 1.
+	RAYLIB_AOV_MaterialID = 4, // Index of the material in the scene, starting from 1.
+
+	RAYLIB_AOV_MAX
+};
+
+// Source of random numbers for path tracing.
+enum ESampler
+{
+	RAYLIB_SAMPLER_Independent = 0, // White noise.
+	RAYLIB_SAMPLER_Sobol       = 1, // Owen-scrambled Sobol. Stratified across the samples of each pixel.
+
+	RAYLIB_SAMPLER_MAX
+};
+
+// Instruction set of the hot kernels (ray packet tests, tone mapping).
+// All levels produce identical images.
+enum ESIMDLevel
+{
+	RAYLIB_SIMD_Auto    = 0, // Best level supported by the CPU.
+	RAYLIB_SIMD_Generic = 1, // Baseline of the build.
+	RAYLIB_SIMD_SSE42   = 2,
+	RAYLIB_SIMD_AVX2    = 3,
+	RAYLIB_SIMD_AVX512  = 4,
+
+	RAYLIB_SIMD_MAX
+};
+
 enum EImageFileType
 {
 	RAYLIB_IMAGEFILETYPE_Bitmap = 0,
@@ -42,16 +91,55 @@ struct RendererSettings {
 	// Camera properties
 	uint32_t             viewportWidth;
 	uint32_t             viewportHeight;
+	// Only pixels in [cropX, cropX + cropWidth) * [cropY, cropY + cropHeight) are rendered and written.
+	// Zero cropWidth or cropHeight means the whole viewport. Camera projection still covers the whole viewport.
+	uint32_t             cropX           = 0;
+	uint32_t             cropY           = 0;
+	uint32_t             cropWidth       = 0;
+	uint32_t             cropHeight      = 0;
 
 	// Path tracing options
 	int32_t              samplesPerPixel;
 	int32_t              maxPathLength;
 	float                rayTMin;
+	// Paths may be terminated by Russian roulette after this many bounces. Negative disables it.
+	int32_t              russianRouletteDepth = 3;
+	// Random numbers only depend on (pixel, sample, dimension) and this seed,
+	// so the same seed reproduces the same image.
+	uint32_t             seed = 0;
+	// Render sample indices [firstSample, firstSample + samplesPerPixel) of each pixel.
+	// Renders of disjoint sample ranges can be merged by weighting each by its samplesPerPixel.
+	int32_t              firstSample = 0;
 
 	// System values
 	uint32_t             renderMode      = ERenderMode::RAYLIB_RENDERMODE_Default;
+	uint32_t             integrator      = EIntegrator::RAYLIB_INTEGRATOR_Megakernel;
+	uint32_t             sampler         = ESampler::RAYLIB_SAMPLER_Sobol;
+	// Bitmask of (1 << EAOV). Only used by RAYLIB_RENDERMODE_Default.
+	uint32_t             aovMask         = 0;
+	// Number of render threads. 0 means the cores this process can use
+	// (affinity mask, limited by the cgroup CPU quota), not all cores of the host.
+	uint32_t             numThreads      = 0;
+	// If nonzero, each render thread is pinned to its own core, alternating between NUMA nodes.
+	uint32_t             pinThreads      = 0;
+	// Core slot of the first render thread if pinned. Processes sharing a host
+	// use disjoint ranges of slots so that their threads don't pin to the same cores.
+	uint32_t             pinSlotOffset   = 0;
 
 	inline float getViewportAspectWH() const {
 		return (float)viewportWidth / (float)viewportHeight;
 	}
+	// Crop window clamped to the viewport. Can be empty.
+	inline void getCropRect(uint32_t& outX, uint32_t& outY, uint32_t& outWidth, uint32_t& outHeight) const {
+		if (cropWidth == 0 || cropHeight == 0) {
+			outX = outY = 0;
+			outWidth = viewportWidth;
+			outHeight = viewportHeight;
+			return;
+		}
+		outX = (cropX < viewportWidth) ? cropX : viewportWidth;
+		outY = (cropY < viewportHeight) ? cropY : viewportHeight;
+		outWidth = (cropWidth < viewportWidth - outX) ? cropWidth : (viewportWidth - outX);
+		outHeight = (cropHeight < viewportHeight - outY) ? cropHeight : (viewportHeight - outY);
+	}
 };
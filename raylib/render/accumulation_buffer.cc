@@ -0,0 +1,280 @@
+#include "accumulation_buffer.h"
+#include "render/image.h"
+#include "core/assertion.h"
+#include "core/logger.h"
+
+#include <algorithm>
+#include <string>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC   0x4B434C52 // 'RLCK'
+#define CHECKPOINT_VERSION 2
+
+// Store sums tile by tile instead of row by row, so that the sums of a tile are contiguous.
+// Checkpoints are only compatible with the same layout.
+#define ACCUMULATION_TILED_LAYOUT 0
+#define ACCUMULATION_TILE_SIZE    8
+
+STATIC_ASSERT(sizeof(vec3) == 3 * sizeof(float));
+
+// Followed by
+// - float[3 * numPixels] radiance sums
+// - uint32[numPixels]    sample counts
+// - float[3 * numPixels] for each AOV in aovMask, in the order of EAOV
+// numPixels includes the padding of the tiled layout.
+struct CheckpointHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 tileSize; // 0 if row-major
+	// Settings that affect the image.
+	uint32 viewportWidth;
+	uint32 viewportHeight;
+	int32  maxPathLength;
+	float  rayTMin;
+	int32  russianRouletteDepth;
+	uint32 seed;
+	int32  firstSample;
+	uint32 renderMode;
+	uint32 sampler;
+	uint32 aovMask;
+};
+
+static CheckpointHeader MakeCheckpointHeader(const RendererSettings& settings)
+{
+	CheckpointHeader header;
+	header.magic                = CHECKPOINT_MAGIC;
+	header.version              = CHECKPOINT_VERSION;
+	header.tileSize             = ACCUMULATION_TILED_LAYOUT ? ACCUMULATION_TILE_SIZE : 0;
+	header.viewportWidth        = settings.viewportWidth;
+	header.viewportHeight       = settings.viewportHeight;
+	header.maxPathLength        = settings.maxPathLength;
+	header.rayTMin              = settings.rayTMin;
+	header.russianRouletteDepth = settings.russianRouletteDepth;
+	header.seed                 = settings.seed;
+	header.firstSample          = settings.firstSample;
+	header.renderMode           = settings.renderMode;
+	header.sampler              = settings.sampler;
+	header.aovMask              = settings.aovMask;
+	return header;
+}
+
+static bool IsAveragedAOV(int32 aov)
+{
+	return aov == RAYLIB_AOV_Albedo || aov == RAYLIB_AOV_Normal;
+}
+
+size_t AccumulationBuffer::PixelIndex(uint32 x, uint32 y) const
+{
+#if ACCUMULATION_TILED_LAYOUT
+	const uint32 numTilesX = (settings.viewportWidth + ACCUMULATION_TILE_SIZE - 1) / ACCUMULATION_TILE_SIZE;
+	const uint32 tileIx = (y / ACCUMULATION_TILE_SIZE) * numTilesX + (x / ACCUMULATION_TILE_SIZE);
+	const uint32 inTileIx = (y % ACCUMULATION_TILE_SIZE) * ACCUMULATION_TILE_SIZE + (x % ACCUMULATION_TILE_SIZE);
+	return (size_t)tileIx * (ACCUMULATION_TILE_SIZE * ACCUMULATION_TILE_SIZE) + inTileIx;
+#else
+	return (size_t)y * settings.viewportWidth + x;
+#endif
+}
+
+void AccumulationBuffer::Reset(const RendererSettings& inSettings)
+{
+	settings = inSettings;
+#if ACCUMULATION_TILED_LAYOUT
+	const size_t numTilesX = (settings.viewportWidth + ACCUMULATION_TILE_SIZE - 1) / ACCUMULATION_TILE_SIZE;
+	const size_t numTilesY = (settings.viewportHeight + ACCUMULATION_TILE_SIZE - 1) / ACCUMULATION_TILE_SIZE;
+	const size_t numPixels = numTilesX * numTilesY * ACCUMULATION_TILE_SIZE * ACCUMULATION_TILE_SIZE;
+#else
+	const size_t numPixels = (size_t)settings.viewportWidth * settings.viewportHeight;
+#endif
+	radianceSum.assign(numPixels, vec3(0.0f));
+	sampleCount.assign(numPixels, 0);
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		aovSum[aov].assign(IsAOVRequested(aov) ? numPixels : 0, vec3(0.0f));
+	}
+}
+
+void AccumulationBuffer::AddSamples(
+	const RendererSettings& passSettings,
+	const Image2D* mainImage,
+	Image2D* const* aovImages)
+{
+	CHECK(mainImage != nullptr);
+	CHECK(mainImage->GetWidth() == settings.viewportWidth && mainImage->GetHeight() == settings.viewportHeight);
+
+	uint32 cropX, cropY, cropWidth, cropHeight;
+	passSettings.getCropRect(cropX, cropY, cropWidth, cropHeight);
+
+	const int32 numSamples = passSettings.samplesPerPixel;
+	const int32 prevSamples = passSettings.firstSample - settings.firstSample;
+	const float weight = (float)numSamples;
+	for (int32 y = (int32)cropY; y < (int32)(cropY + cropHeight); ++y)
+	{
+		for (int32 x = (int32)cropX; x < (int32)(cropX + cropWidth); ++x)
+		{
+			const size_t i = PixelIndex((uint32)x, (uint32)y);
+			if ((int32)sampleCount[i] != prevSamples)
+			{
+				continue;
+			}
+			Pixel px = mainImage->GetPixel(x, y);
+			radianceSum[i] += weight * vec3(px.r, px.g, px.b);
+
+			for (int32 aov = 0; aov < RAYLIB_AOV_MAX && aovImages != nullptr; ++aov)
+			{
+				if (!IsAOVRequested(aov))
+				{
+					continue;
+				}
+				Pixel value = aovImages[aov]->GetPixel(x, y);
+				if (IsAveragedAOV(aov))
+				{
+					aovSum[aov][i] += weight * vec3(value.r, value.g, value.b);
+				}
+				else if (sampleCount[i] == 0)
+				{
+					aovSum[aov][i] = vec3(value.r, value.g, value.b);
+				}
+			}
+
+			sampleCount[i] += (uint32)numSamples;
+		}
+	}
+}
+
+int32 AccumulationBuffer::GetNextSample(const RendererSettings& passSettings) const
+{
+	uint32 cropX, cropY, cropWidth, cropHeight;
+	passSettings.getCropRect(cropX, cropY, cropWidth, cropHeight);
+
+	uint32 minCount = 0xffffffff;
+	for (uint32 y = cropY; y < cropY + cropHeight; ++y)
+	{
+		for (uint32 x = cropX; x < cropX + cropWidth; ++x)
+		{
+			minCount = std::min(minCount, sampleCount[PixelIndex(x, y)]);
+		}
+	}
+	if (minCount == 0xffffffff)
+	{
+		minCount = 0; // Empty crop window
+	}
+	return settings.firstSample + (int32)minCount;
+}
+
+void AccumulationBuffer::Resolve(Image2D* outMainImage, Image2D* const* outAOVImages) const
+{
+	const uint32 width = settings.viewportWidth;
+	const uint32 height = settings.viewportHeight;
+
+	auto WriteImage = [&](Image2D* image, const std::vector<vec3>& values, bool bAverage, bool bNormalize) {
+		if (image->GetWidth() != width || image->GetHeight() != height)
+		{
+			image->Reallocate(width, height);
+		}
+		for (uint32 y = 0; y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const size_t i = PixelIndex(x, y);
+				if (sampleCount[i] == 0)
+				{
+					continue;
+				}
+				vec3 v = values[i];
+				if (bAverage)
+				{
+					v /= (float)std::max(1u, sampleCount[i]);
+				}
+				if (bNormalize && v.LengthSquared() > 0.0f)
+				{
+					v.Normalize();
+				}
+				image->SetPixel(x, y, Pixel(v.x, v.y, v.z));
+			}
+		}
+	};
+
+	WriteImage(outMainImage, radianceSum, true, false);
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX && outAOVImages != nullptr; ++aov)
+	{
+		if (IsAOVRequested(aov))
+		{
+			WriteImage(outAOVImages[aov], aovSum[aov], IsAveragedAOV(aov), aov == RAYLIB_AOV_Normal);
+		}
+	}
+}
+
+bool AccumulationBuffer::SaveCheckpoint(const char* filepath) const
+{
+	std::string tempPath = std::string(filepath) + ".tmp";
+	FILE* fp = fopen(tempPath.c_str(), "wb");
+	if (fp == nullptr)
+	{
+		LOG("%s: can't open %s", __FUNCTION__, tempPath.c_str());
+		return false;
+	}
+
+	const CheckpointHeader header = MakeCheckpointHeader(settings);
+	bool bWritten = fwrite(&header, sizeof(header), 1, fp) == 1;
+	bWritten = bWritten && fwrite(radianceSum.data(), sizeof(vec3), radianceSum.size(), fp) == radianceSum.size();
+	bWritten = bWritten && fwrite(sampleCount.data(), sizeof(uint32), sampleCount.size(), fp) == sampleCount.size();
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		bWritten = bWritten && fwrite(aovSum[aov].data(), sizeof(vec3), aovSum[aov].size(), fp) == aovSum[aov].size();
+	}
+	bWritten = (fclose(fp) == 0) && bWritten;
+
+	if (!bWritten)
+	{
+		LOG("%s: failed to write %s", __FUNCTION__, tempPath.c_str());
+		remove(tempPath.c_str());
+		return false;
+	}
+	// rename() can't overwrite on Windows.
+	remove(filepath);
+	if (rename(tempPath.c_str(), filepath) != 0)
+	{
+		LOG("%s: can't rename %s to %s", __FUNCTION__, tempPath.c_str(), filepath);
+		return false;
+	}
+	return true;
+}
+
+bool AccumulationBuffer::LoadCheckpoint(const char* filepath, const RendererSettings& inSettings)
+{
+	FILE* fp = fopen(filepath, "rb");
+	if (fp == nullptr)
+	{
+		return false;
+	}
+
+	CheckpointHeader header;
+	const CheckpointHeader expected = MakeCheckpointHeader(inSettings);
+	bool bValid = fread(&header, sizeof(header), 1, fp) == 1
+		&& memcmp(&header, &expected, sizeof(header)) == 0;
+	if (!bValid)
+	{
+		LOG("%s: %s is not a checkpoint of the current settings", __FUNCTION__, filepath);
+		fclose(fp);
+		return false;
+	}
+
+	Reset(inSettings);
+	bValid = fread(radianceSum.data(), sizeof(vec3), radianceSum.size(), fp) == radianceSum.size();
+	bValid = bValid && fread(sampleCount.data(), sizeof(uint32), sampleCount.size(), fp) == sampleCount.size();
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		bValid = bValid && fread(aovSum[aov].data(), sizeof(vec3), aovSum[aov].size(), fp) == aovSum[aov].size();
+	}
+	fclose(fp);
+
+	if (!bValid)
+	{
+		LOG("%s: %s is truncated", __FUNCTION__, filepath);
+		Reset(inSettings);
+		return false;
+	}
+	return true;
+}
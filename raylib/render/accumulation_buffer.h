@@ -0,0 +1,58 @@
+#pragma once
+
+#include "raylib_types.h"
+#include "core/int_types.h"
+#include "core/vec3.h"
+
+#include <vector>
+
+class Image2D;
+
+// Running sums of the sample ranges rendered so far, per pixel.
+// Can be saved to a checkpoint file and restored to continue the render later.
+// Pixels can have different sample counts when crop windows differ between renders.
+//
+// Samplers only depend on (pixel, sample index, seed), so the sample count of a pixel
+// is all the sampler state needed: the next range starts at settings.firstSample + count.
+class AccumulationBuffer
+{
+
+public:
+	// Clear all sums for a render with the given settings.
+	// settings.samplesPerPixel is ignored; ranges can be added indefinitely.
+	void Reset(const RendererSettings& inSettings);
+
+	// Add a render of the sample range [firstSample, firstSample + samplesPerPixel) of passSettings,
+	// for the pixels in its crop window. mainImage is the average of the range, as written by Renderer::RenderScene().
+	// A pixel only takes the range if it directly follows the samples the pixel already has.
+	// @param aovImages Null or indexed by EAOV. Used if requested by settings.aovMask.
+	void AddSamples(
+		const RendererSettings& passSettings,
+		const Image2D* mainImage,
+		Image2D* const* aovImages);
+
+	// Start of the next sample range to render in the crop window of passSettings;
+	// the least accumulated pixel decides it.
+	int32 GetNextSample(const RendererSettings& passSettings) const;
+
+	// Write averages of the pixels that have any sample; others are left as they are.
+	// Images are reallocated if they are not of the viewport size.
+	void Resolve(Image2D* outMainImage, Image2D* const* outAOVImages) const;
+
+	// The file is replaced only after it has been completely written.
+	bool SaveCheckpoint(const char* filepath) const;
+
+	// @return false if the file does not exist, is broken,
+	//         or was saved with settings that would give a different image than inSettings.
+	bool LoadCheckpoint(const char* filepath, const RendererSettings& inSettings);
+
+private:
+	// Index of the pixel in the sums; see ACCUMULATION_TILED_LAYOUT.
+	size_t PixelIndex(uint32 x, uint32 y) const;
+	inline bool IsAOVRequested(int32 aov) const { return (settings.aovMask & (1u << aov)) != 0; }
+
+	RendererSettings settings;
+	std::vector<vec3> radianceSum;
+	std::vector<uint32> sampleCount;
+	std::vector<vec3> aovSum[RAYLIB_AOV_MAX]; // Albedo and normal are sums; others are from the first sample.
+};
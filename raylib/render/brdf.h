@@ -2,6 +2,9 @@
 
 #include "core/int_types.h"
 #include "core/vec3.h"
+#include "core/vec4.h"
+
+#include <algorithm>
 
 namespace BRDF {
 
@@ -15,6 +18,10 @@ namespace BRDF {
 		return F0 + (1.0f - F0) * pow(1.0f - cosTheta, 5.0f);
 	}
 
+	inline vec4 FresnelSchlick(float cosTheta, const vec4& F0) {
+		return F0 + (1.0f - F0) * pow(1.0f - cosTheta, 5.0f);
+	}
+
 	inline vec3 FresnelSchlickRoughness(float cosTheta, const vec3& F0, float roughness) {
 		return F0 + (max(vec3(1.0f - roughness), F0) - F0) * pow(1.0f - cosTheta, 5.0f);
 	}
@@ -114,6 +121,70 @@ namespace BRDF {
 		return 1.0f / (1.0f + ggx1 * ggx2);
 	}
 
+	// -------------------------------
+	// GGX (Trowbridge-Reitz) in the local shading frame; the surface normal is +Z.
+	// https://jcgt.org/published/0007/04/01/ (Sampling the GGX Distribution of Visible Normals)
+
+	// Keeps D() finite for perfectly smooth surfaces.
+	const float GGX_MIN_ALPHA = 0.001f;
+
+	inline float RoughnessToAlphaGGX(float roughness) {
+		return std::max(roughness * roughness, GGX_MIN_ALPHA);
+	}
+
+	inline float DistributionGGX_Local(const vec3& H, float alpha) {
+		if (H.z <= 0.0f) {
+			return 0.0f;
+		}
+		float a2 = alpha * alpha;
+		float denom = H.z * H.z * (a2 - 1.0f) + 1.0f;
+		return a2 / (PI * denom * denom);
+	}
+
+	// Smith's auxiliary function; G1(W) = 1 / (1 + Lambda(W))
+	inline float LambdaGGX(const vec3& W, float alpha) {
+		float cos2 = W.z * W.z;
+		if (cos2 <= 0.0f) {
+			return 0.0f;
+		}
+		float tan2 = std::max(0.0f, 1.0f - cos2) / cos2;
+		return 0.5f * (sqrtf(1.0f + alpha * alpha * tan2) - 1.0f);
+	}
+
+	// Height-correlated masking-shadowing
+	inline float GeometrySmith_GGX(const vec3& Wo, const vec3& Wi, float alpha) {
+		return 1.0f / (1.0f + LambdaGGX(Wo, alpha) + LambdaGGX(Wi, alpha));
+	}
+
+	// Sample a microfacet normal visible from Wo (Wo.z > 0). (u0, u1) in [0, 1)^2.
+	inline vec3 SampleVisibleNormalGGX(const vec3& Wo, float alpha, float u0, float u1) {
+		// Stretch to the hemisphere configuration
+		vec3 Vh = normalize(vec3(alpha * Wo.x, alpha * Wo.y, Wo.z));
+		float lensq = Vh.x * Vh.x + Vh.y * Vh.y;
+		vec3 T1 = (lensq > 0.0f) ? vec3(-Vh.y, Vh.x, 0.0f) / sqrtf(lensq) : vec3(1.0f, 0.0f, 0.0f);
+		vec3 T2 = cross(Vh, T1);
+		// Uniform disk, warped to the projected visible hemisphere
+		float r = sqrtf(u0);
+		float phi = 2.0f * PI * u1;
+		float t1 = r * cosf(phi);
+		float t2 = r * sinf(phi);
+		float s = 0.5f * (1.0f + Vh.z);
+		t2 = (1.0f - s) * sqrtf(std::max(0.0f, 1.0f - t1 * t1)) + s * t2;
+		vec3 Nh = t1 * T1 + t2 * T2 + sqrtf(std::max(0.0f, 1.0f - t1 * t1 - t2 * t2)) * Vh;
+		// Unstretch
+		return normalize(vec3(alpha * Nh.x, alpha * Nh.y, std::max(0.0f, Nh.z)));
+	}
+
+	// Pdf of SampleVisibleNormalGGX() choosing H, converted to the reflected direction reflect(-Wo, H).
+	inline float PdfVisibleNormalGGX_Reflected(const vec3& Wo, const vec3& H, float alpha) {
+		if (Wo.z <= 0.0f || dot(Wo, H) <= 0.0f) {
+			return 0.0f;
+		}
+		// D_Wo(H) / (4 * dot(Wo, H)) = G1(Wo) * D(H) / (4 * Wo.z)
+		float G1 = 1.0f / (1.0f + LambdaGGX(Wo, alpha));
+		return G1 * DistributionGGX_Local(H, alpha) / (4.0f * Wo.z);
+	}
+
 };
 
 // #todo-pbr: Support generic BxDF (BRDF + BTDF)
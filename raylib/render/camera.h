@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/random.h"
+#include "core/sampler.h"
 #include "geom/ray.h"
 
 #include <math.h>
@@ -43,9 +44,25 @@ public:
 	// s, t: Relative viewport coords in [0.0, 1.0)
 	ray GetCameraRay(float s, float t) const
 	{
-		vec3 rd     = lensRadius * RandomInUnitDisk();
-		vec3 offset = (u * rd.x) + (v * rd.y);
-		float captureTime = beginTime + timePeriod * Random();
+		vec3 lensSample = RandomInUnitDisk();
+		return GetCameraRay(s, t, lensSample.x, lensSample.y, Random());
+	}
+
+	// Lens position and capture time are drawn from the sampler (3 dimensions).
+	ray GetCameraRay(float s, float t, Sampler& sampler) const
+	{
+		float u0, u1;
+		sampler.Get2D(u0, u1);
+		vec3 lensSample = SampleUnitDisk(u0, u1);
+		return GetCameraRay(s, t, lensSample.x, lensSample.y, sampler.Get1D());
+	}
+
+	// lensX, lensY: Position in the unit disk
+	// timeU: Relative capture time in [0.0, 1.0)
+	ray GetCameraRay(float s, float t, float lensX, float lensY, float timeU) const
+	{
+		vec3 offset = lensRadius * ((u * lensX) + (v * lensY));
+		float captureTime = beginTime + timePeriod * timeU;
 
 		vec3 rayO = origin + offset;
 		vec3 rayD = normalize(top_left + s * horizontal + (1.0f - t) * vertical - origin - offset);
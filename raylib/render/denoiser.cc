@@ -0,0 +1,272 @@
+#include "denoiser.h"
+#include "render/image.h"
+#include "core/thread_pool.h"
+#include "core/cpu_affinity.h"
+#include "core/assertion.h"
+#include "core/aligned_allocator.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#define ATROUS_ITERATIONS    5
+#define ATROUS_SIGMA_LUMA    4.0f
+#define ATROUS_SIGMA_NORMAL  128.0f
+// Rows processed by each work item.
+#define ATROUS_ROWS_PER_WORK 16
+// Albedo below this is not demodulated.
+#define ATROUS_ALBEDO_EPSILON 0.001f
+
+// Each pixel is one SSE register: (r, g, b, variance of luminance)
+// Wrapped as attributes of __m128 are dropped when it is a template argument.
+struct alignas(16) SIMDPixel
+{
+	__m128 v;
+};
+using PixelBuffer = std::vector<SIMDPixel, AlignedAllocator<SIMDPixel, 16>>;
+
+static const float B3SplineKernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+static inline float Luminance(__m128 v)
+{
+	alignas(16) float c[4];
+	_mm_store_ps(c, v);
+	return 0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2];
+}
+
+static inline float Dot3(__m128 a, __m128 b)
+{
+	alignas(16) float c[4];
+	_mm_store_ps(c, _mm_mul_ps(a, b));
+	return c[0] + c[1] + c[2];
+}
+
+static inline float GetVariance(__m128 v)
+{
+	return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+// Run fn(y) for all rows in [0, height) on all cores.
+template<typename Fn>
+static void ParallelForRows(int32 height, Fn fn)
+{
+	const int32 numWorks = (height + ATROUS_ROWS_PER_WORK - 1) / ATROUS_ROWS_PER_WORK;
+	const int32 numThreads = std::max(1, std::min(numWorks, (int32)GetNumUsableCores()));
+
+	std::vector<int32> firstRows(numWorks);
+	ThreadPool tp;
+	tp.Initialize(numThreads);
+	for (int32 i = 0; i < numWorks; ++i)
+	{
+		firstRows[i] = i * ATROUS_ROWS_PER_WORK;
+		ThreadPoolWork work;
+		work.routine = [&fn, height](const WorkItemParam* param) {
+			const int32 beginY = *reinterpret_cast<const int32*>(param->arg);
+			const int32 endY = std::min(height, beginY + ATROUS_ROWS_PER_WORK);
+			for (int32 y = beginY; y < endY; ++y)
+			{
+				fn(y);
+			}
+		};
+		work.arg = &firstRows[i];
+		tp.AddWork(work);
+	}
+	constexpr bool blockingOperation = true;
+	tp.Start(blockingOperation);
+}
+
+bool DenoiseATrous(
+	const Image2D* mainImage,
+	const Image2D* albedoImage,
+	const Image2D* normalImage,
+	Image2D* outDenoisedImage)
+{
+	CHECK(mainImage != nullptr && outDenoisedImage != nullptr);
+
+	const int32 width = (int32)mainImage->GetWidth();
+	const int32 height = (int32)mainImage->GetHeight();
+	auto IsSameExtent = [&](const Image2D* img) {
+		return img == nullptr || ((int32)img->GetWidth() == width && (int32)img->GetHeight() == height);
+	};
+	if (!IsSameExtent(albedoImage) || !IsSameExtent(normalImage))
+	{
+		return false;
+	}
+	const int32 numPixels = width * height;
+
+	// Demodulate albedo.
+	PixelBuffer demodulation(numPixels, SIMDPixel{ _mm_set1_ps(1.0f) });
+	if (albedoImage != nullptr)
+	{
+		const __m128 epsilon = _mm_set1_ps(ATROUS_ALBEDO_EPSILON);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const PixelArray& albedo = albedoImage->GetPixelArray();
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			__m128 a = _mm_setr_ps(albedo[i].r, albedo[i].g, albedo[i].b, 1.0f);
+			// Keep 1.0 where albedo is too small.
+			__m128 mask = _mm_cmpgt_ps(a, epsilon);
+			demodulation[i].v = _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, one));
+		}
+	}
+
+	PixelBuffer normals;
+	if (normalImage != nullptr)
+	{
+		normals.resize(numPixels);
+		const PixelArray& N = normalImage->GetPixelArray();
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			normals[i].v = _mm_setr_ps(N[i].r, N[i].g, N[i].b, 0.0f);
+		}
+	}
+
+	PixelBuffer current(numPixels), next(numPixels);
+	{
+		const PixelArray& color = mainImage->GetPixelArray();
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			__m128 c = _mm_setr_ps(color[i].r, color[i].g, color[i].b, 0.0f);
+			current[i].v = _mm_div_ps(c, demodulation[i].v);
+		}
+	}
+
+	// Weight of normals, or -1 if only one of them is a valid normal.
+	auto NormalWeight = [&normals](int32 p, int32 q) -> float {
+		if (normals.size() == 0)
+		{
+			return 1.0f;
+		}
+		const bool bHasNormalP = Dot3(normals[p].v, normals[p].v) > 0.5f;
+		const bool bHasNormalQ = Dot3(normals[q].v, normals[q].v) > 0.5f;
+		if (bHasNormalP != bHasNormalQ)
+		{
+			return -1.0f;
+		}
+		return bHasNormalP ? std::pow(std::max(0.0f, Dot3(normals[p].v, normals[q].v)), ATROUS_SIGMA_NORMAL) : 1.0f;
+	};
+
+	// Initial variance of luminance, estimated from differences of adjacent pixels in the 3x3 neighborhood.
+	// Only pixels on the same surface are used, and the smaller of the horizontal and vertical estimates
+	// is taken, otherwise geometric and shading edges are mistaken for noise.
+	ParallelForRows(height, [&](int32 y) {
+		for (int32 x = 0; x < width; ++x)
+		{
+			const int32 p = y * width + x;
+			auto IsValidNeighbor = [&](int32 qx, int32 qy) {
+				return qx >= 0 && qy >= 0 && qx < width && qy < height && NormalWeight(p, qy * width + qx) >= 0.5f;
+			};
+			// [0] horizontal pairs, [1] vertical pairs
+			float sumSqDiff[2] = { 0.0f, 0.0f };
+			int32 numPairs[2] = { 0, 0 };
+			for (int32 a = -1; a <= 1; ++a)
+			{
+				for (int32 b = -1; b <= 0; ++b)
+				{
+					if (IsValidNeighbor(x + b, y + a) && IsValidNeighbor(x + b + 1, y + a))
+					{
+						float d = Luminance(current[(y + a) * width + x + b].v) - Luminance(current[(y + a) * width + x + b + 1].v);
+						sumSqDiff[0] += d * d;
+						numPairs[0] += 1;
+					}
+					if (IsValidNeighbor(x + a, y + b) && IsValidNeighbor(x + a, y + b + 1))
+					{
+						float d = Luminance(current[(y + b) * width + x + a].v) - Luminance(current[(y + b + 1) * width + x + a].v);
+						sumSqDiff[1] += d * d;
+						numPairs[1] += 1;
+					}
+				}
+			}
+			// E[(X - Y)^2] = 2 * Var[X] for independent X and Y.
+			float variance = 0.0f;
+			if (numPairs[0] > 0 && numPairs[1] > 0)
+			{
+				variance = 0.5f * std::min(sumSqDiff[0] / numPairs[0], sumSqDiff[1] / numPairs[1]);
+			}
+			else if (numPairs[0] > 0 || numPairs[1] > 0)
+			{
+				variance = 0.5f * (sumSqDiff[0] + sumSqDiff[1]) / (numPairs[0] + numPairs[1]);
+			}
+			alignas(16) float c[4];
+			_mm_store_ps(c, current[p].v);
+			next[p].v = _mm_setr_ps(c[0], c[1], c[2], variance);
+		}
+	});
+	std::swap(current, next);
+
+	for (int32 iteration = 0; iteration < ATROUS_ITERATIONS; ++iteration)
+	{
+		const int32 step = 1 << iteration;
+		ParallelForRows(height, [&](int32 y) {
+			for (int32 x = 0; x < width; ++x)
+			{
+				const int32 p = y * width + x;
+				const __m128 centerColor = current[p].v;
+				const float centerLuma = Luminance(centerColor);
+
+				// Variance prefiltered by a 3x3 box, as a single pixel estimate is noisy itself.
+				float variance = 0.0f;
+				int32 count = 0;
+				for (int32 dy = -1; dy <= 1; ++dy)
+				{
+					for (int32 dx = -1; dx <= 1; ++dx)
+					{
+						int32 qx = x + dx, qy = y + dy;
+						if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+						variance += GetVariance(current[qy * width + qx].v);
+						++count;
+					}
+				}
+				// Tighter for larger steps, as distant pixels are less likely to share the signal.
+				const float lumaScale = (float)step / (ATROUS_SIGMA_LUMA * std::sqrt(variance / count) + 1e-4f);
+
+				__m128 sum = _mm_setzero_ps();
+				float sumWeight = 0.0f;
+				for (int32 ky = 0; ky < 5; ++ky)
+				{
+					const int32 qy = y + (ky - 2) * step;
+					if (qy < 0 || qy >= height) continue;
+					for (int32 kx = 0; kx < 5; ++kx)
+					{
+						const int32 qx = x + (kx - 2) * step;
+						if (qx < 0 || qx >= width) continue;
+						const int32 q = qy * width + qx;
+						const __m128 color = current[q].v;
+
+						const float normalWeight = NormalWeight(p, q);
+						if (normalWeight <= 0.0f)
+						{
+							continue;
+						}
+						float weight = B3SplineKernel[kx] * B3SplineKernel[ky] * normalWeight;
+						weight *= std::exp(-std::abs(centerLuma - Luminance(color)) * lumaScale);
+
+						// Color is weighted by w, variance by w^2.
+						sum = _mm_add_ps(sum, _mm_mul_ps(color, _mm_setr_ps(weight, weight, weight, weight * weight)));
+						sumWeight += weight;
+					}
+				}
+
+				// The center tap always has a positive weight.
+				const float invWeight = 1.0f / sumWeight;
+				next[p].v = _mm_mul_ps(sum, _mm_setr_ps(invWeight, invWeight, invWeight, invWeight * invWeight));
+			}
+		});
+		std::swap(current, next);
+	}
+
+	outDenoisedImage->Reallocate((uint32)width, (uint32)height);
+	for (int32 y = 0; y < height; ++y)
+	{
+		for (int32 x = 0; x < width; ++x)
+		{
+			const int32 p = y * width + x;
+			alignas(16) float c[4];
+			_mm_store_ps(c, _mm_mul_ps(current[p].v, demodulation[p].v));
+			outDenoisedImage->SetPixel(x, y, Pixel(c[0], c[1], c[2]));
+		}
+	}
+
+	return true;
+}
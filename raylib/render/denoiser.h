@@ -0,0 +1,24 @@
+// Built-in denoiser. Used when OpenImageDenoise is not available.
+//
+// Edge-avoiding a-trous wavelet filter guided by the albedo and normal AOVs:
+// - Illumination is demodulated by albedo, so textures are not blurred.
+// - Each iteration applies a 5x5 B3-spline kernel with holes (step 1, 2, 4, ...)
+//   whose taps are weighted by normal similarity and luminance difference.
+// - Luminance weights are scaled by a per-pixel variance estimate
+//   that is filtered along with the color.
+// References:
+// - Dammertz et al., "Edge-Avoiding A-Trous Wavelet Transform for fast Global Illumination Filtering" (HPG 2010)
+// - Schied et al., "Spatiotemporal Variance-Guided Filtering" (HPG 2017)
+
+#pragma once
+
+class Image2D;
+
+// albedoImage and normalImage are optional but improve quality a lot. normalImage should be in [-1, 1]
+// (RAYLIB_AOV_Normal); zero normals mark pixels without a surface.
+// @return false if images don't match in size.
+bool DenoiseATrous(
+	const Image2D* mainImage,
+	const Image2D* albedoImage,
+	const Image2D* normalImage,
+	Image2D* outDenoisedImage);
@@ -1,9 +1,13 @@
 #include "image.h"
 #include "core/int_types.h"
 #include "core/vec3.h"
+#include "core/vec4.h"
 #include "core/logger.h"
+#include "render/simd_kernels.h"
 #include "loader/dll_loader.h"
 
+#include <algorithm>
+
 #define TONE_MAP         1    // Still some artifact around borders that I don't quite get
 #define FORCE_MAX_WHITE  1    // Clamp the tone mapping result to white
 #define GAMMA_CORRECTION 1    // linear to sRGB
@@ -41,61 +45,50 @@ void Image2D::SetPixel(int32 x, int32 y, uint32 argb)
 	image[ix(x, y)] = Pixel(argb);
 }
 
-void Image2D::PostProcess()
+void Image2D::WriteRegion(int32 x, int32 y, int32 regionWidth, int32 regionHeight, const Pixel* pixels)
 {
-	// https://64.github.io/tonemapping/
-	auto Luminance = [](const vec3& v) -> float
+	for (int32 row = 0; row < regionHeight; ++row)
 	{
-		return dot(v, vec3(0.2126f, 0.7152f, 0.0722f));
-	};
-	auto LuminanceToneMap = [&](const vec3& v, float maxWhiteLuminance) -> vec3
-	{
-		float luminanceOld = Luminance(v);
-		// Div by zero if progress any further
-		if (luminanceOld <= 0.0001f)
-		{
-			return vec3(0.0f, 0.0f, 0.0f);
-		}
-		float numerator = luminanceOld * (1.0f + (luminanceOld / (maxWhiteLuminance * maxWhiteLuminance)));
-		float luminanceNew = numerator / (1.0f + luminanceOld);
-		return v * (luminanceNew / luminanceOld);
-	};
+		std::copy(pixels + row * regionWidth, pixels + (row + 1) * regionWidth, image.begin() + ix(x, y + row));
+	}
+}
+
+void Image2D::PostProcess()
+{
+	// Pixels are 16-byte aligned RGBA, so each one is loaded as a vec4.
+	STATIC_ASSERT(sizeof(Pixel) == sizeof(vec4));
 
+	// https://64.github.io/tonemapping/
+	const SIMDKernels& kernels = GetSIMDKernels();
 	const size_t len = (size_t)(width * height);
-	float maxWhiteLuminance = 1.0f;
 
-	for (size_t i = 0; i < len; ++i)
-	{
-		//maxWhiteLuminance = std::max(maxWhiteLuminance, std::max(image[i].r, std::max(image[i].g, image[i].b)));
-		float L = Luminance(vec3(image[i].r, image[i].g, image[i].b));
-		if (maxWhiteLuminance < L)
-		{
-			maxWhiteLuminance = L;
-		}
-	}
+	float maxWhiteLuminance = kernels.maxLuminance(image.data(), len);
 
 	LOG("Max white luminance: %f", maxWhiteLuminance);
 
-	for (size_t i = 0; i < len; ++i)
-	{
-		vec3 rgb(image[i].r, image[i].g, image[i].b);
-
 #if TONE_MAP
-		// Extended Reinhard (Luminance Tone Map)
-		rgb = LuminanceToneMap(rgb, maxWhiteLuminance);
+	// Extended Reinhard (Luminance Tone Map)
+	kernels.toneMap(image.data(), len, maxWhiteLuminance);
 #endif
 
+	for (size_t i = 0; i < len; ++i)
+	{
+		vec4 rgba = vec4::Load(&image[i].r);
+
 #if FORCE_MAX_WHITE
 		// Still needs to clamp to white?
-		rgb = (min)(vec3(1.0f, 1.0f, 1.0f), rgb);
+		// NOTE: rgba first so that NaN becomes white, same as (min)(vec3(1.0f), rgb).
+		rgba = min(rgba, vec4(1.0f));
 #endif
 
+		vec3 rgb = rgba.xyz();
+
 		// Gamma correction
 #if GAMMA_CORRECTION
 		rgb = pow(rgb, 1.0f / GAMMA_VALUE);
 #endif
 		
-		// Final output
+		// Final output; alpha is kept.
 		image[i].r = rgb.x;
 		image[i].g = rgb.y;
 		image[i].b = rgb.z;
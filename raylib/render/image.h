@@ -3,6 +3,7 @@
 #include "raylib_types.h"
 #include "core/int_types.h"
 #include "core/vec3.h"
+#include "core/aligned_allocator.h"
 #include <vector>
 
 struct Pixel
@@ -84,6 +85,10 @@ struct Pixel
 
 };
 
+// Rows start at a cache line if the width is a multiple of 4,
+// so render threads writing different tiles don't share cache lines.
+using PixelArray = std::vector<Pixel, AlignedAllocator<Pixel, CACHE_LINE_SIZE>>;
+
 // Can be used as a 2D texture mipmap or a 2D render target.
 class Image2D
 {
@@ -97,13 +102,15 @@ public:
 
 	RAYLIB_API void SetPixel(int32 x, int32 y, const Pixel& argb);
 	RAYLIB_API void SetPixel(int32 x, int32 y, uint32 argb);
+	// Copy a row-major block of (width * height) pixels to [x, x + width) * [y, y + height).
+	RAYLIB_API void WriteRegion(int32 x, int32 y, int32 regionWidth, int32 regionHeight, const Pixel* pixels);
 
 	RAYLIB_API void PostProcess(); // tone mapping, gamma correction, etc.
 
 	inline uint32 GetWidth() const { return width; }
 	inline uint32 GetHeight() const { return height; }
 	inline Pixel GetPixel(int32 x, int32 y) const { return image[ix(x, y)]; }
-	inline const std::vector<Pixel>& GetPixelArray() const { return image; }
+	inline const PixelArray& GetPixelArray() const { return image; }
 
 	Image2D Clone() const;
 	void DumpFloatRGBs(std::vector<float>& outArray) const;
@@ -114,7 +121,7 @@ private:
 
 	uint32 width;
 	uint32 height;
-	std::vector<Pixel> image; // row-major
+	PixelArray image; // row-major
 
 };
 
@@ -3,6 +3,8 @@
 // #todo: Include in renderer settings?
 #define FURNACE_TEST 0
 #define CUTOUT_ALPHA 0.5f
+// Lower bound of choosing the specular lobe in MicrofacetMaterial::Scatter() if there is a diffuse lobe.
+#define MIN_SPECULAR_LOBE_PROBABILITY 0.25f
 
 // -------------------------------
 
@@ -11,182 +13,51 @@
 // https://computergraphics.stackexchange.com/questions/4394/path-tracing-the-cook-torrance-brdf
 
 // -------------------------------
-// From https://github.com/mmp/pbrt-v3
+// Shading frame
 
-inline float Clamp(float val, float minVal, float maxVal) {
-	return std::max(minVal, std::min(maxVal, val));
-}
-inline float ErfInv(float x) {
-	float w, p;
-	x = Clamp(x, -.99999f, .99999f);
-	w = -std::log((1 - x) * (1 + x));
-	if (w < 5) {
-		w = w - 2.5f;
-		p = 2.81022636e-08f;
-		p = 3.43273939e-07f + p * w;
-		p = -3.5233877e-06f + p * w;
-		p = -4.39150654e-06f + p * w;
-		p = 0.00021858087f + p * w;
-		p = -0.00125372503f + p * w;
-		p = -0.00417768164f + p * w;
-		p = 0.246640727f + p * w;
-		p = 1.50140941f + p * w;
-	} else {
-		w = std::sqrt(w) - 3;
-		p = -0.000200214257f;
-		p = 0.000100950558f + p * w;
-		p = 0.00134934322f + p * w;
-		p = -0.00367342844f + p * w;
-		p = 0.00573950773f + p * w;
-		p = -0.0076224613f + p * w;
-		p = 0.00943887047f + p * w;
-		p = 1.00167406f + p * w;
-		p = 2.83297682f + p * w;
-	}
-	return p * x;
-}
-inline float Erf(float x) {
-	// constants
-	float a1 = 0.254829592f;
-	float a2 = -0.284496736f;
-	float a3 = 1.421413741f;
-	float a4 = -1.453152027f;
-	float a5 = 1.061405429f;
-	float p = 0.3275911f;
-
-	// Save the sign of x
-	int sign = 1;
-	if (x < 0) sign = -1;
-	x = std::abs(x);
-
-	// A&S formula 7.1.26
-	float t = 1 / (1 + p * x);
-	float y =
-		1 -
-		(((((a5 * t + a4) * t) + a3) * t + a2) * t + a1) * t * std::exp(-x * x);
-
-	return sign * y;
-}
-inline float CosTheta(const vec3& w) { return w.z; }
-inline float Cos2Theta(const vec3& w) { return w.z * w.z; }
-inline float AbsCosTheta(const vec3& w) { return std::abs(w.z); }
-inline float Sin2Theta(const vec3& w) { return std::max(0.0f, 1.0f - Cos2Theta(w)); }
-inline float SinTheta(const vec3& w) { return std::sqrt(Sin2Theta(w)); }
-inline float CosPhi(const vec3& w) {
-	float sinTheta = SinTheta(w);
-	return (sinTheta == 0) ? 1 : Clamp(w.x / sinTheta, -1, 1);
-}
-inline float SinPhi(const vec3& w) {
-	float sinTheta = SinTheta(w);
-	return (sinTheta == 0) ? 0 : Clamp(w.y / sinTheta, -1, 1);
-}
-static void BeckmannSample11(
-	float cosThetaI, float U1, float U2,
-	float* slope_x, float* slope_y)
+// Orthonormal frame around the microsurface normal in world space.
+// Flipped to the side of Wo, so surfaces reflect on both sides.
+struct ShadingFrame
 {
-	const float Pi = BRDF::PI;
-
-	/* Special case (normal incidence) */
-	if (cosThetaI > .9999) {
-		float r = std::sqrt(-std::log(1.0f - U1));
-		float sinPhi = std::sin(2 * Pi * U2);
-		float cosPhi = std::cos(2 * Pi * U2);
-		*slope_x = r * cosPhi;
-		*slope_y = r * sinPhi;
-		return;
-	}
+	vec3 T, B, N;
 
-	/* The original inversion routine from the paper contained
-	   discontinuities, which causes issues for QMC integration
-	   and techniques like Kelemen-style MLT. The following code
-	   performs a numerical inversion with better behavior */
-	float sinThetaI =
-		std::sqrt(std::max((float)0, (float)1 - cosThetaI * cosThetaI));
-	float tanThetaI = sinThetaI / cosThetaI;
-	float cotThetaI = 1 / tanThetaI;
-
-	/* Search interval -- everything is parameterized
-	   in the Erf() domain */
-	float a = -1, c = Erf(cotThetaI);
-	float sample_x = std::max(U1, (float)1e-6f);
-
-	/* Start with a good initial guess */
-	// float b = (1-sample_x) * a + sample_x * c;
-
-	/* We can do better (inverse of an approximation computed in
-	 * Mathematica) */
-	float thetaI = std::acos(cosThetaI);
-	float fit = 1 + thetaI * (-0.876f + thetaI * (0.4265f - 0.0594f * thetaI));
-	float b = c - (1 + c) * std::pow(1 - sample_x, fit);
-
-	/* Normalization factor for the CDF */
-	static const float SQRT_PI_INV = 1.f / std::sqrt(Pi);
-	float normalization =
-		1 /
-		(1 + c + SQRT_PI_INV * tanThetaI * std::exp(-cotThetaI * cotThetaI));
-
-	int it = 0;
-	while (++it < 10) {
-		/* Bisection criterion -- the oddly-looking
-		   Boolean expression are intentional to check
-		   for NaNs at little additional cost */
-		if (!(b >= a && b <= c)) b = 0.5f * (a + c);
-
-		/* Evaluate the CDF and its derivative
-		   (i.e. the density function) */
-		float invErf = ErfInv(b);
-		float value =
-			normalization *
-			(1 + b + SQRT_PI_INV * tanThetaI * std::exp(-invErf * invErf)) -
-			sample_x;
-		float derivative = normalization * (1 - invErf * tanThetaI);
-
-		if (std::abs(value) < 1e-5f) break;
-
-		/* Update bisection intervals */
-		if (value > 0)
-			c = b;
-		else
-			a = b;
-
-		b -= value / derivative;
+	ShadingFrame(const HitResult& hitResult, const vec3& Wo)
+	{
+		N = normalize(hitResult.LocalToWorld(hitResult.bsdf.normal));
+		if (dot(N, Wo) < 0.0f) {
+			N = -N;
+		}
+		T = (std::abs(N.x) > 0.9f) ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+		B = normalize(cross(T, N));
+		T = cross(N, B);
 	}
 
-	/* Now convert back into a slope value */
-	*slope_x = ErfInv(b);
+	inline vec3 ToLocal(const vec3& v) const { return vec3(dot(v, T), dot(v, B), dot(v, N)); }
+	inline vec3 ToWorld(const vec3& v) const { return v.x * T + v.y * B + v.z * N; }
+};
 
-	/* Simulate Y component */
-	*slope_y = ErfInv(2.0f * std::max(U2, (float)1e-6f) - 1.0f);
+// -------------------------------
+// Material
 
-	CHECK(!std::isinf(*slope_x));
-	CHECK(!std::isnan(*slope_x));
-	CHECK(!std::isinf(*slope_y));
-	CHECK(!std::isnan(*slope_y));
-}
-static vec3 BeckmannSample(
-	const vec3& wi,
-	float alpha_x, float alpha_y,
-	float U1, float U2)
+void Material::EvaluateBSDF(const HitResult& hitResult, BSDFRecord& outBSDF) const
 {
-	// 1. stretch wi
-	vec3 wiStretched =
-		normalize(vec3(alpha_x * wi.x, alpha_y * wi.y, wi.z));
-
-	// 2. simulate P22_{wi}(x_slope, y_slope, 1, 1)
-	float slope_x, slope_y;
-	BeckmannSample11(CosTheta(wiStretched), U1, U2, &slope_x, &slope_y);
-
-	// 3. rotate
-	float tmp = CosPhi(wiStretched) * slope_x - SinPhi(wiStretched) * slope_y;
-	slope_y = SinPhi(wiStretched) * slope_x + CosPhi(wiStretched) * slope_y;
-	slope_x = tmp;
+	outBSDF.albedo = GetAlbedo(hitResult.paramU, hitResult.paramV);
+	outBSDF.roughness = 1.0f;
+	outBSDF.metallic = 0.0f;
+	outBSDF.normal = GetMicrosurfaceNormal(hitResult);
+	outBSDF.emission = Emitted(hitResult, hitResult.n);
+}
 
-	// 4. unstretch
-	slope_x = alpha_x * slope_x;
-	slope_y = alpha_y * slope_y;
+static void EvaluateBSDF_Virtual(const Material& material, const HitResult& hitResult, BSDFRecord& outBSDF)
+{
+	material.EvaluateBSDF(hitResult, outBSDF);
+}
 
-	// 5. compute normal
-	return normalize(vec3(-slope_x, -slope_y, 1.f));
+EvaluateBSDFKernel Material::GetBSDFKernel(uint32& outFeatures, BSDFRecord& outConstants) const
+{
+	outFeatures = MATERIAL_FEATURE_ALL;
+	outConstants = BSDFRecord{ vec3(0.0f), 1.0f, 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f) };
+	return EvaluateBSDF_Virtual;
 }
 
 // -------------------------------
@@ -195,12 +66,16 @@ static vec3 BeckmannSample(
 bool Lambertian::Scatter(
 	const ray& pathRay,
 	const HitResult& hitResult,
+	Sampler& sampler,
 	vec3& outReflectance,
 	ray& outScatteredRay,
 	float& outPdf) const
 {
+	// Cosine-weighted so that outPdf matches the actual distribution of Wi.
 	vec3 N = hitResult.n;
-	vec3 Wi = normalize(RandomInHemisphere(N));
+	float u0, u1;
+	sampler.Get2D(u0, u1);
+	vec3 Wi = normalize(hitResult.LocalToWorld(SampleCosineHemisphere(u0, u1)));
 
 	outScatteredRay = ray(hitResult.p, Wi, pathRay.t);
 	outReflectance = albedo;
@@ -218,6 +93,22 @@ float Lambertian::ScatteringPdf(
 	return cosTheta / BRDF::PI;
 }
 
+vec3 Lambertian::EvalScattering(
+	const HitResult& hitResult,
+	const vec3& Wo,
+	const vec3& Wi,
+	float& outPdf) const
+{
+	float cosTheta = dot(hitResult.n, Wi);
+	if (cosTheta <= 0.0f)
+	{
+		outPdf = 0.0f;
+		return vec3(0.0f);
+	}
+	outPdf = cosTheta / BRDF::PI;
+	return albedo * cosTheta / BRDF::PI;
+}
+
 
 // -------------------------------
 // Metal
@@ -225,6 +116,7 @@ float Lambertian::ScatteringPdf(
 bool Metal::Scatter(
 	const ray& pathRay,
 	const HitResult& hitResult,
+	Sampler& sampler,
 	vec3& outReflectance,
 	ray& outScatteredRay,
 	float& outPdf) const
@@ -232,7 +124,9 @@ bool Metal::Scatter(
 	vec3 ud = pathRay.d;
 	ud.Normalize();
 	vec3 reflected = reflect(ud, hitResult.n);
-	outScatteredRay = ray(hitResult.p, reflected + fuzziness * RandomInUnitSphere(), pathRay.t);
+	float u0, u1;
+	sampler.Get2D(u0, u1);
+	outScatteredRay = ray(hitResult.p, reflected + fuzziness * SampleUnitSphere(u0, u1), pathRay.t);
 	outReflectance = albedo;
 	outPdf = 1.0f;
 	return (dot(outScatteredRay.d, hitResult.n) > 0.0f);
@@ -250,6 +144,7 @@ inline float Schlick(float cosine, float ref_idx) {
 bool Dielectric::Scatter(
 	const ray& pathRay,
 	const HitResult& hitResult,
+	Sampler& sampler,
 	vec3& outReflectance,
 	ray& outScatteredRay,
 	float& outPdf) const
@@ -275,7 +170,7 @@ bool Dielectric::Scatter(
 	} else {
 		reflect_prob = 1.0f;
 	}
-	if (Random() < reflect_prob) {
+	if (sampler.Get1D() < reflect_prob) {
 		outScatteredRay = ray(hitResult.p, reflected, pathRay.t);
 	} else {
 		outScatteredRay = ray(hitResult.p, refracted, pathRay.t);
@@ -288,100 +183,220 @@ bool Dielectric::Scatter(
 // MicrofacetMaterial
 
 bool MicrofacetMaterial::Scatter(
-	const ray& pathRay, const HitResult& hitResult,
+	const ray& pathRay, const HitResult& hitResult, Sampler& sampler,
 	vec3& outReflectance, ray& outScatteredRay,
 	float& outPdf) const
 {
-	vec3 baseColor = GetAlbedo(hitResult.paramU, hitResult.paramV);
-	float roughness = roughnessFallback;
-	float metallic = metallicFallback;
+	const BSDFRecord& bsdf = hitResult.bsdf;
 
-	if (roughnessTexture) {
-		roughness = roughnessTexture->Sample(hitResult.paramU, hitResult.paramV).r;
+	// Do calculation in local space
+	const ShadingFrame frame(hitResult, -pathRay.d);
+	vec3 Wo = normalize(frame.ToLocal(-pathRay.d));
+	if (Wo.z <= 0.0f) {
+		return false;
+	}
+
+	float u0, u1;
+	sampler.Get2D(u0, u1);
+	vec3 Wi;
+	if (sampler.Get1D() < SpecularLobeProbability(bsdf, Wo.z)) {
+		vec3 Wh = Sample_wh(Wo, BRDF::RoughnessToAlphaGGX(bsdf.roughness), u0, u1);
+		Wi = reflect(-Wo, Wh);
+	} else {
+		Wi = SampleCosineHemisphere(u0, u1);
+	}
+
+	// Transform to world space
+	outScatteredRay = ray(hitResult.p, frame.ToWorld(Wi), pathRay.t);
+
+	// Same evaluation as light sampling, so that ScatteringPdf() returns exactly outPdf.
+	vec3 f = EvalScattering(hitResult, -pathRay.d, outScatteredRay.d, outPdf);
+	if (outPdf <= 0.0f) {
+		return false;
 	}
-	if (metallicTexture) {
-		metallic = metallicTexture->Sample(hitResult.paramU, hitResult.paramV).r;
+	outReflectance = f / outPdf;
+	return true;
+}
+
+vec3 MicrofacetMaterial::EvalScattering(
+	const HitResult& hitResult,
+	const vec3& Wo_world,
+	const vec3& Wi_world,
+	float& outPdf) const
+{
+	const ShadingFrame frame(hitResult, Wo_world);
+	vec3 wo = normalize(frame.ToLocal(Wo_world));
+	vec3 wi = normalize(frame.ToLocal(Wi_world));
+	// Reflection only
+	if (wo.z <= 0.0f || wi.z <= 0.0f) {
+		outPdf = 0.0f;
+		return vec3(0.0f);
 	}
+	vec3 wh = normalize(wo + wi);
+
+	outPdf = SamplingPdf(hitResult.bsdf, wo, wi, wh);
+	return EvalReflectance(hitResult.bsdf, wo, wi, wh);
+}
 
+vec3 MicrofacetMaterial::EvalReflectance(const BSDFRecord& bsdf, const vec3& Wo, const vec3& Wi, const vec3& Wh) const
+{
+	const float alpha = BRDF::RoughnessToAlphaGGX(bsdf.roughness);
+	const float metallic = bsdf.metallic;
+
+	// RGB terms in SIMD lanes
+	const vec4 albedo(bsdf.albedo);
+	vec4 F0 = vec4(0.04f);
+	F0 = mix(F0, albedo, metallic);
+
+	vec4 F = BRDF::FresnelSchlick(dot(Wh, Wo), F0);
+	float G = BRDF::GeometrySmith_GGX(Wo, Wi, alpha);
+	float NDF = BRDF::DistributionGGX_Local(Wh, alpha);
+
+	vec4 kS = F;
+	vec4 kD = 1.0f - kS;
+	vec4 diffuse = albedo * ((1.0f - metallic) / BRDF::PI);
+	vec4 specular = F * (G * NDF / (4.0f * Wo.z * Wi.z));
+
+	return ((kD * diffuse + specular) * Wi.z).xyz();
+}
+
+float MicrofacetMaterial::SamplingPdf(const BSDFRecord& bsdf, const vec3& Wo, const vec3& Wi, const vec3& Wh) const
+{
+	const float alpha = BRDF::RoughnessToAlphaGGX(bsdf.roughness);
+	const float pSpecular = SpecularLobeProbability(bsdf, Wo.z);
+	return pSpecular * BRDF::PdfVisibleNormalGGX_Reflected(Wo, Wh, alpha)
+		+ (1.0f - pSpecular) * Wi.z / BRDF::PI;
+}
+
+float MicrofacetMaterial::SpecularLobeProbability(const BSDFRecord& bsdf, float cosThetaO)
+{
+	float diffuse = luminance(bsdf.albedo) * (1.0f - bsdf.metallic);
+	if (diffuse <= 0.0f) {
+		return 1.0f;
+	}
+	vec3 F0 = mix(vec3(0.04f), bsdf.albedo, bsdf.metallic);
+	float specular = luminance(BRDF::FresnelSchlick(cosThetaO, F0));
+	return std::max(MIN_SPECULAR_LOBE_PROBABILITY, specular / (specular + diffuse));
+}
+
+static inline void ApplyFurnaceTest(BSDFRecord& bsdf)
+{
 #if FURNACE_TEST
-	baseColor = vec3(0.18f);
-	roughness = 1.0f;
-	metallic = 0.0f;
+	bsdf.albedo = vec3(0.18f);
+	bsdf.roughness = 1.0f;
+	bsdf.metallic = 0.0f;
 #endif
+}
 
-	// Do calculation in local space
-	vec3 N = GetMicrosurfaceNormal(hitResult);
-	vec3 Wo = hitResult.WorldToLocal(-pathRay.d);
-	vec3 Wh = Sample_wh(Wo, roughness);
-	vec3 Wi = reflect(-Wo, Wh);
-	float NdotWi = absDot(N, Wi);
+template<uint32 Features>
+void MicrofacetMaterial::EvaluateBSDFVariant(const Material& material, const HitResult& hitResult, BSDFRecord& outBSDF)
+{
+	const MicrofacetMaterial& M = static_cast<const MicrofacetMaterial&>(material);
+	const float u = hitResult.paramU;
+	const float v = hitResult.paramV;
 
-	vec3 F0 = vec3(0.04f);
-	F0 = mix(F0, baseColor, metallic);
+	if (Features & MATERIAL_FEATURE_Albedo) {
+		Pixel albedoPixel = M.albedoTexture->Sample(u, v);
+		outBSDF.albedo = albedoPixel.RGBToVec3() * albedoPixel.a;
+	} else {
+		outBSDF.albedo = M.albedoFallback;
+	}
 
-	vec3 F = BRDF::FresnelSchlick(absDot(Wh, Wo), F0);
-	float G = BRDF::GeometrySmith_Beckmann(N, Wh, Wo, Wi, roughness);
-	float NDF = BRDF::DistributionBeckmann(N, Wh, roughness);
+	if (Features & MATERIAL_FEATURE_Roughness) {
+		outBSDF.roughness = M.roughnessTexture->Sample(u, v).r;
+	} else {
+		outBSDF.roughness = M.roughnessFallback;
+	}
 
-	vec3 kS = F;
-	vec3 kD = 1.0f - kS;
-	vec3 diffuse = baseColor * (1.0f - metallic);
-	vec3 specular = (F * G * NDF) / (4.0f * NdotWi * absDot(N, Wo) + 0.001f);
+	if (Features & MATERIAL_FEATURE_Metallic) {
+		outBSDF.metallic = M.metallicTexture->Sample(u, v).r;
+	} else {
+		outBSDF.metallic = M.metallicFallback;
+	}
 
-	// Transform to world space
-	Wi = hitResult.LocalToWorld(Wi);
+	if (Features & MATERIAL_FEATURE_Normal) {
+		outBSDF.normal = normalize(2.0f * M.normalmapTexture->Sample(u, v).RGBToVec3() - 1.0f);
+	} else {
+		outBSDF.normal = vec3(0.0f, 0.0f, 1.0f);
+	}
 
-	// #todo-wip: [FATAL] Not energy conserving?
-	// Especially in DabrovicSponza all goes white.
-	outScatteredRay = ray(hitResult.p, Wi, pathRay.t);
-	outReflectance = (kD * diffuse + kS * specular) * NdotWi;
-	outPdf = ScatteringPdf(hitResult, -pathRay.d, outScatteredRay.d) / (4.0f * dot(Wo, Wh));
-	return true;
+	if (Features & MATERIAL_FEATURE_Emission) {
+		outBSDF.emission = M.emissiveTexture->Sample(u, v).RGBToVec3();
+	} else {
+		outBSDF.emission = M.emissiveFallback;
+	}
+
+	ApplyFurnaceTest(outBSDF);
+}
+
+void MicrofacetMaterial::UpdateFeatures()
+{
+	static const EvaluateBSDFKernel kernels[MATERIAL_FEATURE_ALL + 1] = {
+		EvaluateBSDFVariant<0>,  EvaluateBSDFVariant<1>,  EvaluateBSDFVariant<2>,  EvaluateBSDFVariant<3>,
+		EvaluateBSDFVariant<4>,  EvaluateBSDFVariant<5>,  EvaluateBSDFVariant<6>,  EvaluateBSDFVariant<7>,
+		EvaluateBSDFVariant<8>,  EvaluateBSDFVariant<9>,  EvaluateBSDFVariant<10>, EvaluateBSDFVariant<11>,
+		EvaluateBSDFVariant<12>, EvaluateBSDFVariant<13>, EvaluateBSDFVariant<14>, EvaluateBSDFVariant<15>,
+		EvaluateBSDFVariant<16>, EvaluateBSDFVariant<17>, EvaluateBSDFVariant<18>, EvaluateBSDFVariant<19>,
+		EvaluateBSDFVariant<20>, EvaluateBSDFVariant<21>, EvaluateBSDFVariant<22>, EvaluateBSDFVariant<23>,
+		EvaluateBSDFVariant<24>, EvaluateBSDFVariant<25>, EvaluateBSDFVariant<26>, EvaluateBSDFVariant<27>,
+		EvaluateBSDFVariant<28>, EvaluateBSDFVariant<29>, EvaluateBSDFVariant<30>, EvaluateBSDFVariant<31>,
+	};
+	STATIC_ASSERT(MATERIAL_FEATURE_ALL == 31);
+
+	features = 0;
+	if (albedoTexture != nullptr)    features |= MATERIAL_FEATURE_Albedo;
+	if (normalmapTexture != nullptr) features |= MATERIAL_FEATURE_Normal;
+	if (roughnessTexture != nullptr) features |= MATERIAL_FEATURE_Roughness;
+	if (metallicTexture != nullptr)  features |= MATERIAL_FEATURE_Metallic;
+	if (emissiveTexture != nullptr)  features |= MATERIAL_FEATURE_Emission;
+	evaluateBSDFKernel = kernels[features];
+}
+
+void MicrofacetMaterial::EvaluateBSDF(const HitResult& hitResult, BSDFRecord& outBSDF) const
+{
+	evaluateBSDFKernel(*this, hitResult, outBSDF);
+}
+
+EvaluateBSDFKernel MicrofacetMaterial::GetBSDFKernel(uint32& outFeatures, BSDFRecord& outConstants) const
+{
+	outFeatures = features;
+	outConstants = BSDFRecord{ albedoFallback, roughnessFallback, metallicFallback, vec3(0.0f, 0.0f, 1.0f), emissiveFallback };
+	ApplyFurnaceTest(outConstants);
+	return evaluateBSDFKernel;
 }
 
 vec3 MicrofacetMaterial::Emitted(const HitResult& hitResult, const vec3& Wo) const {
 	vec3 emit = emissiveFallback;
 	if (emissiveTexture) {
-		Pixel emissiveSample = emissiveTexture->Sample(hitResult.paramU, hitResult.paramU);
-		emit = (emissiveSample.r, emissiveSample.g, emissiveSample.b);
+		Pixel emissiveSample = emissiveTexture->Sample(hitResult.paramU, hitResult.paramV);
+		emit = vec3(emissiveSample.r, emissiveSample.g, emissiveSample.b);
 	}
 
 	return emit;
 }
 
+bool MicrofacetMaterial::IsEmissive() const {
+	return emissiveTexture != nullptr || emissiveFallback != vec3(0.0f);
+}
+
 float MicrofacetMaterial::ScatteringPdf(
 	const HitResult& hitResult,
 	const vec3& Wo_world,
 	const vec3& Wi_world) const
 {
-	vec3 wo = hitResult.WorldToLocal(Wo_world);
-	vec3 wi = hitResult.WorldToLocal(Wi_world);
-	vec3 wh = normalize(wo + wi);
-	if (wh.z < 0.0f) {
-		wh.z = -wh.z;
-	}
-	vec3 n = GetMicrosurfaceNormal(hitResult);
-
-	float roughness = roughnessFallback;
-	if (roughnessTexture) {
-		roughness = roughnessTexture->Sample(hitResult.paramU, hitResult.paramV).r;
+	// Same as EvalScattering()
+	const ShadingFrame frame(hitResult, Wo_world);
+	vec3 wo = normalize(frame.ToLocal(Wo_world));
+	vec3 wi = normalize(frame.ToLocal(Wi_world));
+	if (wo.z <= 0.0f || wi.z <= 0.0f) {
+		return 0.0f;
 	}
-
-#if FURNACE_TEST
-	roughness = 1.0f;
-#endif
-
-	float D = BRDF::DistributionBeckmann(n, wh, roughness);
-	return D * absDot(wh, n);
+	return SamplingPdf(hitResult.bsdf, wo, wi, normalize(wo + wi));
 }
 
-bool MicrofacetMaterial::IsMirrorLike(float paramU, float paramV) const
+bool MicrofacetMaterial::IsMirrorLike(const HitResult& hitResult) const
 {
-	float roughness = roughnessFallback;
-	if (roughnessTexture) {
-		roughness = roughnessTexture->Sample(paramU, paramV).r;
-	}
-	return roughness < 0.1f;
+	return hitResult.bsdf.roughness < 0.1f;
 }
 
 vec3 MicrofacetMaterial::GetAlbedo(float paramU, float paramV) const
@@ -414,18 +429,8 @@ vec3 MicrofacetMaterial::GetMicrosurfaceNormal(const HitResult& hitResult) const
 	return vec3(0.0f, 0.0f, 1.0f);
 }
 
-vec3 MicrofacetMaterial::Sample_wh(const vec3& wo, float alpha) const
+vec3 MicrofacetMaterial::Sample_wh(const vec3& wo, float alpha, float u0, float u1) const
 {
-	// https://pbr-book.org/3ed-2018/Light_Transport_I_Surface_Reflection/Sampling_Reflection_Functions#sec:microfacet-sample
-
-	float u0 = Random();
-	float u1 = Random();
-
 	// Sample from the distribution of visible microfacets from a given wo.
-	vec3 wh;
-	bool bFlip = wo.z < 0.0f;
-	wh = BeckmannSample(bFlip ? -wo : wo, alpha, alpha, u0, u1);
-	if (bFlip) wh = -wh;
-
-	return wh;
+	return BRDF::SampleVisibleNormalGGX(wo, alpha, u0, u1);
 }
@@ -2,6 +2,7 @@
 
 #include "raylib_types.h"
 #include "core/random.h"
+#include "core/sampler.h"
 #include "render/brdf.h"
 #include "render/image.h"
 #include "render/texture.h"
@@ -12,6 +13,19 @@
 
 // #todo-raylib: Remove RAYLIB_API
 
+// Parameters of BSDFRecord that vary over the surface of a material (e.g., textured).
+// The others are the same for all hits. See Material::GetBSDFKernel().
+enum EMaterialFeature : uint32
+{
+	MATERIAL_FEATURE_Albedo    = 1 << 0,
+	MATERIAL_FEATURE_Normal    = 1 << 1,
+	MATERIAL_FEATURE_Roughness = 1 << 2,
+	MATERIAL_FEATURE_Metallic  = 1 << 3,
+	MATERIAL_FEATURE_Emission  = 1 << 4,
+
+	MATERIAL_FEATURE_ALL       = (1 << 5) - 1
+};
+
 // Base class for all materials
 class Material
 {
@@ -19,13 +33,26 @@ class Material
 public:
 	// 1. Produce a scattered ray
 	// 2. If scattered, tell how much the ray should be attenuated
+	// Random numbers for sampling the scattered ray are drawn from the sampler.
 	RAYLIB_API virtual bool Scatter(
 		const ray&       inPathRay,
 		const HitResult& inHitResult,
+		Sampler&         sampler,
 		vec3&            outReflectance,
 		ray&             outScatteredRay,
 		float&           outPdf) const = 0;
 
+	// Sample the material once for a hit that is about to be shaded. See HitResult::EvaluateBSDF().
+	// Default implementation builds the record from GetAlbedo(), GetMicrosurfaceNormal(), and Emitted().
+	RAYLIB_API virtual void EvaluateBSDF(const HitResult& hitResult, BSDFRecord& outBSDF) const;
+
+	// For batched shading (see MaterialTable). Returns a kernel that does the same as EvaluateBSDF()
+	// and can be called directly, the varying parameters (EMaterialFeature), and the values of the others.
+	// Default kernel calls EvaluateBSDF() and all parameters are varying.
+	RAYLIB_API virtual EvaluateBSDFKernel GetBSDFKernel(uint32& outFeatures, BSDFRecord& outConstants) const;
+
+	// For surface points that are not shaded (e.g., light samples).
+	// Shaded hits should read HitResult::bsdf.emission instead.
 	RAYLIB_API virtual vec3 Emitted(const HitResult& hitResult, const vec3& Wo) const
 	{
 		return vec3(0.0f, 0.0f, 0.0f);
@@ -40,7 +67,28 @@ public:
 		return 1.0f / BRDF::PI;
 	}
 
-	virtual bool IsMirrorLike(float paramU, float paramV) const { return false; }
+	// True if Emitted() can be non-zero. Such surfaces are sampled as area lights.
+	RAYLIB_API virtual bool IsEmissive() const { return false; }
+
+	// False if scattering can't be evaluated for an arbitrary pair of directions (e.g., mirrors).
+	// Light sampling is skipped for such surfaces.
+	virtual bool SupportsLightSampling(const HitResult& hitResult) const { return false; }
+
+	// Returns (reflectance * scatteringPdf) that Scatter() would produce if it had chosen Wi,
+	// and the pdf of Scatter() choosing Wi. Only valid if SupportsLightSampling().
+	// NOTE: Wo, Wi are in world space and Wo is outward from the surface.
+	RAYLIB_API virtual vec3 EvalScattering(
+		const HitResult& hitResult,
+		const vec3& Wo,
+		const vec3& Wi,
+		float& outPdf) const
+	{
+		outPdf = 0.0f;
+		return vec3(0.0f);
+	}
+
+	virtual bool IsMirrorLike(const HitResult& hitResult) const { return false; }
+	// Prefer HitResult::bsdf.albedo if the hit is shaded.
 	RAYLIB_API virtual vec3 GetAlbedo(float paramU, float paramV) const { return vec3(0.0f); }
 	RAYLIB_API virtual bool AlphaTest(float paramU, float paramV) const { return true; }
 	// In local tangent space
@@ -57,7 +105,7 @@ public:
 	}
 
 	RAYLIB_API bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override
 	{
@@ -68,6 +116,8 @@ public:
 		return intensity;
 	}
 
+	RAYLIB_API bool IsEmissive() const override { return intensity != vec3(0.0f); }
+
 public:
 	vec3 intensity;
 
@@ -82,7 +132,7 @@ public:
 	}
 
 	RAYLIB_API bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override;
 
@@ -91,6 +141,14 @@ public:
 		const vec3& Wo,
 		const vec3& Wi) const override;
 
+	virtual bool SupportsLightSampling(const HitResult& hitResult) const override { return true; }
+
+	RAYLIB_API vec3 EvalScattering(
+		const HitResult& hitResult,
+		const vec3& Wo,
+		const vec3& Wi,
+		float& outPdf) const override;
+
 	RAYLIB_API virtual vec3 GetAlbedo(float paramU, float paramV) const override { return albedo; }
 
 private:
@@ -108,7 +166,7 @@ public:
 	}
 
 	RAYLIB_API bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override;
 
@@ -128,11 +186,11 @@ public:
 	{}
 
 	RAYLIB_API bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override;
 
-	virtual bool IsMirrorLike(float paramU, float paramV) const override { return true; }
+	virtual bool IsMirrorLike(const HitResult& hitResult) const override { return true; }
 
 public:
 	float ref_idx;
@@ -147,7 +205,7 @@ public:
 	{}
 
 	virtual bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override
 	{
@@ -162,7 +220,7 @@ public:
 		return 1.0f;
 	}
 
-	virtual bool IsMirrorLike(float paramU, float paramV) const override { return true; }
+	virtual bool IsMirrorLike(const HitResult& hitResult) const override { return true; }
 
 public:
 	vec3 baseColor;
@@ -196,6 +254,7 @@ public:
 		, metallicFallback(0.0f)
 		, emissiveFallback(vec3(0.0f, 0.0f, 0.0f))
 	{
+		UpdateFeatures();
 	}
 
 	RAYLIB_API void SetAlbedoTexture(std::shared_ptr<Image2D> inImage)
@@ -206,26 +265,31 @@ public:
 		SamplerState sampler;
 		sampler.bSRGB = true;
 		albedoTexture->SetSamplerState(sampler);
+		UpdateFeatures();
 	}
 	RAYLIB_API void SetNormalTexture(std::shared_ptr<Image2D> inImage)
 	{
 		if (normalmapTexture) delete normalmapTexture;
 		normalmapTexture = Texture2D::CreateFromImage2D(inImage);
+		UpdateFeatures();
 	}
 	RAYLIB_API void SetRoughnessTexture(std::shared_ptr<Image2D> inImage)
 	{
 		if (roughnessTexture) delete roughnessTexture;
 		roughnessTexture = Texture2D::CreateFromImage2D(inImage);
+		UpdateFeatures();
 	}
 	RAYLIB_API void SetMetallicTexture(std::shared_ptr<Image2D> inImage)
 	{
 		if (metallicTexture) delete metallicTexture;
 		metallicTexture = Texture2D::CreateFromImage2D(inImage);
+		UpdateFeatures();
 	}
 	RAYLIB_API void SetEmissiveTexture(std::shared_ptr<Image2D> inImage)
 	{
 		if (emissiveTexture) delete emissiveTexture;
 		emissiveTexture = Texture2D::CreateFromImage2D(inImage);
+		UpdateFeatures();
 	}
 
 	void SetAlbedoFallback(const vec3& inAlbedo) { albedoFallback = saturate(inAlbedo); }
@@ -234,7 +298,7 @@ public:
 	void SetEmissiveFallback(const vec3& inEmissive) { emissiveFallback = inEmissive; }
 
 	RAYLIB_API bool Scatter(
-		const ray& inRay, const HitResult& inResult,
+		const ray& inRay, const HitResult& inResult, Sampler& sampler,
 		vec3& outReflectance, ray& outScatteredRay,
 		float& outPdf) const override;
 
@@ -245,15 +309,46 @@ public:
 		const vec3& Wo,
 		const vec3& Wi) const override;
 
-	virtual bool IsMirrorLike(float paramU, float paramV) const override;
+	RAYLIB_API bool IsEmissive() const override;
+
+	RAYLIB_API void EvaluateBSDF(const HitResult& hitResult, BSDFRecord& outBSDF) const override;
+	RAYLIB_API EvaluateBSDFKernel GetBSDFKernel(uint32& outFeatures, BSDFRecord& outConstants) const override;
+
+	virtual bool SupportsLightSampling(const HitResult& hitResult) const override { return !IsMirrorLike(hitResult); }
+
+	RAYLIB_API vec3 EvalScattering(
+		const HitResult& hitResult,
+		const vec3& Wo,
+		const vec3& Wi,
+		float& outPdf) const override;
+
+	virtual bool IsMirrorLike(const HitResult& hitResult) const override;
 
 	RAYLIB_API virtual vec3 GetAlbedo(float paramU, float paramV) const override;
 	RAYLIB_API virtual bool AlphaTest(float texcoordU, float texcoordV) const override;
 	RAYLIB_API virtual vec3 GetMicrosurfaceNormal(const HitResult& hitResult) const override;
 
 private:
+	// EvaluateBSDF() specialized for the textured parameters (EMaterialFeature).
+	// Constant parameters are copied without branching or texture sampling.
+	template<uint32 Features>
+	static void EvaluateBSDFVariant(const Material& material, const HitResult& hitResult, BSDFRecord& outBSDF);
+
+	// Select the EvaluateBSDF() variant for the current textures. Called whenever a texture is set.
+	RAYLIB_API void UpdateFeatures();
+
 	// wi = reflect(-wo, wh)
-	vec3 Sample_wh(const vec3& wo, float alpha) const;
+	vec3 Sample_wh(const vec3& wo, float alpha, float u0, float u1) const;
+
+	// BSDF * cos(theta_i) of the diffuse and GGX specular lobes.
+	// All directions are in the shading frame and in the upper hemisphere.
+	vec3 EvalReflectance(const BSDFRecord& bsdf, const vec3& Wo, const vec3& Wi, const vec3& Wh) const;
+
+	// Pdf of Scatter() choosing Wi. Same space as EvalReflectance().
+	float SamplingPdf(const BSDFRecord& bsdf, const vec3& Wo, const vec3& Wi, const vec3& Wh) const;
+
+	// Scatter() samples visible normals of the specular lobe with this probability, or the cosine-weighted diffuse lobe.
+	static float SpecularLobeProbability(const BSDFRecord& bsdf, float cosThetaO);
 
 private:
 	Texture2D* albedoTexture;
@@ -267,4 +362,7 @@ private:
 	float roughnessFallback;
 	float metallicFallback;
 	vec3 emissiveFallback;
+
+	uint32 features; // Textured parameters
+	EvaluateBSDFKernel evaluateBSDFKernel;
 };
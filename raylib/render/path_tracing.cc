@@ -0,0 +1,166 @@
+#include "path_tracing.h"
+#include "render/material.h"
+#include "render/image.h"
+#include "render/tile_buffer.h"
+#include "geom/hit.h"
+#include "geom/scene.h"
+
+// Shadow rays towards emissive surfaces stop slightly before the light.
+#define SHADOW_RAY_EPSILON 0.001f
+
+bool SampleDirectLighting(
+	const Scene* world,
+	const ray& pathRay,
+	const HitResult& hitResult,
+	Sampler& sampler,
+	DirectLightSample& outSample)
+{
+	float uLight = sampler.Get1D();
+	float u0, u1;
+	sampler.Get2D(u0, u1);
+
+	LightSample lightSample;
+	if (!world->SampleLight(hitResult.p, uLight, u0, u1, lightSample)
+		|| lightSample.pdf <= 0.0f
+		|| lightSample.Li == vec3(0.0f))
+	{
+		return false;
+	}
+
+	float scatteringPdf;
+	vec3 f = hitResult.material->EvalScattering(hitResult, -pathRay.d, lightSample.Wi, scatteringPdf);
+	if (f == vec3(0.0f))
+	{
+		return false;
+	}
+
+	float weight = lightSample.bDeltaLight ? 1.0f : PowerHeuristic(lightSample.pdf, scatteringPdf);
+
+	outSample.shadowRay = ray(hitResult.p, lightSample.Wi, pathRay.t);
+	outSample.shadowRayTMax = (lightSample.distance == FLOAT_MAX)
+		? FLOAT_MAX
+		: lightSample.distance * (1.0f - SHADOW_RAY_EPSILON);
+	outSample.radiance = f * lightSample.Li * (weight / lightSample.pdf);
+	return true;
+}
+
+void EvaluateAOVs(
+	const Scene* world,
+	const ray& cameraRay,
+	const HitResult& hitResult,
+	float rayTMin,
+	AOVSample& outSample)
+{
+	const Material* material = hitResult.material;
+
+	outSample.albedo = hitResult.bsdf.albedo;
+	if (material->IsMirrorLike(hitResult))
+	{
+		// Same as RAYLIB_RENDERMODE_Albedo
+		ray secondRay(hitResult.p, reflect(cameraRay.d, hitResult.n), cameraRay.t);
+		HitResult secondResult;
+		if (world->GetAccelStruct()->Hit(secondRay, rayTMin, FLOAT_MAX, secondResult))
+		{
+			outSample.albedo = secondResult.material->GetAlbedo(secondResult.paramU, secondResult.paramV);
+		}
+	}
+	outSample.normal = hitResult.LocalToWorld(hitResult.bsdf.normal);
+	outSample.depth = hitResult.t * cameraRay.d.Length();
+	outSample.objectID = (hitResult.object != nullptr) ? hitResult.object->GetObjectID() : 0;
+	outSample.materialID = (hitResult.object != nullptr) ? hitResult.object->GetMaterialID() : 0;
+}
+
+// -----------------------------------------------------------------------
+// AOVAccumulator
+
+void AOVAccumulator::Reset(uint32 inAOVMask, int32 numPixels, int32 firstSample)
+{
+	aovMask = inAOVMask;
+	firstSampleIndex = firstSample;
+	if (aovMask == 0)
+	{
+		return;
+	}
+	albedo.assign(numPixels, vec3(0.0f));
+	normal.assign(numPixels, vec3(0.0f));
+	depth.assign(numPixels, 0.0f);
+	objectID.assign(numPixels, 0);
+	materialID.assign(numPixels, 0);
+}
+
+void AOVAccumulator::AddSample(int32 pixelIx, int32 sampleIndex, const AOVSample& sample)
+{
+	albedo[pixelIx] += sample.albedo;
+	normal[pixelIx] += sample.normal;
+	if (sampleIndex == firstSampleIndex)
+	{
+		depth[pixelIx] = sample.depth;
+		objectID[pixelIx] = sample.objectID;
+		materialID[pixelIx] = sample.materialID;
+	}
+}
+
+void AOVAccumulator::Resolve(int32 x, int32 y, int32 width, int32 numSamples, Image2D* const* outAOVImages) const
+{
+	if (aovMask == 0)
+	{
+		return;
+	}
+	auto IsRequested = [this](EAOV aov) { return (aovMask & (1u << aov)) != 0; };
+
+	const float invSamples = 1.0f / (float)std::max(1, numSamples);
+	const int32 numPixels = (int32)albedo.size();
+	const int32 height = numPixels / width;
+
+	// Each AOV is filled in a private tile and published at once.
+	TileBuffer tile;
+	tile.Reset(x, y, width, height);
+	if (IsRequested(RAYLIB_AOV_Albedo))
+	{
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			vec3 v = albedo[i] * invSamples;
+			tile.SetPixel(i, Pixel(v.x, v.y, v.z));
+		}
+		tile.Publish(outAOVImages[RAYLIB_AOV_Albedo]);
+	}
+	if (IsRequested(RAYLIB_AOV_Normal))
+	{
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			vec3 v = normal[i];
+			if (v.LengthSquared() > 0.0f)
+			{
+				v.Normalize();
+			}
+			tile.SetPixel(i, Pixel(v.x, v.y, v.z));
+		}
+		tile.Publish(outAOVImages[RAYLIB_AOV_Normal]);
+	}
+	if (IsRequested(RAYLIB_AOV_Depth))
+	{
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			tile.SetPixel(i, Pixel(depth[i], depth[i], depth[i]));
+		}
+		tile.Publish(outAOVImages[RAYLIB_AOV_Depth]);
+	}
+	if (IsRequested(RAYLIB_AOV_ObjectID))
+	{
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			float id = (float)objectID[i];
+			tile.SetPixel(i, Pixel(id, id, id));
+		}
+		tile.Publish(outAOVImages[RAYLIB_AOV_ObjectID]);
+	}
+	if (IsRequested(RAYLIB_AOV_MaterialID))
+	{
+		for (int32 i = 0; i < numPixels; ++i)
+		{
+			float id = (float)materialID[i];
+			tile.SetPixel(i, Pixel(id, id, id));
+		}
+		tile.Publish(outAOVImages[RAYLIB_AOV_MaterialID]);
+	}
+}
@@ -0,0 +1,128 @@
+// Helpers shared by the path tracing integrators (renderer.cc and wavefront.cc).
+
+#pragma once
+
+#include "core/int_types.h"
+#include "core/vec3.h"
+#include "core/sampler.h"
+#include "geom/ray.h"
+
+#include <algorithm>
+#include <vector>
+
+class Scene;
+class Image2D;
+struct HitResult;
+
+// Upper bound of survival probability so that even bright paths can terminate.
+#define RUSSIAN_ROULETTE_MAX_SURVIVAL 0.95f
+
+// Sampler dimensions consumed by a path.
+// Each bounce starts from a fixed dimension so that the same decision (light selection,
+// BSDF sampling, ...) uses the same dimension in every sample of a pixel, regardless of
+// how many values the previous steps actually took.
+#define SAMPLER_DIMENSIONS_CAMERA     5 // Pixel jitter (2), lens (2), time (1)
+#define SAMPLER_DIMENSIONS_PER_BOUNCE 7
+// Offsets from the first dimension of a bounce.
+#define SAMPLER_OFFSET_LIGHT             0 // Light selection (1), point on the light (2)
+#define SAMPLER_OFFSET_SCATTERING        3 // Material::Scatter() (up to 3)
+#define SAMPLER_OFFSET_RUSSIAN_ROULETTE  6
+
+inline int32 GetBounceDimension(int32 depth)
+{
+	return SAMPLER_DIMENSIONS_CAMERA + depth * SAMPLER_DIMENSIONS_PER_BOUNCE;
+}
+
+// Randomly terminate a path after it went through rrDepth bounces.
+// Survival probability is proportional to the path throughput and the throughput of
+// surviving paths is divided by it, so the estimator stays unbiased.
+// @param depth Number of bounces so far.
+// @param rrDepth Russian roulette starts from this depth. Negative disables it.
+// @param u Uniform random value in [0, 1).
+// @return false if the path should be terminated.
+inline bool RussianRoulette(vec3& throughput, int32 depth, int32 rrDepth, float u)
+{
+	if (rrDepth < 0 || depth < rrDepth)
+	{
+		return true;
+	}
+	float maxComponent = std::max(throughput.x, std::max(throughput.y, throughput.z));
+	float survival = std::min(maxComponent, RUSSIAN_ROULETTE_MAX_SURVIVAL);
+	if (survival <= 0.0f || u >= survival)
+	{
+		return false;
+	}
+	throughput /= survival;
+	return true;
+}
+
+// MIS weight for a sample drawn from the strategy with sampledPdf,
+// when otherPdf is the pdf of the other strategy generating the same sample.
+inline float PowerHeuristic(float sampledPdf, float otherPdf)
+{
+	float a = sampledPdf * sampledPdf;
+	float b = otherPdf * otherPdf;
+	return (a + b > 0.0f) ? (a / (a + b)) : 0.0f;
+}
+
+// Result of light sampling at a surface point. The shadow ray is not traced yet.
+struct DirectLightSample
+{
+	ray   shadowRay;
+	float shadowRayTMax;
+	// Added to the path if the shadow ray is unoccluded. MIS weight is applied but not the path throughput.
+	vec3  radiance;
+};
+
+// Next event estimation: sample one light source (sun, sky, or emissive surface) for the hit.
+// The surface should support light sampling (Material::SupportsLightSampling()).
+// @return false if the light sample contributes nothing.
+bool SampleDirectLighting(
+	const Scene* world,
+	const ray& pathRay,
+	const HitResult& hitResult,
+	Sampler& sampler,
+	DirectLightSample& outSample);
+
+// First-hit values written to AOV images (see EAOV).
+struct AOVSample
+{
+	vec3   albedo;
+	vec3   normal;
+	float  depth;
+	uint32 objectID;
+	uint32 materialID;
+};
+
+// The orthonormal basis of hitResult should be built and its BSDF evaluated.
+void EvaluateAOVs(
+	const Scene* world,
+	const ray& cameraRay,
+	const HitResult& hitResult,
+	float rayTMin,
+	AOVSample& outSample);
+
+// Accumulates AOVs of a region while its pixels are path traced.
+class AOVAccumulator
+{
+
+public:
+	// @param inAOVMask   Bitmask of (1 << EAOV). Nothing is accumulated if zero.
+	// @param firstSample Sample index that provides the AOVs which are not averaged.
+	void Reset(uint32 inAOVMask, int32 numPixels, int32 firstSample = 0);
+	inline bool IsEnabled() const { return aovMask != 0; }
+
+	void AddSample(int32 pixelIx, int32 sampleIndex, const AOVSample& sample);
+
+	// Pixel i of the region is written to (x + i % width, y + i / width) of outAOVImages[EAOV].
+	void Resolve(int32 x, int32 y, int32 width, int32 numSamples, Image2D* const* outAOVImages) const;
+
+private:
+	uint32 aovMask = 0;
+	int32 firstSampleIndex = 0;
+	std::vector<vec3> albedo;
+	std::vector<vec3> normal;
+	std::vector<float> depth;
+	std::vector<uint32> objectID;
+	std::vector<uint32> materialID;
+};
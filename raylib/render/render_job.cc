@@ -0,0 +1,87 @@
+#include "render_job.h"
+#include "core/assertion.h"
+
+#include <chrono>
+
+RenderJob::RenderJob(RenderTileCallback inTileCallback, void* inCallbackUserData)
+	: tileCallback(inTileCallback)
+	, callbackUserData(inCallbackUserData)
+	, bCancelled(false)
+	, numDoneTiles(0)
+{
+}
+
+RenderJob::~RenderJob()
+{
+	Cancel();
+	// Threads still pop the empty queue once after the last tile.
+	threadPool.Join();
+}
+
+void RenderJob::AddTile(const WorkCell& cell)
+{
+	workCells.push_back(cell);
+}
+
+void RenderJob::Start(int32 numThreads, bool bPinThreads, uint32 pinSlotOffset, const WorkItemRoutine& renderTile)
+{
+	renderTileRoutine = renderTile;
+
+	threadPool.Initialize(numThreads, bPinThreads, pinSlotOffset);
+	for (size_t i = 0; i < workCells.size(); ++i)
+	{
+		ThreadPoolWork work;
+		work.routine = [this](const WorkItemParam* param) { RenderTile(param); };
+		work.arg = &workCells[i];
+		threadPool.AddWork(work);
+	}
+
+	constexpr bool blockingOperation = false;
+	threadPool.Start(blockingOperation);
+}
+
+float RenderJob::GetProgress() const
+{
+	if (workCells.size() == 0)
+	{
+		return 1.0f;
+	}
+	return (float)numDoneTiles / (float)workCells.size();
+}
+
+bool RenderJob::Wait(int32 timeoutMilliseconds)
+{
+	std::unique_lock<std::mutex> lock(doneLock);
+	auto IsDone = [this]() { return numDoneTiles == (int32)workCells.size(); };
+	if (timeoutMilliseconds < 0)
+	{
+		doneCondition.wait(lock, IsDone);
+		return true;
+	}
+	return doneCondition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), IsDone);
+}
+
+void RenderJob::Cancel()
+{
+	bCancelled = true;
+}
+
+void RenderJob::RenderTile(const WorkItemParam* param)
+{
+	if (!bCancelled)
+	{
+		renderTileRoutine(param);
+		if (tileCallback != nullptr)
+		{
+			const WorkCell* cell = reinterpret_cast<const WorkCell*>(param->arg);
+			tileCallback(callbackUserData, (uint32)cell->x, (uint32)cell->y, (uint32)cell->width, (uint32)cell->height);
+		}
+	}
+
+	// Notify under the lock so that the job is not destroyed between the check and the notification.
+	std::lock_guard<std::mutex> lock(doneLock);
+	if (++numDoneTiles == (int32)workCells.size())
+	{
+		doneCondition.notify_all();
+	}
+}
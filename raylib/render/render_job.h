@@ -0,0 +1,80 @@
+#pragma once
+
+#include "raylib_types.h"
+#include "core/int_types.h"
+#include "core/noncopyable.h"
+#include "core/thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+class Camera;
+class Scene;
+class Image2D;
+class Sampler;
+struct WorkCell;
+
+// Renders all samples of a cell. Picked once per view by the renderer.
+using RenderCellKernel = void(*)(const WorkCell* cell, Sampler& sampler);
+
+// A tile of a view, rendered by one thread.
+struct WorkCell {
+	int32 x;
+	int32 y;
+	int32 width;
+	int32 height;
+
+	Image2D* image;
+	Image2D* const* aovImages; // Null if no AOV is requested.
+	const Camera* camera;
+	const Scene* world;
+	RendererSettings rendererSettings;
+	RenderCellKernel kernel;
+};
+
+// Tiles rendered by a thread pool in the background.
+// Cancellation is checked at tile boundaries: tiles that have not started are skipped.
+class RenderJob : public Noncopyable
+{
+
+public:
+	// @param inTileCallback Called on a render thread after each tile is written. Can be null.
+	RenderJob(RenderTileCallback inTileCallback = nullptr, void* inCallbackUserData = nullptr);
+
+	// Cancels and joins the render threads. Should not be destroyed on a render thread.
+	~RenderJob();
+
+	// Do not add any tile after Start().
+	void AddTile(const WorkCell& cell);
+
+	// @param pinSlotOffset See RendererSettings::pinSlotOffset.
+	// @param renderTile Renders the WorkCell in WorkItemParam::arg.
+	void Start(int32 numThreads, bool bPinThreads, uint32 pinSlotOffset, const WorkItemRoutine& renderTile);
+
+	// Ratio of tiles finished or skipped, in [0, 1].
+	float GetProgress() const;
+
+	// @param timeoutMilliseconds Negative to wait without timeout.
+	// @return true if all tiles are finished or skipped.
+	bool Wait(int32 timeoutMilliseconds);
+
+	void Cancel();
+	inline bool IsCancelled() const { return bCancelled; }
+
+private:
+	void RenderTile(const WorkItemParam* param);
+
+	std::vector<WorkCell> workCells;
+	WorkItemRoutine renderTileRoutine;
+	ThreadPool threadPool;
+
+	RenderTileCallback tileCallback;
+	void* callbackUserData;
+
+	std::atomic<bool> bCancelled;
+	std::atomic<int32> numDoneTiles; // Finished or skipped
+	std::mutex doneLock;
+	std::condition_variable doneCondition;
+};
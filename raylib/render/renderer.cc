@@ -2,19 +2,28 @@
 #include "render/image.h"
 #include "render/camera.h"
 #include "render/material.h"
+#include "render/wavefront.h"
+#include "render/path_tracing.h"
+#include "render/denoiser.h"
+#include "render/accumulation_buffer.h"
+#include "render/render_job.h"
+#include "render/tile_buffer.h"
 #include "core/random.h"
+#include "core/sampler.h"
 #include "core/platform.h"
 #include "core/thread_pool.h"
+#include "core/cpu_affinity.h"
 #include "core/stat.h"
 #include "core/logger.h"
 #include "core/assertion.h"
 #include "geom/ray.h"
 #include "geom/hit.h"
+#include "geom/ray_packet.h"
 #include "geom/scene.h"
 #include "geom/transform.h"
 
 #include <algorithm>
-#include <thread>
+#include <chrono>
 #include <vector>
 
 // Determines the number of pixels processed by each task.
@@ -24,6 +33,13 @@
 // For easy debugging
 #define SINGLE_THREADED_RENDERING 0
 
+// Trace camera rays of each work cell as a packet.
+// Later bounces are always traced one ray at a time.
+#define PACKET_PRIMARY_RAYS 1
+
+STATIC_ASSERT(WORKGROUP_SIZE_X * WORKGROUP_SIZE_Y <= RAY_PACKET_SIZE);
+STATIC_ASSERT(WORKGROUP_SIZE_X * WORKGROUP_SIZE_Y <= TILE_BUFFER_MAX_PIXELS);
+
 // oidn is not Windows-only but I'm downloading Windows pre-built binaries.
 #if PLATFORM_WINDOWS
 	#define INTEL_DENOISER_INTEGRATED 1
@@ -32,262 +48,432 @@
 	//#pragma comment(lib, "tbb.lib")
 #endif
 
-struct WorkCell {
-	int32 x;
-	int32 y;
-	int32 width;
-	int32 height;
+// Checkpointed renders are split into passes of at most this many samples per pixel.
+// Work since the last checkpoint is lost if the process dies.
+#define CHECKPOINT_MAX_SAMPLES_PER_PASS 16
 
-	Image2D* image;
-	const Camera* camera;
-	const Scene* world;
-	RendererSettings rendererSettings;
-};
+// Use the built-in denoiser (render/denoiser.h) even if oidn is integrated.
+#define FORCE_BUILTIN_DENOISER 0
 
 // NOTE: Minimize this.
 struct RayPayload {
 	int32 maxRecursion;
 	float rayTMin;
+	int32 russianRouletteDepth;
 };
 
 bool Renderer::IsDenoiserSupported()
 {
-#if INTEL_DENOISER_INTEGRATED
+	// Falls back to the built-in denoiser if oidn is not integrated.
 	return true;
-#else
-	return false;
-#endif
 }
 
-vec3 TraceSceneDebugMode(
+// Features of a path tracing render that are known before it starts.
+// Each combination has its own instance of the per-pixel loop (see RenderCellPathTracing()),
+// so the loop has no branches for the features that a render doesn't use.
+enum EPathFeature : uint32
+{
+	PATH_FEATURE_Sky           = 1 << 0, // Scene has a sky panorama.
+	PATH_FEATURE_LightSampling = 1 << 1, // Scene has any light source (sun, sky, or emissive surfaces).
+	PATH_FEATURE_AOV           = 1 << 2, // AOV images are requested.
+
+	PATH_FEATURE_ALL           = (1 << 3) - 1
+};
+
+// Debug views only need primary visibility.
+template<ERenderMode DebugMode>
+vec3 ShadeSurfaceDebugMode(
 	const ray& pathRay,
+	const HitResult& hitResult,
 	const Scene* world,
 	const RayPayload& settings,
-	ERenderMode debugMode)
+	Sampler& sampler)
 {
 	vec3 debugValue = vec3(0.0f);
-	HitResult hitResult;
-	if (world->GetAccelStruct()->Hit(pathRay, settings.rayTMin, FLOAT_MAX, hitResult))
+	if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_Albedo)
 	{
-		if (debugMode == ERenderMode::RAYLIB_RENDERMODE_Albedo)
+		debugValue = hitResult.bsdf.albedo;
+		if (hitResult.material->IsMirrorLike(hitResult))
 		{
-			debugValue = hitResult.material->GetAlbedo(hitResult.paramU, hitResult.paramV);
-			if (hitResult.material->IsMirrorLike(hitResult.paramU, hitResult.paramV))
+			ray secondRay(hitResult.p, reflect(pathRay.d, hitResult.n), pathRay.t);
+			HitResult secondResult;
+			if (world->GetAccelStruct()->Hit(secondRay, settings.rayTMin, FLOAT_MAX, secondResult))
 			{
-				ray secondRay(hitResult.p, reflect(pathRay.d, hitResult.n), pathRay.t);
-				HitResult secondResult;
-				if (world->GetAccelStruct()->Hit(secondRay, settings.rayTMin, FLOAT_MAX, secondResult))
-				{
-					debugValue = secondResult.material->GetAlbedo(secondResult.paramU, secondResult.paramV);
-				}
+				debugValue = secondResult.material->GetAlbedo(secondResult.paramU, secondResult.paramV);
 			}
 		}
-		else if (debugMode == ERenderMode::RAYLIB_RENDERMODE_SurfaceNormal)
-		{
-			debugValue = vec3(0.5f) + 0.5f * hitResult.n;
-		}
-		else if (debugMode == ERenderMode::RAYLIB_RENDERMODE_MicrosurfaceNormal)
-		{
-			vec3 N = hitResult.material->GetMicrosurfaceNormal(hitResult);
-			N = hitResult.LocalToWorld(N);
-			debugValue = 0.5f + 0.5f * N;
-		}
-		else if (debugMode == ERenderMode::RAYLIB_RENDERMODE_Texcoord)
-		{
-			debugValue = vec3(hitResult.paramU, hitResult.paramV, 0.0f);
-		}
-		else if (debugMode == ERenderMode::RAYLIB_RENDERMODE_Emission)
-		{
-			debugValue = hitResult.material->Emitted(hitResult, pathRay.d);
-		}
-		else if (debugMode == ERenderMode::RAYLIB_RENDERMODE_Reflectance)
-		{
-			ray dummy; float dummy2;
-			debugValue = vec3(1.0f, 0.75f, 0.8f);
-			hitResult.material->Scatter(pathRay, hitResult, debugValue, dummy, dummy2);
-		}
+	}
+	else if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_SurfaceNormal)
+	{
+		debugValue = vec3(0.5f) + 0.5f * hitResult.n;
+	}
+	else if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_MicrosurfaceNormal)
+	{
+		vec3 N = hitResult.LocalToWorld(hitResult.bsdf.normal);
+		debugValue = 0.5f + 0.5f * N;
+	}
+	else if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_Texcoord)
+	{
+		debugValue = vec3(hitResult.paramU, hitResult.paramV, 0.0f);
+	}
+	else if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_Emission)
+	{
+		debugValue = hitResult.bsdf.emission;
+	}
+	else if (DebugMode == ERenderMode::RAYLIB_RENDERMODE_Reflectance)
+	{
+		ray dummy; float dummy2;
+		debugValue = vec3(1.0f, 0.75f, 0.8f);
+		hitResult.material->Scatter(pathRay, hitResult, sampler, debugValue, dummy, dummy2);
 	}
 	return debugValue;
 }
 
-// Run path tracing to find incoming radiance.
-vec3 TraceScene(
+// If nothing hit, get incoming radiance from sky atmosphere.
+// The Sun is a delta light; only light sampling can find it.
+template<uint32 Features>
+vec3 ShadeMiss(
 	const ray& pathRay,
 	const Scene* world,
-	int depth,
 	const RayPayload& settings)
 {
-	if (depth >= settings.maxRecursion)
+	if ((Features & PATH_FEATURE_Sky) == 0)
 	{
 		return vec3(0.0f);
 	}
+	return world->GetSkyRadiance(pathRay.d);
+}
 
-	// #todo-pbr: Direct sampling of light sources + multiple importance sampling
-	// #todo-pbr: Still not sure if I did importance sampling right. Verify again.
+// Run path tracing to find incoming radiance along cameraRay, given its closest hit.
+// Bounces are traced in a loop that carries the path throughput,
+// and low-throughput paths are terminated by Russian roulette.
+// At each surface that supports it, a light source is sampled directly (next event estimation)
+// and combined with emission found by scattered rays using multiple importance sampling.
+// The sampler should be started for the pixel sample of cameraRay.
+template<uint32 Features>
+vec3 TracePath(
+	const ray& cameraRay,
+	const HitResult& primaryHit,
+	const Scene* world,
+	const RayPayload& settings,
+	Sampler& sampler)
+{
+	vec3 radiance(0.0f);
+	vec3 throughput(1.0f);
+	ray pathRay = cameraRay;
+	HitResult hitResult = primaryHit;
 
-	HitResult hitResult;
-	if (world->GetAccelStruct()->Hit(pathRay, settings.rayTMin, FLOAT_MAX, hitResult))
+	// Previous bounce, to weight emission found by BSDF sampling.
+	bool bPrevSpecular = true;
+	float prevScatteringPdf = 0.0f;
+	vec3 prevPosition = cameraRay.o;
+
+	for (int32 depth = 0; ; ++depth)
 	{
 		hitResult.BuildOrthonormalBasis();
+		hitResult.EvaluateBSDF();
+		const Material* material = hitResult.material;
+		const int32 bounceDimension = GetBounceDimension(depth);
 
-		vec3 radiance(0.0f);
+		// Emission from the surface itself.
+		const vec3& Le = hitResult.bsdf.emission;
+		if (Le != vec3(0.0f))
+		{
+			float weight = 1.0f;
+			if (!bPrevSpecular)
+			{
+				weight = PowerHeuristic(prevScatteringPdf, world->EmitterPdf(prevPosition, hitResult));
+			}
+			radiance += throughput * Le * weight;
+		}
+
+		if (depth + 1 >= settings.maxRecursion)
+		{
+			break;
+		}
+
+		// Next event estimation
+		const bool bSpecular = !material->SupportsLightSampling(hitResult);
+		DirectLightSample lightSample;
+		sampler.SetDimension(bounceDimension + SAMPLER_OFFSET_LIGHT);
+		if ((Features & PATH_FEATURE_LightSampling) != 0
+			&& !bSpecular && SampleDirectLighting(world, pathRay, hitResult, sampler, lightSample))
+		{
+			// Visibility only; no surface data is needed.
+			TraversalHit dummy;
+			if (!world->GetAccelStruct()->Intersect(lightSample.shadowRay, settings.rayTMin, lightSample.shadowRayTMax, dummy))
+			{
+				radiance += throughput * lightSample.radiance;
+			}
+		}
 
-		// Recursively trace light scattering.
 		vec3 reflectance;
 		ray scatteredRay;
 		float pdf;
-		if (hitResult.material->Scatter(pathRay, hitResult, reflectance, scatteredRay, pdf))
+		sampler.SetDimension(bounceDimension + SAMPLER_OFFSET_SCATTERING);
+		if (!material->Scatter(pathRay, hitResult, sampler, reflectance, scatteredRay, pdf) || pdf <= 0.0f)
+		{
+			break;
+		}
+		float scatteringPdf = material->ScatteringPdf(hitResult, -pathRay.d, scatteredRay.d);
+		throughput *= reflectance * scatteringPdf / pdf;
+
+		sampler.SetDimension(bounceDimension + SAMPLER_OFFSET_RUSSIAN_ROULETTE);
+		if (!RussianRoulette(throughput, depth + 1, settings.russianRouletteDepth, sampler.Get1D()))
 		{
-			if (pdf > 0.0f)
+			break;
+		}
+
+		bPrevSpecular = bSpecular;
+		prevScatteringPdf = pdf;
+		prevPosition = hitResult.p;
+
+		pathRay = scatteredRay;
+		if (!world->GetAccelStruct()->Hit(pathRay, settings.rayTMin, FLOAT_MAX, hitResult))
+		{
+			if ((Features & PATH_FEATURE_Sky) != 0)
 			{
-				vec3 Li = TraceScene(scatteredRay, world, depth + 1, settings);
-				float scatteringPdf = hitResult.material->ScatteringPdf(hitResult, -pathRay.d, scatteredRay.d);
-				radiance += reflectance * Li * scatteringPdf / pdf;
+				float weight = 1.0f;
+				if (!bPrevSpecular)
+				{
+					weight = PowerHeuristic(prevScatteringPdf, world->SkyPdf(pathRay.d));
+				}
+				radiance += throughput * ShadeMiss<Features>(pathRay, world, settings) * weight;
 			}
+			break;
 		}
+	}
 
-		// Emission from the surface itself.
-		// This is irrelevant to incoming radiances for the surface.
-		radiance += hitResult.material->Emitted(hitResult, pathRay.d);
-		
-		return radiance;
+	return radiance;
+}
+
+// Generate camera rays for all pixels in the cell and find their closest hits.
+// Rays are stored in row-major order of the cell.
+void TracePrimaryRays(
+	const WorkCell* cell,
+	bool bJitter,
+	int32 sampleIndex,
+	Sampler& sampler,
+	RayPacket& outPacket,
+	HitResult* outHits)
+{
+	const int32 endY = cell->y + cell->height;
+	const int32 endX = cell->x + cell->width;
+	const float imageWidth = (float)cell->image->GetWidth();
+	const float imageHeight = (float)cell->image->GetHeight();
+
+	int32 lane = 0;
+	for (int32 y = cell->y; y < endY; ++y) {
+		for (int32 x = cell->x; x < endX; ++x) {
+			float u = (float)x / imageWidth;
+			float v = (float)y / imageHeight;
+			sampler.StartPixelSample(x, y, sampleIndex);
+			float jitterU, jitterV;
+			sampler.Get2D(jitterU, jitterV);
+			if (bJitter) {
+				u += (jitterU - 0.5f) * 2.0f / imageWidth;
+				v += (jitterV - 0.5f) * 2.0f / imageHeight;
+			}
+			outPacket.SetRay(lane++, cell->camera->GetCameraRay(u, v, sampler));
+		}
 	}
+	outPacket.Finalize(lane);
 
-	// If nothing hit, get incoming radiance from sky atmosphere and Sun.
-	vec3 missResult(0.0f);
-	// Distant lighting: Sky
-	ImageHandle skyLightHandle = world->GetSkyPanorama();
-	if (skyLightHandle != NULL)
-	{
-		vec3 dir = pathRay.d;
-		dir.Normalize();
+	const float rayTMin = cell->rendererSettings.rayTMin;
+	TraversalHit closestHits[RAY_PACKET_SIZE];
+#if PACKET_PRIMARY_RAYS
+	cell->world->GetAccelStruct()->HitPacket(outPacket, rayTMin, closestHits);
+#else
+	for (int32 i = 0; i < outPacket.numRays; ++i) {
+		outPacket.hit[i] = cell->world->GetAccelStruct()->Intersect(outPacket.GetRay(i), rayTMin, FLOAT_MAX, closestHits[i]);
+	}
+#endif
 
-		// #todo-wip: Control sky image rotation in Scene.
-		Rotator rot;
-		rot.yaw = 90.0f;
-		vec3 D = rot.rotate(dir);
-		//const vec3& D = dir;
+	// Surface data only for the final hits.
+	for (int32 i = 0; i < outPacket.numRays; ++i) {
+		if (outPacket.hit[i]) {
+			closestHits[i].object->ComputeSurfaceInteraction(outPacket.GetRay(i), closestHits[i], outHits[i]);
+		}
+	}
+}
 
-		// #todo-wip: Is there a case uv goes to inf or nan?
-		float u = std::atan2(D.z, D.x), v = std::asin(D.y);
-		u *= 0.1591f; v *= 0.3183f; // inverse atan
-		u += 0.5f; v += 0.5f;
+Sampler& GetThreadSampler(uint32 samplerType) {
+	static thread_local IndependentSampler independentSampler;
+	static thread_local SobolSampler sobolSampler;
+	if (samplerType == ESampler::RAYLIB_SAMPLER_Independent) {
+		return independentSampler;
+	}
+	return sobolSampler;
+}
 
-		Image2D* skyLight = (Image2D*)skyLightHandle;
-		int32 x = (int32)(u * (skyLight->GetWidth() - 1));
-		int32 y = (int32)(v * (skyLight->GetHeight() - 1));
+static thread_local RayPacket primaryPacket;
+static thread_local HitResult primaryHits[RAY_PACKET_SIZE];
+
+void RenderCellWavefront(const WorkCell* cell, Sampler& sampler) {
+	static thread_local WavefrontIntegrator wavefront;
+	wavefront.RenderRegion(
+		cell->rendererSettings,
+		cell->world,
+		cell->camera,
+		sampler,
+		cell->x, cell->y, cell->width, cell->height,
+		cell->image,
+		cell->aovImages);
+}
 
-		missResult += skyLight->GetPixel(x, y).RGBToVec3();
+template<uint32 Features>
+void RenderCellPathTracing(const WorkCell* cell, Sampler& sampler) {
+	RayPacket& packet = primaryPacket;
+	const int32 numPixels = cell->width * cell->height;
+	const int32 SPP = std::max(1, cell->rendererSettings.samplesPerPixel);
+	const int32 firstSample = std::max(0, cell->rendererSettings.firstSample);
+	RayPayload rtSettings{
+		cell->rendererSettings.maxPathLength,
+		cell->rendererSettings.rayTMin,
+		cell->rendererSettings.russianRouletteDepth,
+	};
+	vec3 accum[RAY_PACKET_SIZE];
+	static thread_local AOVAccumulator aovs;
+	if ((Features & PATH_FEATURE_AOV) != 0) {
+		aovs.Reset(cell->rendererSettings.aovMask, numPixels, firstSample);
 	}
-	else
-	{
-		// #todo-wip: Fallback sky
-		//float t = 0.5f * (dir.y + 1.0f);
-		//return ((1.0f - t) * vec3(1.0f, 1.0f, 1.0f) + t * vec3(0.5f, 0.7f, 1.0f));
-	}
-	// Distant lighting: Sun
-	vec3 sunDir, sunIlluminance;
-	world->GetSun(sunIlluminance, sunDir);
-	if (sunIlluminance != vec3(0.0f))
-	{
-		ray rayToSun(pathRay.o, -sunDir, pathRay.t);
-		if (!world->GetAccelStruct()->Hit(rayToSun, settings.rayTMin, FLOAT_MAX, hitResult))
-		{
-			missResult += sunIlluminance;
+	for (int32 s = firstSample; s < firstSample + SPP; ++s) {
+		// Primary visibility for the whole cell at once, then continue each path alone.
+		TracePrimaryRays(cell, true, s, sampler, packet, primaryHits);
+		if ((Features & PATH_FEATURE_AOV) != 0) {
+			for (int32 i = 0; i < numPixels; ++i) {
+				if (packet.hit[i]) {
+					HitResult hitResult = primaryHits[i];
+					hitResult.BuildOrthonormalBasis();
+					hitResult.EvaluateBSDF();
+					AOVSample aov;
+					EvaluateAOVs(cell->world, packet.GetRay(i), hitResult, rtSettings.rayTMin, aov);
+					aovs.AddSample(i, s, aov);
+				}
+			}
+		}
+		if (rtSettings.maxRecursion <= 0) {
+			continue;
+		}
+		for (int32 i = 0; i < numPixels; ++i) {
+			ray cameraRay = packet.GetRay(i);
+			sampler.StartPixelSample(cell->x + (i % cell->width), cell->y + (i / cell->width), s);
+			vec3 Li = packet.hit[i]
+				? TracePath<Features>(cameraRay, primaryHits[i], cell->world, rtSettings, sampler)
+				: ShadeMiss<Features>(cameraRay, cell->world, rtSettings);
+			accum[i] += Li;
 		}
 	}
-	return missResult;
+	TileBuffer tile;
+	tile.Reset(cell->x, cell->y, cell->width, cell->height);
+	for (int32 i = 0; i < numPixels; ++i) {
+		vec3 L = accum[i] / (float)SPP;
+		tile.SetPixel(i, Pixel(L.x, L.y, L.z));
+	}
+	tile.Publish(cell->image);
+	if ((Features & PATH_FEATURE_AOV) != 0) {
+		aovs.Resolve(cell->x, cell->y, cell->width, SPP, cell->aovImages);
+	}
 }
-// Initial ray is a camera ray.
-vec3 TraceScene(
-	const ray& cameraRay,
-	const Scene* world,
-	const RayPayload& settings)
-{
-	return TraceScene(cameraRay, world, 0, settings);
+
+template<ERenderMode DebugMode>
+void RenderCellDebugMode(const WorkCell* cell, Sampler& sampler) {
+	RayPacket& packet = primaryPacket;
+	const int32 numPixels = cell->width * cell->height;
+	RayPayload rtSettings{
+		cell->rendererSettings.maxPathLength,
+		cell->rendererSettings.rayTMin,
+		cell->rendererSettings.russianRouletteDepth,
+	};
+	TracePrimaryRays(cell, false, std::max(0, cell->rendererSettings.firstSample), sampler, packet, primaryHits);
+	TileBuffer tile;
+	tile.Reset(cell->x, cell->y, cell->width, cell->height);
+	for (int32 i = 0; i < numPixels; ++i) {
+		vec3 debugValue(0.0f);
+		if (packet.hit[i]) {
+			primaryHits[i].BuildOrthonormalBasis();
+			primaryHits[i].EvaluateBSDF();
+			debugValue = ShadeSurfaceDebugMode<DebugMode>(
+				packet.GetRay(i),
+				primaryHits[i],
+				cell->world,
+				rtSettings,
+				sampler);
+		}
+		tile.SetPixel(i, Pixel(debugValue.x, debugValue.y, debugValue.z));
+	}
+	tile.Publish(cell->image);
 }
 
-void GenerateCell(const WorkItemParam* param) {
-	static thread_local RNG randomsAA(4096 * 8);
+// Pick the cell kernel of a view. Features are fixed for the whole render.
+static RenderCellKernel GetRenderCellKernel(const RendererSettings& settings, const Scene* world, bool bRenderAOVs) {
+	static const RenderCellKernel pathTracingKernels[PATH_FEATURE_ALL + 1] = {
+		RenderCellPathTracing<0>, RenderCellPathTracing<1>, RenderCellPathTracing<2>, RenderCellPathTracing<3>,
+		RenderCellPathTracing<4>, RenderCellPathTracing<5>, RenderCellPathTracing<6>, RenderCellPathTracing<7>,
+	};
+	static const RenderCellKernel debugModeKernels[ERenderMode::RAYLIB_RENDERMODE_MAX] = {
+		nullptr, // Default is path tracing.
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_Albedo>,
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_SurfaceNormal>,
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_MicrosurfaceNormal>,
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_Texcoord>,
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_Emission>,
+		RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_Reflectance>,
+	};
+	STATIC_ASSERT(ERenderMode::RAYLIB_RENDERMODE_MAX == 7);
+
+	if (settings.renderMode != ERenderMode::RAYLIB_RENDERMODE_Default) {
+		// Invalid modes render black, as no debug value matches them.
+		return (settings.renderMode < ERenderMode::RAYLIB_RENDERMODE_MAX)
+			? debugModeKernels[settings.renderMode]
+			: RenderCellDebugMode<ERenderMode::RAYLIB_RENDERMODE_MAX>;
+	}
+	if (settings.integrator == EIntegrator::RAYLIB_INTEGRATOR_Wavefront) {
+		return RenderCellWavefront;
+	}
 
-	int32 threadID = param->threadID;
-	WorkCell* cell = reinterpret_cast<WorkCell*>(param->arg);
+	uint32 features = 0;
+	if (world->GetSkyPanorama() != NULL) {
+		features |= PATH_FEATURE_Sky;
+	}
+	if (world->HasLightSources()) {
+		features |= PATH_FEATURE_LightSampling;
+	}
+	if (bRenderAOVs) {
+		features |= PATH_FEATURE_AOV;
+	}
+	return pathTracingKernels[features];
+}
 
-	const int32 endY = cell->y + cell->height;
-	const int32 endX = cell->x + cell->width;
+void GenerateCell(const WorkItemParam* param) {
+	const WorkCell* cell = reinterpret_cast<const WorkCell*>(param->arg);
 
-	const float imageWidth = (float)cell->image->GetWidth();
-	const float imageHeight = (float)cell->image->GetHeight();
+	Sampler& sampler = GetThreadSampler(cell->rendererSettings.sampler);
+	sampler.SetSeed(cell->rendererSettings.seed);
 
 	// #todo-multithread: Bad utilization of threads; Some cells might take longer than others.
-	if (cell->rendererSettings.renderMode == ERenderMode::RAYLIB_RENDERMODE_Default) {
-		const int32 SPP = std::max(1, cell->rendererSettings.samplesPerPixel);
-		RayPayload rtSettings{
-			cell->rendererSettings.maxPathLength,
-			cell->rendererSettings.rayTMin,
-		};
-		for (int32 y = cell->y; y < endY; ++y) {
-			for (int32 x = cell->x; x < endX; ++x) {
-				vec3 accum(0.0f, 0.0f, 0.0f);
-				for (int32 s = 0; s < SPP; ++s) {
-					float u = (float)x / imageWidth;
-					float v = (float)y / imageHeight;
-					if (s != 0) {
-						u += (randomsAA.Peek() - 0.5f) * 2.0f / imageWidth;
-						v += (randomsAA.Peek() - 0.5f) * 2.0f / imageHeight;
-					}
-					ray cameraRay = cell->camera->GetCameraRay(u, v);
-					vec3 Li = TraceScene(
-						cameraRay,
-						cell->world,
-						rtSettings);
-					accum += Li;
-				}
-				accum /= (float)SPP;
-				Pixel px(accum.x, accum.y, accum.z);
-				cell->image->SetPixel(x, y, px);
-			}
-		}
-	} else {
-		RayPayload rtSettings{
-			cell->rendererSettings.maxPathLength,
-			cell->rendererSettings.rayTMin,
-		};
-		for (int32 y = cell->y; y < endY; ++y) {
-			for (int32 x = cell->x; x < endX; ++x) {
-				float u = (float)x / imageWidth;
-				float v = (float)y / imageHeight;
-				ray cameraRay = cell->camera->GetCameraRay(u, v);
-				vec3 debugValue = TraceSceneDebugMode(
-					cameraRay,
-					cell->world,
-					rtSettings,
-					(ERenderMode)cell->rendererSettings.renderMode);
-				Pixel px(debugValue.x, debugValue.y, debugValue.z);
-				cell->image->SetPixel(x, y, px);
-			}
-		}
-	}
+	cell->kernel(cell, sampler);
 }
 
 void Renderer::RenderScene(
 	const RendererSettings* settingsPtr,
 	const Scene* world,
 	const Camera* camera,
-	Image2D* outImage)
+	Image2D* outImage,
+	Image2D* const* outAOVImages)
 {
-	CHECK(settingsPtr != nullptr && world != nullptr && camera != nullptr && outImage != nullptr);
-	CHECK(world->GetAccelStruct() != nullptr);
+	RenderView view{ settingsPtr, camera, outImage, outAOVImages };
+	RenderViews(world, &view, 1);
+}
 
-#if SINGLE_THREADED_RENDERING
-	const uint32 numCores = 1;
-	LOG("CAUTION: Rendering is forced to be single threaded - search for 'SINGLE_THREADED_RENDERING'");
-#else
-	const uint32 numCores = std::max((uint32)1, (uint32)std::thread::hardware_concurrency());
-	//LOG("Number of logical cores: %u", numCores);
-#endif
+// Reallocate images of the view and append the tiles of its crop window.
+static void AddViewWorkCells(const Scene* world, const RenderView& view, std::vector<WorkCell>& outWorkCells)
+{
+	CHECK(view.settings != nullptr && view.camera != nullptr && view.outImage != nullptr);
 
-	const RendererSettings& settings = *settingsPtr;
+	const RendererSettings& settings = *view.settings;
+	Image2D* outImage = view.outImage;
+	Image2D* const* outAOVImages = view.outAOVImages;
 
 	if (settings.viewportWidth != outImage->GetWidth()
 		|| settings.viewportHeight != outImage->GetHeight())
@@ -295,64 +481,188 @@ void Renderer::RenderScene(
 		outImage->Reallocate(settings.viewportWidth, settings.viewportHeight);
 	}
 
-	const int32 imageWidth = outImage->GetWidth();
-	const int32 imageHeight = outImage->GetHeight();
-	const int32 spp = settings.samplesPerPixel;
+	// AOVs are only meaningful for path tracing.
+	const bool bRenderAOVs = outAOVImages != nullptr
+		&& settings.aovMask != 0
+		&& settings.renderMode == ERenderMode::RAYLIB_RENDERMODE_Default;
+	if (bRenderAOVs)
+	{
+		for (int32 aov = 0; aov < (int32)EAOV::RAYLIB_AOV_MAX; ++aov)
+		{
+			if ((settings.aovMask & (1u << aov)) == 0)
+			{
+				continue;
+			}
+			Image2D* aovImage = outAOVImages[aov];
+			CHECKF(aovImage != nullptr, "Requested AOV image should not be null");
+			if (settings.viewportWidth != aovImage->GetWidth()
+				|| settings.viewportHeight != aovImage->GetHeight())
+			{
+				aovImage->Reallocate(settings.viewportWidth, settings.viewportHeight);
+			}
+		}
+	}
 
-	ThreadPool tp;
-	tp.Initialize(numCores);
+	const RenderCellKernel kernel = GetRenderCellKernel(settings, world, bRenderAOVs);
 
-	std::vector<WorkCell> workCells;
-	for (int32 x = 0; x < imageWidth; x += WORKGROUP_SIZE_X) {
-		for (int32 y = 0; y < imageHeight; y += WORKGROUP_SIZE_Y) {
+	// Only the tiles of the crop window are scheduled.
+	uint32 cropX, cropY, cropWidth, cropHeight;
+	settings.getCropRect(cropX, cropY, cropWidth, cropHeight);
+	const int32 endX = (int32)(cropX + cropWidth);
+	const int32 endY = (int32)(cropY + cropHeight);
+
+	for (int32 x = (int32)cropX; x < endX; x += WORKGROUP_SIZE_X) {
+		for (int32 y = (int32)cropY; y < endY; y += WORKGROUP_SIZE_Y) {
 			WorkCell cell;
 			cell.x = x;
 			cell.y = y;
-			cell.width = std::min(WORKGROUP_SIZE_X, imageWidth - x);
-			cell.height = std::min(WORKGROUP_SIZE_Y, imageHeight - y);
+			cell.width = std::min(WORKGROUP_SIZE_X, endX - x);
+			cell.height = std::min(WORKGROUP_SIZE_Y, endY - y);
 			cell.image = outImage;
-			cell.camera = camera;
+			cell.aovImages = bRenderAOVs ? outAOVImages : nullptr;
+			cell.camera = view.camera;
 			cell.world = world;
 			cell.rendererSettings = settings;
-			workCells.emplace_back(cell);
+			cell.kernel = kernel;
+			outWorkCells.emplace_back(cell);
+		}
+	}
+}
+
+void Renderer::RenderViews(const Scene* world, const RenderView* views, int32 numViews)
+{
+	SCOPED_CPU_COUNTER(ThreadPoolWorkTime);
+
+	RenderJob* job = StartRenderViews(world, views, numViews);
+
+	// progress
+	int32 milestoneIx = 0;
+	std::vector<float> milestones(9);
+	for (int32 i = 1; i <= 9; ++i) {
+		milestones[i - 1] = (float)i / 10.0f;
+	}
+
+	while (!job->Wait(100)) {
+		float progress = job->GetProgress();
+		if (milestoneIx < milestones.size() && progress >= milestones[milestoneIx]) {
+			LOG("%d percent complete...", (int32)(progress * 100));
+			milestoneIx += 1;
 		}
 	}
-	for (auto i = 0u; i < workCells.size(); ++i) {
-		ThreadPoolWork work;
-		work.routine = GenerateCell;
-		work.arg = &workCells[i];
 
-		tp.AddWork(work);
+	delete job;
+}
+
+RenderJob* Renderer::StartRenderViews(
+	const Scene* world,
+	const RenderView* views,
+	int32 numViews,
+	RenderTileCallback tileCallback,
+	void* callbackUserData)
+{
+	CHECK(world != nullptr && (views != nullptr || numViews == 0));
+	CHECK(world->GetAccelStruct() != nullptr);
+
+	// Thread settings are taken from the first view.
+	const RendererSettings* threadSettings = (numViews > 0) ? views[0].settings : nullptr;
+#if SINGLE_THREADED_RENDERING
+	const uint32 numCores = 1;
+	LOG("CAUTION: Rendering is forced to be single threaded - search for 'SINGLE_THREADED_RENDERING'");
+#else
+	const uint32 numCores = (threadSettings != nullptr && threadSettings->numThreads > 0)
+		? threadSettings->numThreads
+		: GetNumUsableCores();
+	//LOG("Number of logical cores: %u", numCores);
+#endif
+	const bool bPinThreads = threadSettings != nullptr && threadSettings->pinThreads != 0;
+	const uint32 pinSlotOffset = (threadSettings != nullptr) ? threadSettings->pinSlotOffset : 0;
+
+	// Tiles of all views go to one queue, so threads that finish a view
+	// move on to the next one instead of waiting for the slowest tile.
+	std::vector<WorkCell> workCells;
+	for (int32 viewIx = 0; viewIx < numViews; ++viewIx) {
+		AddViewWorkCells(world, views[viewIx], workCells);
+	}
+
+	RenderJob* job = new RenderJob(tileCallback, callbackUserData);
+	for (const WorkCell& cell : workCells) {
+		job->AddTile(cell);
 	}
 
 	//LOG("number of work items: %d", (int32)workCells.size());
 
+	job->Start((int32)numCores, bPinThreads, pinSlotOffset, GenerateCell);
+	return job;
+}
+
+int32 Renderer::RenderSceneWithCheckpoints(
+	const RendererSettings* settingsPtr,
+	const Scene* world,
+	const Camera* camera,
+	Image2D* outImage,
+	Image2D* const* outAOVImages,
+	const char* checkpointPath,
+	float checkpointIntervalSeconds)
+{
+	CHECK(settingsPtr != nullptr && outImage != nullptr && checkpointPath != nullptr);
+
+	RendererSettings settings = *settingsPtr;
+	settings.firstSample = std::max(0, settings.firstSample);
+	if (outAOVImages == nullptr || settings.renderMode != ERenderMode::RAYLIB_RENDERMODE_Default)
 	{
-		SCOPED_CPU_COUNTER(ThreadPoolWorkTime);
+		settings.aovMask = 0;
+	}
 
-		constexpr bool blockingOperation = false;
-		tp.Start(blockingOperation);
+	AccumulationBuffer accumulation;
+	if (accumulation.LoadCheckpoint(checkpointPath, settings))
+	{
+		LOG("Resume from checkpoint: %s (%d samples per pixel)", checkpointPath, accumulation.GetNextSample(settings) - settings.firstSample);
+	}
+	else
+	{
+		accumulation.Reset(settings);
+	}
 
-		// progress
-		int32 milestoneIx = 0;
-		std::vector<float> milestones(9);
-		for (int32 i = 1; i <= 9; ++i) {
-			milestones[i - 1] = (float)i / 10.0f;
-		}
+	Image2D passImage;
+	Image2D passAOVImagesStorage[RAYLIB_AOV_MAX];
+	Image2D* passAOVImages[RAYLIB_AOV_MAX];
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		passAOVImages[aov] = &passAOVImagesStorage[aov];
+	}
 
-		while (true) {
-			if (tp.IsDone()) {
-				break;
-			} else {
-				float progress = tp.GetProgress();
-				if (milestoneIx < milestones.size() && progress >= milestones[milestoneIx]) {
-					LOG("%d percent complete...", (int32)(progress * 100));
-					milestoneIx += 1;
-				}
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	const int32 endSample = settings.firstSample + std::max(1, settings.samplesPerPixel);
+	const int32 resumedSample = accumulation.GetNextSample(settings);
+	auto lastCheckpointTime = std::chrono::steady_clock::now();
+	bool bCheckpointDirty = false;
+	bool bCheckpointFailed = false;
+
+	for (int32 passSample = resumedSample; passSample < endSample; passSample = accumulation.GetNextSample(settings))
+	{
+		RendererSettings passSettings = settings;
+		passSettings.firstSample = passSample;
+		passSettings.samplesPerPixel = std::min(CHECKPOINT_MAX_SAMPLES_PER_PASS, endSample - passSample);
+		RenderScene(&passSettings, world, camera, &passImage, passAOVImages);
+		accumulation.AddSamples(passSettings, &passImage, passAOVImages);
+		bCheckpointDirty = true;
+
+		auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<float>(now - lastCheckpointTime).count() >= checkpointIntervalSeconds)
+		{
+			bCheckpointFailed |= !accumulation.SaveCheckpoint(checkpointPath);
+			bCheckpointDirty = false;
+			lastCheckpointTime = now;
+			LOG("Checkpoint: %d samples per pixel", accumulation.GetNextSample(settings) - settings.firstSample);
 		}
 	}
+	if (bCheckpointDirty)
+	{
+		bCheckpointFailed |= !accumulation.SaveCheckpoint(checkpointPath);
+	}
+
+	accumulation.Resolve(outImage, outAOVImages);
+
+	return bCheckpointFailed ? -1 : std::max(0, endSample - resumedSample);
 }
 
 bool Renderer::DenoiseScene(
@@ -369,7 +679,7 @@ bool Renderer::DenoiseScene(
 		return false;
 	}
 
-#if INTEL_DENOISER_INTEGRATED
+#if INTEL_DENOISER_INTEGRATED && !FORCE_BUILTIN_DENOISER
 	const size_t viewportWidth = mainImage->GetWidth();
 	const size_t viewportHeight = mainImage->GetHeight();
 
@@ -437,7 +747,11 @@ bool Renderer::DenoiseScene(
 			k += 3;
 		}
 	}
-#endif // INTEL_DENOISER_INTEGRATED
 
 	return true;
+#else
+	// bMainImageHDR is irrelevant as the filter works on linear values.
+	SCOPED_CPU_COUNTER(DenoiseATrous);
+	return DenoiseATrous(mainImage, albedoImage, normalImage, outDenoisedImage);
+#endif // INTEL_DENOISER_INTEGRATED
 }
@@ -8,17 +8,56 @@ class Hitable;
 class Camera;
 class Scene;
 class Image2D;
+class RenderJob;
+
+// One of the views rendered by Renderer::RenderViews().
+struct RenderView
+{
+	const RendererSettings* settings;
+	const Camera* camera;
+	Image2D* outImage;
+	Image2D* const* outAOVImages; // Same as RenderScene(); can be null.
+};
 
 class Renderer
 {
 public:
 	static bool IsDenoiserSupported();
 
+	// Images are reallocated only if they are not of the viewport size;
+	// pixels outside of the crop window are left as they are.
+	// @param outAOVImages Array of RAYLIB_AOV_MAX images, indexed by EAOV.
+	//                    Only the ones requested by settings->aovMask are used and they can't be null.
 	void RenderScene(
 		const RendererSettings* settings,
 		const Scene* world,
 		const Camera* camera,
-		Image2D* outImage);
+		Image2D* outImage,
+		Image2D* const* outAOVImages = nullptr);
+
+	// Render several views of one scene with a single job queue of the tiles of all views.
+	// Views should not share output images.
+	void RenderViews(const Scene* world, const RenderView* views, int32 numViews);
+
+	// Same as RenderViews(), but returns without waiting. Delete the job to release it.
+	// Settings are copied, but the scene, cameras and images should be kept until the job is done.
+	RenderJob* StartRenderViews(
+		const Scene* world,
+		const RenderView* views,
+		int32 numViews,
+		RenderTileCallback tileCallback = nullptr,
+		void* callbackUserData = nullptr);
+
+	// Render in passes of sample ranges and accumulate them in a checkpoint file.
+	// See Raylib_RenderWithCheckpoints().
+	int32 RenderSceneWithCheckpoints(
+		const RendererSettings* settings,
+		const Scene* world,
+		const Camera* camera,
+		Image2D* outImage,
+		Image2D* const* outAOVImages,
+		const char* checkpointPath,
+		float checkpointIntervalSeconds);
 
 	bool DenoiseScene(
 		Image2D* mainImage,
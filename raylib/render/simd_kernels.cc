@@ -0,0 +1,213 @@
+#include "simd_kernels.h"
+#include "core/cpu_features.h"
+#include "core/vec4.h"
+#include "core/vec8.h"
+#include "core/logger.h"
+#include "geom/ray_packet.h"
+#include "render/image.h"
+
+#include <string.h>
+
+// -------------------------------
+// Generic kernels: vec4/vec8 with the compiler's baseline instruction set.
+
+static bool PacketHitBox_Generic(const RayPacket& packet, const AABB& box, float tMin)
+{
+	const vec8 minX(box.minBounds.x), minY(box.minBounds.y), minZ(box.minBounds.z);
+	const vec8 maxX(box.maxBounds.x), maxY(box.maxBounds.y), maxZ(box.maxBounds.z);
+	const vec8 tMin8(tMin);
+
+	const int32 numGroups = (packet.numRays + 7) / 8;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 8 * g;
+		const vec8 oX = vec8::Load(packet.ox + k), oY = vec8::Load(packet.oy + k), oZ = vec8::Load(packet.oz + k);
+		const vec8 iX = vec8::Load(packet.invDx + k), iY = vec8::Load(packet.invDy + k), iZ = vec8::Load(packet.invDz + k);
+
+		const vec8 t0x = (minX - oX) * iX, t1x = (maxX - oX) * iX;
+		const vec8 t0y = (minY - oY) * iY, t1y = (maxY - oY) * iY;
+		const vec8 t0z = (minZ - oZ) * iZ, t1z = (maxZ - oZ) * iZ;
+
+		const vec8 tNear = max(tMin8, max(min(t0x, t1x), max(min(t0y, t1y), min(t0z, t1z))));
+		const vec8 tFar = min(vec8::Load(packet.tMax + k), min(max(t0x, t1x), min(max(t0y, t1y), max(t0z, t1z))));
+
+		if (MoveMask(tNear <= tFar) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static uint64 PacketHitTriangle_Generic(const RayPacket& packet, const TriangleKernelData& tri, float tMin,
+	float* outT, float* outBaryU, float* outBaryV)
+{
+	const vec8 V0x(tri.v0[0]), V0y(tri.v0[1]), V0z(tri.v0[2]);
+	const vec8 Nx(tri.n[0]), Ny(tri.n[1]), Nz(tri.n[2]);
+	const vec8 Ux(tri.edgeU[0]), Uy(tri.edgeU[1]), Uz(tri.edgeU[2]);
+	const vec8 Vx(tri.edgeV[0]), Vy(tri.edgeV[1]), Vz(tri.edgeV[2]);
+	const vec8 UV(tri.uv), UU(tri.uu), VV(tri.vv);
+	const vec8 DENOM(tri.uv * tri.uv - tri.uu * tri.vv);
+	const vec8 ZERO(0.0f), ONE(1.0f);
+	const vec8 TMIN(tMin);
+
+	uint64 hitMask = 0;
+	const int32 numGroups = (packet.numRays + 7) / 8;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 8 * g;
+		const vec8 oX = vec8::Load(packet.ox + k), oY = vec8::Load(packet.oy + k), oZ = vec8::Load(packet.oz + k);
+		const vec8 dX = vec8::Load(packet.dx + k), dY = vec8::Load(packet.dy + k), dZ = vec8::Load(packet.dz + k);
+
+		// t = dot(v0 - o, n) / dot(d, n)
+		const vec8 t = ((V0x - oX) * Nx + (V0y - oY) * Ny + (V0z - oZ) * Nz) / (dX * Nx + dY * Ny + dZ * Nz);
+
+		// w = (o + t * d) - v0
+		const vec8 wX = (oX + t * dX) - V0x;
+		const vec8 wY = (oY + t * dY) - V0y;
+		const vec8 wZ = (oZ + t * dZ) - V0z;
+		const vec8 wu = wX * Ux + wY * Uy + wZ * Uz;
+		const vec8 wv = wX * Vx + wY * Vy + wZ * Vz;
+
+		const vec8 baryU = (UV * wv - VV * wu) / DENOM;
+		const vec8 baryV = (UV * wu - UU * wv) / DENOM;
+
+		vec8 mask = (t >= TMIN) & (t <= vec8::Load(packet.tMax + k));
+		mask = mask & (baryU >= ZERO) & (baryV >= ZERO);
+		mask = mask & ((baryU + baryV) <= ONE);
+
+		t.Store(outT + k);
+		baryU.Store(outBaryU + k);
+		baryV.Store(outBaryV + k);
+		hitMask |= (uint64)MoveMask(mask) << k;
+	}
+	return hitMask;
+}
+
+static float MaxLuminance_Generic(const Pixel* pixels, size_t count)
+{
+	const vec4 weights(0.2126f, 0.7152f, 0.0722f, 0.0f);
+	float maxLuminance = 1.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		float L = dot3(vec4::Load(&pixels[i].r), weights);
+		if (maxLuminance < L)
+		{
+			maxLuminance = L;
+		}
+	}
+	return maxLuminance;
+}
+
+static void ToneMap_Generic(Pixel* pixels, size_t count, float maxWhiteLuminance)
+{
+	const vec4 weights(0.2126f, 0.7152f, 0.0722f, 0.0f);
+	for (size_t i = 0; i < count; ++i)
+	{
+		vec4 rgba = vec4::Load(&pixels[i].r);
+		float luminanceOld = dot3(rgba, weights);
+		// Div by zero if progress any further
+		if (luminanceOld <= 0.0001f)
+		{
+			rgba = vec4(0.0f);
+		}
+		else
+		{
+			float numerator = luminanceOld * (1.0f + (luminanceOld / (maxWhiteLuminance * maxWhiteLuminance)));
+			float luminanceNew = numerator / (1.0f + luminanceOld);
+			rgba = rgba * (luminanceNew / luminanceOld);
+		}
+		vec3 rgb = rgba.xyz();
+		pixels[i].r = rgb.x;
+		pixels[i].g = rgb.y;
+		pixels[i].b = rgb.z;
+	}
+}
+
+const SIMDKernels& GetSIMDKernels_Generic()
+{
+	static const SIMDKernels kernels = {
+		PacketHitBox_Generic,
+		PacketHitTriangle_Generic,
+		MaxLuminance_Generic,
+		ToneMap_Generic,
+	};
+	return kernels;
+}
+
+// -------------------------------
+// Selection
+
+static const SIMDKernels* g_simdKernels = &GetSIMDKernels_Generic();
+static ESIMDLevel g_simdLevel = ESIMDLevel::RAYLIB_SIMD_Generic;
+
+static bool IsSIMDLevelSupported(ESIMDLevel level)
+{
+	const CPUFeatures& cpu = GetCPUFeatures();
+	switch (level)
+	{
+		case ESIMDLevel::RAYLIB_SIMD_Generic: return true;
+		case ESIMDLevel::RAYLIB_SIMD_SSE42:   return cpu.bSSE42;
+		case ESIMDLevel::RAYLIB_SIMD_AVX2:    return cpu.bAVX2;
+		case ESIMDLevel::RAYLIB_SIMD_AVX512:  return cpu.bAVX512F;
+		default:                              return false;
+	}
+}
+
+static const char* GetSIMDLevelName(ESIMDLevel level)
+{
+	switch (level)
+	{
+		case ESIMDLevel::RAYLIB_SIMD_Generic: return "generic";
+		case ESIMDLevel::RAYLIB_SIMD_SSE42:   return "sse42";
+		case ESIMDLevel::RAYLIB_SIMD_AVX2:    return "avx2";
+		case ESIMDLevel::RAYLIB_SIMD_AVX512:  return "avx512";
+		default:                              return "auto";
+	}
+}
+
+const SIMDKernels& GetSIMDKernels()
+{
+	return *g_simdKernels;
+}
+
+ESIMDLevel SetSIMDLevel(ESIMDLevel level)
+{
+	if (level <= ESIMDLevel::RAYLIB_SIMD_Auto || level >= ESIMDLevel::RAYLIB_SIMD_MAX)
+	{
+		level = ESIMDLevel::RAYLIB_SIMD_AVX512;
+	}
+	while (!IsSIMDLevelSupported(level))
+	{
+		level = (ESIMDLevel)(level - 1);
+	}
+
+	switch (level)
+	{
+		case ESIMDLevel::RAYLIB_SIMD_SSE42:  g_simdKernels = &GetSIMDKernels_SSE42(); break;
+		case ESIMDLevel::RAYLIB_SIMD_AVX2:   g_simdKernels = &GetSIMDKernels_AVX2(); break;
+		case ESIMDLevel::RAYLIB_SIMD_AVX512: g_simdKernels = &GetSIMDKernels_AVX512(); break;
+		default:                             g_simdKernels = &GetSIMDKernels_Generic(); break;
+	}
+	g_simdLevel = level;
+
+	LOG("SIMD kernels: %s", GetSIMDLevelName(level));
+	return level;
+}
+
+ESIMDLevel GetSIMDLevel()
+{
+	return g_simdLevel;
+}
+
+ESIMDLevel ParseSIMDLevel(const char* name)
+{
+	for (int32 level = ESIMDLevel::RAYLIB_SIMD_Generic; level < ESIMDLevel::RAYLIB_SIMD_MAX; ++level)
+	{
+		if (name != nullptr && strcmp(name, GetSIMDLevelName((ESIMDLevel)level)) == 0)
+		{
+			return (ESIMDLevel)level;
+		}
+	}
+	return ESIMDLevel::RAYLIB_SIMD_Auto;
+}
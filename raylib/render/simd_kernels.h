@@ -0,0 +1,70 @@
+// Hot kernels compiled for several instruction sets.
+// One set is selected at runtime from CPUID (see SetSIMDLevel()), so one binary
+// runs on every CPU and still uses the widest registers it has.
+//
+// Kernels of the ISA-specific translation units are marked with SIMD_TARGET() and only use intrinsics,
+// so no inline function of a shared header is ever compiled with instructions the CPU may not have.
+// All levels do the same per-lane arithmetic in the same order, so their results are identical.
+
+#pragma once
+
+#include "raylib_types.h"
+#include "core/int_types.h"
+
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+	// MSVC allows any intrinsic without /arch.
+	#define SIMD_TARGET(isa)
+#else
+	#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+struct RayPacket;
+class AABB;
+struct Pixel;
+
+// Vertex-only terms of Triangle::Intersect().
+struct TriangleKernelData
+{
+	float v0[3];
+	float n[3];
+	float edgeU[3]; // v1 - v0
+	float edgeV[3]; // v2 - v0
+	float uu, uv, vv;
+};
+
+struct SIMDKernels
+{
+	// Same as RayPacket::HitBox().
+	bool (*packetHitBox)(const RayPacket& packet, const AABB& box, float tMin);
+
+	// Intersect every lane of the packet with a triangle, without alpha test.
+	// Writes t and barycentrics of all lanes (arrays of RAY_PACKET_SIZE).
+	// @return Bit i is set if lane i hits within [tMin, packet.tMax[i]].
+	uint64 (*packetHitTriangle)(const RayPacket& packet, const TriangleKernelData& triangle, float tMin,
+		float* outT, float* outBaryU, float* outBaryV);
+
+	// Max of 1.0 and the luminances of the pixels.
+	float (*maxLuminance)(const Pixel* pixels, size_t count);
+
+	// Extended Reinhard on RGB. Alpha is kept.
+	void (*toneMap)(Pixel* pixels, size_t count, float maxWhiteLuminance);
+};
+
+// Kernels of the current level. Generic until SetSIMDLevel() is called.
+const SIMDKernels& GetSIMDKernels();
+
+// Not thread-safe; call while nothing is rendering.
+// @return Level in use. Falls back to the best supported level below the requested one.
+ESIMDLevel SetSIMDLevel(ESIMDLevel level);
+ESIMDLevel GetSIMDLevel();
+
+// "generic", "sse42", "avx2", "avx512", or "auto". RAYLIB_SIMD_Auto for anything else.
+ESIMDLevel ParseSIMDLevel(const char* name);
+
+// Per-level kernel tables
+const SIMDKernels& GetSIMDKernels_Generic();
+const SIMDKernels& GetSIMDKernels_SSE42();
+const SIMDKernels& GetSIMDKernels_AVX2();
+const SIMDKernels& GetSIMDKernels_AVX512();
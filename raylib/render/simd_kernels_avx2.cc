@@ -0,0 +1,164 @@
+// AVX2 kernels: 8 ray lanes, 2 pixels per register.
+// NOTE: FMA is not enabled so that results match the other levels.
+
+#include "simd_kernels.h"
+#include "geom/ray_packet.h"
+#include "render/image.h"
+
+#include <immintrin.h>
+
+#define AVX2_TARGET SIMD_TARGET("avx2")
+
+AVX2_TARGET
+static bool PacketHitBox_AVX2(const RayPacket& packet, const AABB& box, float tMin)
+{
+	const __m256 minX = _mm256_set1_ps(box.minBounds.x), minY = _mm256_set1_ps(box.minBounds.y), minZ = _mm256_set1_ps(box.minBounds.z);
+	const __m256 maxX = _mm256_set1_ps(box.maxBounds.x), maxY = _mm256_set1_ps(box.maxBounds.y), maxZ = _mm256_set1_ps(box.maxBounds.z);
+	const __m256 tMin8 = _mm256_set1_ps(tMin);
+
+	const int32 numGroups = (packet.numRays + 7) / 8;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 8 * g;
+		const __m256 oX = _mm256_load_ps(packet.ox + k), oY = _mm256_load_ps(packet.oy + k), oZ = _mm256_load_ps(packet.oz + k);
+		const __m256 iX = _mm256_load_ps(packet.invDx + k), iY = _mm256_load_ps(packet.invDy + k), iZ = _mm256_load_ps(packet.invDz + k);
+
+		const __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(minX, oX), iX), t1x = _mm256_mul_ps(_mm256_sub_ps(maxX, oX), iX);
+		const __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(minY, oY), iY), t1y = _mm256_mul_ps(_mm256_sub_ps(maxY, oY), iY);
+		const __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(minZ, oZ), iZ), t1z = _mm256_mul_ps(_mm256_sub_ps(maxZ, oZ), iZ);
+
+		const __m256 tNear = _mm256_max_ps(tMin8, _mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_max_ps(_mm256_min_ps(t0y, t1y), _mm256_min_ps(t0z, t1z))));
+		const __m256 tFar = _mm256_min_ps(_mm256_load_ps(packet.tMax + k), _mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_min_ps(_mm256_max_ps(t0y, t1y), _mm256_max_ps(t0z, t1z))));
+
+		if (_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+AVX2_TARGET
+static uint64 PacketHitTriangle_AVX2(const RayPacket& packet, const TriangleKernelData& tri, float tMin,
+	float* outT, float* outBaryU, float* outBaryV)
+{
+	const __m256 V0x = _mm256_set1_ps(tri.v0[0]), V0y = _mm256_set1_ps(tri.v0[1]), V0z = _mm256_set1_ps(tri.v0[2]);
+	const __m256 Nx = _mm256_set1_ps(tri.n[0]), Ny = _mm256_set1_ps(tri.n[1]), Nz = _mm256_set1_ps(tri.n[2]);
+	const __m256 Ux = _mm256_set1_ps(tri.edgeU[0]), Uy = _mm256_set1_ps(tri.edgeU[1]), Uz = _mm256_set1_ps(tri.edgeU[2]);
+	const __m256 Vx = _mm256_set1_ps(tri.edgeV[0]), Vy = _mm256_set1_ps(tri.edgeV[1]), Vz = _mm256_set1_ps(tri.edgeV[2]);
+	const __m256 UV = _mm256_set1_ps(tri.uv), UU = _mm256_set1_ps(tri.uu), VV = _mm256_set1_ps(tri.vv);
+	const __m256 DENOM = _mm256_set1_ps(tri.uv * tri.uv - tri.uu * tri.vv);
+	const __m256 ZERO = _mm256_setzero_ps(), ONE = _mm256_set1_ps(1.0f);
+	const __m256 TMIN = _mm256_set1_ps(tMin);
+
+	uint64 hitMask = 0;
+	const int32 numGroups = (packet.numRays + 7) / 8;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 8 * g;
+		const __m256 oX = _mm256_load_ps(packet.ox + k), oY = _mm256_load_ps(packet.oy + k), oZ = _mm256_load_ps(packet.oz + k);
+		const __m256 dX = _mm256_load_ps(packet.dx + k), dY = _mm256_load_ps(packet.dy + k), dZ = _mm256_load_ps(packet.dz + k);
+
+		// t = dot(v0 - o, n) / dot(d, n)
+		const __m256 num = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_sub_ps(V0x, oX), Nx),
+			_mm256_mul_ps(_mm256_sub_ps(V0y, oY), Ny)),
+			_mm256_mul_ps(_mm256_sub_ps(V0z, oZ), Nz));
+		const __m256 den = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dX, Nx), _mm256_mul_ps(dY, Ny)), _mm256_mul_ps(dZ, Nz));
+		const __m256 t = _mm256_div_ps(num, den);
+
+		// w = (o + t * d) - v0
+		const __m256 wX = _mm256_sub_ps(_mm256_add_ps(oX, _mm256_mul_ps(t, dX)), V0x);
+		const __m256 wY = _mm256_sub_ps(_mm256_add_ps(oY, _mm256_mul_ps(t, dY)), V0y);
+		const __m256 wZ = _mm256_sub_ps(_mm256_add_ps(oZ, _mm256_mul_ps(t, dZ)), V0z);
+		const __m256 wu = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wX, Ux), _mm256_mul_ps(wY, Uy)), _mm256_mul_ps(wZ, Uz));
+		const __m256 wv = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wX, Vx), _mm256_mul_ps(wY, Vy)), _mm256_mul_ps(wZ, Vz));
+
+		const __m256 baryU = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(UV, wv), _mm256_mul_ps(VV, wu)), DENOM);
+		const __m256 baryV = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(UV, wu), _mm256_mul_ps(UU, wv)), DENOM);
+
+		__m256 mask = _mm256_and_ps(_mm256_cmp_ps(t, TMIN, _CMP_GE_OQ), _mm256_cmp_ps(t, _mm256_load_ps(packet.tMax + k), _CMP_LE_OQ));
+		mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(baryU, ZERO, _CMP_GE_OQ), _mm256_cmp_ps(baryV, ZERO, _CMP_GE_OQ)));
+		mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(baryU, baryV), ONE, _CMP_LE_OQ));
+
+		_mm256_store_ps(outT + k, t);
+		_mm256_store_ps(outBaryU + k, baryU);
+		_mm256_store_ps(outBaryV + k, baryV);
+		hitMask |= (uint64)_mm256_movemask_ps(mask) << k;
+	}
+	return hitMask;
+}
+
+// Luminance of each RGBA pixel in all 4 lanes of its half. Same summation order as dot(vec3, vec3).
+AVX2_TARGET
+static inline __m256 PixelLuminance_AVX2(__m256 rgba, __m256 weights)
+{
+	const __m256 m = _mm256_mul_ps(rgba, weights);
+	const __m256 L = _mm256_add_ps(_mm256_add_ps(m, _mm256_permute_ps(m, _MM_SHUFFLE(1, 1, 1, 1))), _mm256_permute_ps(m, _MM_SHUFFLE(2, 2, 2, 2)));
+	return _mm256_permute_ps(L, _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+// 2 pixels at once; a single last pixel is loaded into the low half.
+AVX2_TARGET
+static inline __m256 LoadPixels_AVX2(const Pixel* pixels, size_t remaining)
+{
+	return (remaining >= 2) ? _mm256_loadu_ps(&pixels[0].r) : _mm256_castps128_ps256(_mm_loadu_ps(&pixels[0].r));
+}
+
+AVX2_TARGET
+static float MaxLuminance_AVX2(const Pixel* pixels, size_t count)
+{
+	const __m256 weights = _mm256_setr_ps(0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f);
+	// NaN luminances are skipped: max() returns its second operand for NaN.
+	__m256 maxL = _mm256_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i += 2)
+	{
+		__m256 L = PixelLuminance_AVX2(LoadPixels_AVX2(pixels + i, count - i), weights);
+		if (count - i < 2)
+		{
+			L = _mm256_blend_ps(L, maxL, 0xF0);
+		}
+		maxL = _mm256_max_ps(L, maxL);
+	}
+	return _mm_cvtss_f32(_mm_max_ss(_mm256_castps256_ps128(maxL), _mm256_extractf128_ps(maxL, 1)));
+}
+
+AVX2_TARGET
+static void ToneMap_AVX2(Pixel* pixels, size_t count, float maxWhiteLuminance)
+{
+	const __m256 weights = _mm256_setr_ps(0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f);
+	const __m256 ONE = _mm256_set1_ps(1.0f);
+	const __m256 MAXWHITE2 = _mm256_set1_ps(maxWhiteLuminance * maxWhiteLuminance);
+	const __m256 THRESHOLD = _mm256_set1_ps(0.0001f);
+	for (size_t i = 0; i < count; i += 2)
+	{
+		const __m256 rgba = LoadPixels_AVX2(pixels + i, count - i);
+		const __m256 L = PixelLuminance_AVX2(rgba, weights);
+		const __m256 numerator = _mm256_mul_ps(L, _mm256_add_ps(ONE, _mm256_div_ps(L, MAXWHITE2)));
+		const __m256 luminanceNew = _mm256_div_ps(numerator, _mm256_add_ps(ONE, L));
+		__m256 rgb = _mm256_mul_ps(rgba, _mm256_div_ps(luminanceNew, L));
+		// Div by zero if progress any further
+		rgb = _mm256_blendv_ps(rgb, _mm256_setzero_ps(), _mm256_cmp_ps(L, THRESHOLD, _CMP_LE_OQ));
+		// Keep alpha
+		const __m256 result = _mm256_blend_ps(rgb, rgba, 0x88);
+		if (count - i >= 2)
+		{
+			_mm256_storeu_ps(&pixels[i].r, result);
+		}
+		else
+		{
+			_mm_storeu_ps(&pixels[i].r, _mm256_castps256_ps128(result));
+		}
+	}
+}
+
+const SIMDKernels& GetSIMDKernels_AVX2()
+{
+	static const SIMDKernels kernels = {
+		PacketHitBox_AVX2,
+		PacketHitTriangle_AVX2,
+		MaxLuminance_AVX2,
+		ToneMap_AVX2,
+	};
+	return kernels;
+}
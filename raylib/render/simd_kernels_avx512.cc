@@ -0,0 +1,161 @@
+// AVX-512 kernels: 16 ray lanes, 4 pixels per register. Only AVX-512F is required.
+// NOTE: FMA is not used so that results match the other levels.
+
+#include "simd_kernels.h"
+#include "geom/ray_packet.h"
+#include "render/image.h"
+
+#include <immintrin.h>
+
+#define AVX512_TARGET SIMD_TARGET("avx512f")
+
+AVX512_TARGET
+static bool PacketHitBox_AVX512(const RayPacket& packet, const AABB& box, float tMin)
+{
+	const __m512 minX = _mm512_set1_ps(box.minBounds.x), minY = _mm512_set1_ps(box.minBounds.y), minZ = _mm512_set1_ps(box.minBounds.z);
+	const __m512 maxX = _mm512_set1_ps(box.maxBounds.x), maxY = _mm512_set1_ps(box.maxBounds.y), maxZ = _mm512_set1_ps(box.maxBounds.z);
+	const __m512 tMin16 = _mm512_set1_ps(tMin);
+
+	const int32 numGroups = (packet.numRays + 15) / 16;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 16 * g;
+		const __m512 oX = _mm512_load_ps(packet.ox + k), oY = _mm512_load_ps(packet.oy + k), oZ = _mm512_load_ps(packet.oz + k);
+		const __m512 iX = _mm512_load_ps(packet.invDx + k), iY = _mm512_load_ps(packet.invDy + k), iZ = _mm512_load_ps(packet.invDz + k);
+
+		const __m512 t0x = _mm512_mul_ps(_mm512_sub_ps(minX, oX), iX), t1x = _mm512_mul_ps(_mm512_sub_ps(maxX, oX), iX);
+		const __m512 t0y = _mm512_mul_ps(_mm512_sub_ps(minY, oY), iY), t1y = _mm512_mul_ps(_mm512_sub_ps(maxY, oY), iY);
+		const __m512 t0z = _mm512_mul_ps(_mm512_sub_ps(minZ, oZ), iZ), t1z = _mm512_mul_ps(_mm512_sub_ps(maxZ, oZ), iZ);
+
+		const __m512 tNear = _mm512_max_ps(tMin16, _mm512_max_ps(_mm512_min_ps(t0x, t1x), _mm512_max_ps(_mm512_min_ps(t0y, t1y), _mm512_min_ps(t0z, t1z))));
+		const __m512 tFar = _mm512_min_ps(_mm512_load_ps(packet.tMax + k), _mm512_min_ps(_mm512_max_ps(t0x, t1x), _mm512_min_ps(_mm512_max_ps(t0y, t1y), _mm512_max_ps(t0z, t1z))));
+
+		if (_mm512_cmp_ps_mask(tNear, tFar, _CMP_LE_OQ) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+AVX512_TARGET
+static uint64 PacketHitTriangle_AVX512(const RayPacket& packet, const TriangleKernelData& tri, float tMin,
+	float* outT, float* outBaryU, float* outBaryV)
+{
+	const __m512 V0x = _mm512_set1_ps(tri.v0[0]), V0y = _mm512_set1_ps(tri.v0[1]), V0z = _mm512_set1_ps(tri.v0[2]);
+	const __m512 Nx = _mm512_set1_ps(tri.n[0]), Ny = _mm512_set1_ps(tri.n[1]), Nz = _mm512_set1_ps(tri.n[2]);
+	const __m512 Ux = _mm512_set1_ps(tri.edgeU[0]), Uy = _mm512_set1_ps(tri.edgeU[1]), Uz = _mm512_set1_ps(tri.edgeU[2]);
+	const __m512 Vx = _mm512_set1_ps(tri.edgeV[0]), Vy = _mm512_set1_ps(tri.edgeV[1]), Vz = _mm512_set1_ps(tri.edgeV[2]);
+	const __m512 UV = _mm512_set1_ps(tri.uv), UU = _mm512_set1_ps(tri.uu), VV = _mm512_set1_ps(tri.vv);
+	const __m512 DENOM = _mm512_set1_ps(tri.uv * tri.uv - tri.uu * tri.vv);
+	const __m512 ZERO = _mm512_setzero_ps(), ONE = _mm512_set1_ps(1.0f);
+	const __m512 TMIN = _mm512_set1_ps(tMin);
+
+	uint64 hitMask = 0;
+	const int32 numGroups = (packet.numRays + 15) / 16;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 16 * g;
+		const __m512 oX = _mm512_load_ps(packet.ox + k), oY = _mm512_load_ps(packet.oy + k), oZ = _mm512_load_ps(packet.oz + k);
+		const __m512 dX = _mm512_load_ps(packet.dx + k), dY = _mm512_load_ps(packet.dy + k), dZ = _mm512_load_ps(packet.dz + k);
+
+		// t = dot(v0 - o, n) / dot(d, n)
+		const __m512 num = _mm512_add_ps(_mm512_add_ps(
+			_mm512_mul_ps(_mm512_sub_ps(V0x, oX), Nx),
+			_mm512_mul_ps(_mm512_sub_ps(V0y, oY), Ny)),
+			_mm512_mul_ps(_mm512_sub_ps(V0z, oZ), Nz));
+		const __m512 den = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dX, Nx), _mm512_mul_ps(dY, Ny)), _mm512_mul_ps(dZ, Nz));
+		const __m512 t = _mm512_div_ps(num, den);
+
+		// w = (o + t * d) - v0
+		const __m512 wX = _mm512_sub_ps(_mm512_add_ps(oX, _mm512_mul_ps(t, dX)), V0x);
+		const __m512 wY = _mm512_sub_ps(_mm512_add_ps(oY, _mm512_mul_ps(t, dY)), V0y);
+		const __m512 wZ = _mm512_sub_ps(_mm512_add_ps(oZ, _mm512_mul_ps(t, dZ)), V0z);
+		const __m512 wu = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(wX, Ux), _mm512_mul_ps(wY, Uy)), _mm512_mul_ps(wZ, Uz));
+		const __m512 wv = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(wX, Vx), _mm512_mul_ps(wY, Vy)), _mm512_mul_ps(wZ, Vz));
+
+		const __m512 baryU = _mm512_div_ps(_mm512_sub_ps(_mm512_mul_ps(UV, wv), _mm512_mul_ps(VV, wu)), DENOM);
+		const __m512 baryV = _mm512_div_ps(_mm512_sub_ps(_mm512_mul_ps(UV, wu), _mm512_mul_ps(UU, wv)), DENOM);
+
+		__mmask16 mask = _mm512_cmp_ps_mask(t, TMIN, _CMP_GE_OQ);
+		mask = _mm512_mask_cmp_ps_mask(mask, t, _mm512_load_ps(packet.tMax + k), _CMP_LE_OQ);
+		mask = _mm512_mask_cmp_ps_mask(mask, baryU, ZERO, _CMP_GE_OQ);
+		mask = _mm512_mask_cmp_ps_mask(mask, baryV, ZERO, _CMP_GE_OQ);
+		mask = _mm512_mask_cmp_ps_mask(mask, _mm512_add_ps(baryU, baryV), ONE, _CMP_LE_OQ);
+
+		_mm512_store_ps(outT + k, t);
+		_mm512_store_ps(outBaryU + k, baryU);
+		_mm512_store_ps(outBaryV + k, baryV);
+		hitMask |= (uint64)mask << k;
+	}
+	return hitMask;
+}
+
+// Luminance of each RGBA pixel in all 4 lanes of its quarter. Same summation order as dot(vec3, vec3).
+AVX512_TARGET
+static inline __m512 PixelLuminance_AVX512(__m512 rgba, __m512 weights)
+{
+	const __m512 m = _mm512_mul_ps(rgba, weights);
+	const __m512 L = _mm512_add_ps(_mm512_add_ps(m, _mm512_permute_ps(m, _MM_SHUFFLE(1, 1, 1, 1))), _mm512_permute_ps(m, _MM_SHUFFLE(2, 2, 2, 2)));
+	return _mm512_permute_ps(L, _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+// Lanes of the first min(remaining, 4) pixels.
+AVX512_TARGET
+static inline __mmask16 PixelLaneMask_AVX512(size_t remaining)
+{
+	return (remaining >= 4) ? (__mmask16)0xFFFF : (__mmask16)((1u << (4 * remaining)) - 1);
+}
+
+AVX512_TARGET
+static float MaxLuminance_AVX512(const Pixel* pixels, size_t count)
+{
+	const __m512 weights = _mm512_setr_ps(
+		0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f,
+		0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f);
+	// NaN luminances are skipped: max() returns its second operand for NaN.
+	__m512 maxL = _mm512_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i += 4)
+	{
+		const __mmask16 laneMask = PixelLaneMask_AVX512(count - i);
+		const __m512 L = PixelLuminance_AVX512(_mm512_maskz_loadu_ps(laneMask, &pixels[i].r), weights);
+		maxL = _mm512_mask_max_ps(maxL, laneMask, L, maxL);
+	}
+	return _mm512_reduce_max_ps(maxL);
+}
+
+AVX512_TARGET
+static void ToneMap_AVX512(Pixel* pixels, size_t count, float maxWhiteLuminance)
+{
+	const __m512 weights = _mm512_setr_ps(
+		0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f,
+		0.2126f, 0.7152f, 0.0722f, 0.0f, 0.2126f, 0.7152f, 0.0722f, 0.0f);
+	const __m512 ONE = _mm512_set1_ps(1.0f);
+	const __m512 MAXWHITE2 = _mm512_set1_ps(maxWhiteLuminance * maxWhiteLuminance);
+	const __m512 THRESHOLD = _mm512_set1_ps(0.0001f);
+	const __mmask16 RGB_LANES = 0x7777;
+	for (size_t i = 0; i < count; i += 4)
+	{
+		const __mmask16 laneMask = PixelLaneMask_AVX512(count - i);
+		const __m512 rgba = _mm512_maskz_loadu_ps(laneMask, &pixels[i].r);
+		const __m512 L = PixelLuminance_AVX512(rgba, weights);
+		const __m512 numerator = _mm512_mul_ps(L, _mm512_add_ps(ONE, _mm512_div_ps(L, MAXWHITE2)));
+		const __m512 luminanceNew = _mm512_div_ps(numerator, _mm512_add_ps(ONE, L));
+		__m512 rgb = _mm512_mul_ps(rgba, _mm512_div_ps(luminanceNew, L));
+		// Div by zero if progress any further
+		rgb = _mm512_mask_mov_ps(rgb, _mm512_cmp_ps_mask(L, THRESHOLD, _CMP_LE_OQ), _mm512_setzero_ps());
+		// Alpha is not written.
+		_mm512_mask_storeu_ps(&pixels[i].r, laneMask & RGB_LANES, rgb);
+	}
+}
+
+const SIMDKernels& GetSIMDKernels_AVX512()
+{
+	static const SIMDKernels kernels = {
+		PacketHitBox_AVX512,
+		PacketHitTriangle_AVX512,
+		MaxLuminance_AVX512,
+		ToneMap_AVX512,
+	};
+	return kernels;
+}
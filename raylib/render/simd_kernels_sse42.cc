@@ -0,0 +1,143 @@
+// SSE4.2 kernels: 4 lanes, blends instead of and/andnot/or.
+
+#include "simd_kernels.h"
+#include "geom/ray_packet.h"
+#include "render/image.h"
+
+#include <nmmintrin.h>
+
+#define SSE42_TARGET SIMD_TARGET("sse4.2")
+
+SSE42_TARGET
+static bool PacketHitBox_SSE42(const RayPacket& packet, const AABB& box, float tMin)
+{
+	const __m128 minX = _mm_set1_ps(box.minBounds.x), minY = _mm_set1_ps(box.minBounds.y), minZ = _mm_set1_ps(box.minBounds.z);
+	const __m128 maxX = _mm_set1_ps(box.maxBounds.x), maxY = _mm_set1_ps(box.maxBounds.y), maxZ = _mm_set1_ps(box.maxBounds.z);
+	const __m128 tMin4 = _mm_set1_ps(tMin);
+
+	const int32 numGroups = (packet.numRays + 3) / 4;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 4 * g;
+		const __m128 oX = _mm_load_ps(packet.ox + k), oY = _mm_load_ps(packet.oy + k), oZ = _mm_load_ps(packet.oz + k);
+		const __m128 iX = _mm_load_ps(packet.invDx + k), iY = _mm_load_ps(packet.invDy + k), iZ = _mm_load_ps(packet.invDz + k);
+
+		const __m128 t0x = _mm_mul_ps(_mm_sub_ps(minX, oX), iX), t1x = _mm_mul_ps(_mm_sub_ps(maxX, oX), iX);
+		const __m128 t0y = _mm_mul_ps(_mm_sub_ps(minY, oY), iY), t1y = _mm_mul_ps(_mm_sub_ps(maxY, oY), iY);
+		const __m128 t0z = _mm_mul_ps(_mm_sub_ps(minZ, oZ), iZ), t1z = _mm_mul_ps(_mm_sub_ps(maxZ, oZ), iZ);
+
+		const __m128 tNear = _mm_max_ps(tMin4, _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_max_ps(_mm_min_ps(t0y, t1y), _mm_min_ps(t0z, t1z))));
+		const __m128 tFar = _mm_min_ps(_mm_load_ps(packet.tMax + k), _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_min_ps(_mm_max_ps(t0y, t1y), _mm_max_ps(t0z, t1z))));
+
+		if (_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+SSE42_TARGET
+static uint64 PacketHitTriangle_SSE42(const RayPacket& packet, const TriangleKernelData& tri, float tMin,
+	float* outT, float* outBaryU, float* outBaryV)
+{
+	const __m128 V0x = _mm_set1_ps(tri.v0[0]), V0y = _mm_set1_ps(tri.v0[1]), V0z = _mm_set1_ps(tri.v0[2]);
+	const __m128 Nx = _mm_set1_ps(tri.n[0]), Ny = _mm_set1_ps(tri.n[1]), Nz = _mm_set1_ps(tri.n[2]);
+	const __m128 Ux = _mm_set1_ps(tri.edgeU[0]), Uy = _mm_set1_ps(tri.edgeU[1]), Uz = _mm_set1_ps(tri.edgeU[2]);
+	const __m128 Vx = _mm_set1_ps(tri.edgeV[0]), Vy = _mm_set1_ps(tri.edgeV[1]), Vz = _mm_set1_ps(tri.edgeV[2]);
+	const __m128 UV = _mm_set1_ps(tri.uv), UU = _mm_set1_ps(tri.uu), VV = _mm_set1_ps(tri.vv);
+	const __m128 DENOM = _mm_set1_ps(tri.uv * tri.uv - tri.uu * tri.vv);
+	const __m128 ZERO = _mm_setzero_ps(), ONE = _mm_set1_ps(1.0f);
+	const __m128 TMIN = _mm_set1_ps(tMin);
+
+	uint64 hitMask = 0;
+	const int32 numGroups = (packet.numRays + 3) / 4;
+	for (int32 g = 0; g < numGroups; ++g)
+	{
+		const int32 k = 4 * g;
+		const __m128 oX = _mm_load_ps(packet.ox + k), oY = _mm_load_ps(packet.oy + k), oZ = _mm_load_ps(packet.oz + k);
+		const __m128 dX = _mm_load_ps(packet.dx + k), dY = _mm_load_ps(packet.dy + k), dZ = _mm_load_ps(packet.dz + k);
+
+		// t = dot(v0 - o, n) / dot(d, n)
+		const __m128 num = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(V0x, oX), Nx),
+			_mm_mul_ps(_mm_sub_ps(V0y, oY), Ny)),
+			_mm_mul_ps(_mm_sub_ps(V0z, oZ), Nz));
+		const __m128 den = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dX, Nx), _mm_mul_ps(dY, Ny)), _mm_mul_ps(dZ, Nz));
+		const __m128 t = _mm_div_ps(num, den);
+
+		// w = (o + t * d) - v0
+		const __m128 wX = _mm_sub_ps(_mm_add_ps(oX, _mm_mul_ps(t, dX)), V0x);
+		const __m128 wY = _mm_sub_ps(_mm_add_ps(oY, _mm_mul_ps(t, dY)), V0y);
+		const __m128 wZ = _mm_sub_ps(_mm_add_ps(oZ, _mm_mul_ps(t, dZ)), V0z);
+		const __m128 wu = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wX, Ux), _mm_mul_ps(wY, Uy)), _mm_mul_ps(wZ, Uz));
+		const __m128 wv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wX, Vx), _mm_mul_ps(wY, Vy)), _mm_mul_ps(wZ, Vz));
+
+		const __m128 baryU = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(UV, wv), _mm_mul_ps(VV, wu)), DENOM);
+		const __m128 baryV = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(UV, wu), _mm_mul_ps(UU, wv)), DENOM);
+
+		__m128 mask = _mm_and_ps(_mm_cmpge_ps(t, TMIN), _mm_cmple_ps(t, _mm_load_ps(packet.tMax + k)));
+		mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(baryU, ZERO), _mm_cmpge_ps(baryV, ZERO)));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(baryU, baryV), ONE));
+
+		_mm_store_ps(outT + k, t);
+		_mm_store_ps(outBaryU + k, baryU);
+		_mm_store_ps(outBaryV + k, baryV);
+		hitMask |= (uint64)_mm_movemask_ps(mask) << k;
+	}
+	return hitMask;
+}
+
+// Luminance of an RGBA pixel in all 4 lanes. Same summation order as dot(vec3, vec3).
+SSE42_TARGET
+static inline __m128 PixelLuminance_SSE42(__m128 rgba, __m128 weights)
+{
+	const __m128 m = _mm_mul_ps(rgba, weights);
+	const __m128 L = _mm_add_ss(_mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+	return _mm_shuffle_ps(L, L, _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+SSE42_TARGET
+static float MaxLuminance_SSE42(const Pixel* pixels, size_t count)
+{
+	const __m128 weights = _mm_setr_ps(0.2126f, 0.7152f, 0.0722f, 0.0f);
+	// NaN luminances are skipped: max() returns its second operand for NaN.
+	__m128 maxL = _mm_set1_ps(1.0f);
+	for (size_t i = 0; i < count; ++i)
+	{
+		maxL = _mm_max_ps(PixelLuminance_SSE42(_mm_loadu_ps(&pixels[i].r), weights), maxL);
+	}
+	return _mm_cvtss_f32(maxL);
+}
+
+SSE42_TARGET
+static void ToneMap_SSE42(Pixel* pixels, size_t count, float maxWhiteLuminance)
+{
+	const __m128 weights = _mm_setr_ps(0.2126f, 0.7152f, 0.0722f, 0.0f);
+	const __m128 ONE = _mm_set1_ps(1.0f);
+	const __m128 MAXWHITE2 = _mm_set1_ps(maxWhiteLuminance * maxWhiteLuminance);
+	const __m128 THRESHOLD = _mm_set1_ps(0.0001f);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const __m128 rgba = _mm_loadu_ps(&pixels[i].r);
+		const __m128 L = PixelLuminance_SSE42(rgba, weights);
+		const __m128 numerator = _mm_mul_ps(L, _mm_add_ps(ONE, _mm_div_ps(L, MAXWHITE2)));
+		const __m128 luminanceNew = _mm_div_ps(numerator, _mm_add_ps(ONE, L));
+		__m128 rgb = _mm_mul_ps(rgba, _mm_div_ps(luminanceNew, L));
+		// Div by zero if progress any further
+		rgb = _mm_blendv_ps(rgb, _mm_setzero_ps(), _mm_cmple_ps(L, THRESHOLD));
+		// Keep alpha
+		_mm_storeu_ps(&pixels[i].r, _mm_blend_ps(rgb, rgba, 0x8));
+	}
+}
+
+const SIMDKernels& GetSIMDKernels_SSE42()
+{
+	static const SIMDKernels kernels = {
+		PacketHitBox_SSE42,
+		PacketHitTriangle_SSE42,
+		MaxLuminance_SSE42,
+		ToneMap_SSE42,
+	};
+	return kernels;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "render/image.h"
+#include "core/int_types.h"
+#include "core/assertion.h"
+#include "core/aligned_allocator.h"
+
+// Largest tile a render thread works on.
+#define TILE_BUFFER_MAX_PIXELS 64
+
+// Pixels of one tile, private to the render thread that writes them.
+// The finished tile is published to the shared image with one bulk copy,
+// so threads don't write to cache lines on the edges of each other's tiles while rendering.
+struct alignas(CACHE_LINE_SIZE) TileBuffer
+{
+	Pixel pixels[TILE_BUFFER_MAX_PIXELS]; // Row-major in the tile
+	int32 x;
+	int32 y;
+	int32 width;
+	int32 height;
+
+	inline void Reset(int32 inX, int32 inY, int32 inWidth, int32 inHeight)
+	{
+		CHECK(inWidth * inHeight <= TILE_BUFFER_MAX_PIXELS);
+		x = inX;
+		y = inY;
+		width = inWidth;
+		height = inHeight;
+	}
+
+	inline void SetPixel(int32 pixelIx, const Pixel& pixel) { pixels[pixelIx] = pixel; }
+
+	inline void Publish(Image2D* image) const
+	{
+		image->WriteRegion(x, y, width, height, pixels);
+	}
+};
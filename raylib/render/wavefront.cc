@@ -0,0 +1,525 @@
+#include "wavefront.h"
+#include "render/image.h"
+#include "render/camera.h"
+#include "render/material.h"
+#include "render/path_tracing.h"
+#include "render/tile_buffer.h"
+#include "core/sampler.h"
+#include "core/assertion.h"
+#include "geom/ray.h"
+#include "geom/hit.h"
+#include "geom/ray_packet.h"
+#include "geom/scene.h"
+
+#include <algorithm>
+
+// Upper bound of paths in flight per RenderRegion() batch.
+// Samples of a region are split into several batches if exceeded.
+#define WAVEFRONT_MAX_PATHS 8192
+
+// -----------------------------------------------------------------------
+// Queues
+
+void RayQueue::Clear()
+{
+	ox.clear(); oy.clear(); oz.clear();
+	dx.clear(); dy.clear(); dz.clear();
+	time.clear();
+	pathIndex.clear();
+}
+
+void RayQueue::Reserve(int32 n)
+{
+	ox.reserve(n); oy.reserve(n); oz.reserve(n);
+	dx.reserve(n); dy.reserve(n); dz.reserve(n);
+	time.reserve(n);
+	pathIndex.reserve(n);
+}
+
+void RayQueue::Push(const vec3& origin, const vec3& direction, float worldTime, int32 inPathIndex)
+{
+	ox.push_back(origin.x); oy.push_back(origin.y); oz.push_back(origin.z);
+	dx.push_back(direction.x); dy.push_back(direction.y); dz.push_back(direction.z);
+	time.push_back(worldTime);
+	pathIndex.push_back(inPathIndex);
+}
+
+void HitQueue::Clear()
+{
+	t.clear();
+	px.clear(); py.clear(); pz.clear();
+	nx.clear(); ny.clear(); nz.clear();
+	paramU.clear(); paramV.clear();
+	material.clear();
+	materialID.clear();
+	object.clear();
+	rayIndex.clear();
+}
+
+void HitQueue::Reserve(int32 n)
+{
+	t.reserve(n);
+	px.reserve(n); py.reserve(n); pz.reserve(n);
+	nx.reserve(n); ny.reserve(n); nz.reserve(n);
+	paramU.reserve(n); paramV.reserve(n);
+	material.reserve(n);
+	materialID.reserve(n);
+	object.reserve(n);
+	rayIndex.reserve(n);
+}
+
+void HitQueue::Push(const HitResult& hitResult, uint32 inMaterialID, int32 inRayIndex)
+{
+	t.push_back(hitResult.t);
+	px.push_back(hitResult.p.x); py.push_back(hitResult.p.y); pz.push_back(hitResult.p.z);
+	nx.push_back(hitResult.n.x); ny.push_back(hitResult.n.y); nz.push_back(hitResult.n.z);
+	paramU.push_back(hitResult.paramU);
+	paramV.push_back(hitResult.paramV);
+	material.push_back(hitResult.material);
+	materialID.push_back(inMaterialID);
+	object.push_back(hitResult.object);
+	rayIndex.push_back(inRayIndex);
+}
+
+void HitQueue::Get(int32 hitIx, HitResult& outHitResult) const
+{
+	outHitResult.t = t[hitIx];
+	outHitResult.p = vec3(px[hitIx], py[hitIx], pz[hitIx]);
+	outHitResult.n = vec3(nx[hitIx], ny[hitIx], nz[hitIx]);
+	outHitResult.paramU = paramU[hitIx];
+	outHitResult.paramV = paramV[hitIx];
+	outHitResult.material = material[hitIx];
+	outHitResult.object = object[hitIx];
+}
+
+void ShadowQueue::Clear()
+{
+	rays.Clear();
+	tMax.clear();
+	Lr.clear(); Lg.clear(); Lb.clear();
+}
+
+void ShadowQueue::Push(const ray& shadowRay, float inTMax, int32 inPathIndex, const vec3& L)
+{
+	rays.Push(shadowRay.o, shadowRay.d, shadowRay.t, inPathIndex);
+	tMax.push_back(inTMax);
+	Lr.push_back(L.x); Lg.push_back(L.y); Lb.push_back(L.z);
+}
+
+void PathStates::Clear()
+{
+	throughputR.clear(); throughputG.clear(); throughputB.clear();
+	radianceR.clear(); radianceG.clear(); radianceB.clear();
+	pixelIndex.clear();
+	sampleIndex.clear();
+	prevSpecular.clear();
+	prevScatteringPdf.clear();
+	prevPx.clear(); prevPy.clear(); prevPz.clear();
+}
+
+void PathStates::Reserve(int32 n)
+{
+	throughputR.reserve(n); throughputG.reserve(n); throughputB.reserve(n);
+	radianceR.reserve(n); radianceG.reserve(n); radianceB.reserve(n);
+	pixelIndex.reserve(n);
+	sampleIndex.reserve(n);
+	prevSpecular.reserve(n);
+	prevScatteringPdf.reserve(n);
+	prevPx.reserve(n); prevPy.reserve(n); prevPz.reserve(n);
+}
+
+int32 PathStates::Push(int32 inPixelIndex, int32 inSampleIndex)
+{
+	throughputR.push_back(1.0f); throughputG.push_back(1.0f); throughputB.push_back(1.0f);
+	radianceR.push_back(0.0f); radianceG.push_back(0.0f); radianceB.push_back(0.0f);
+	pixelIndex.push_back(inPixelIndex);
+	sampleIndex.push_back(inSampleIndex);
+	prevSpecular.push_back(1);
+	prevScatteringPdf.push_back(0.0f);
+	prevPx.push_back(0.0f); prevPy.push_back(0.0f); prevPz.push_back(0.0f);
+	return (int32)pixelIndex.size() - 1;
+}
+
+// -----------------------------------------------------------------------
+// WavefrontIntegrator
+
+void WavefrontIntegrator::RenderRegion(
+	const RendererSettings& settings,
+	const Scene* world,
+	const Camera* camera,
+	Sampler& sampler,
+	int32 x, int32 y, int32 width, int32 height,
+	Image2D* outImage,
+	Image2D* const* outAOVImages)
+{
+	regionX = x;
+	regionY = y;
+	regionWidth = width;
+	regionHeight = height;
+
+	const int32 SPP = std::max(1, settings.samplesPerPixel);
+	const int32 beginSample = std::max(0, settings.firstSample);
+	const int32 numPixels = width * height;
+	const float imageWidth = (float)outImage->GetWidth();
+	const float imageHeight = (float)outImage->GetHeight();
+	const int32 samplesPerBatch = std::max(1, std::min(SPP, WAVEFRONT_MAX_PATHS / std::max(1, numPixels)));
+
+	pixelAccum.assign(numPixels, vec3(0.0f));
+	aovs.Reset(outAOVImages != nullptr ? settings.aovMask : 0, numPixels, beginSample);
+
+	for (int32 firstSample = beginSample; firstSample < beginSample + SPP; firstSample += samplesPerBatch)
+	{
+		const int32 numSamples = std::min(samplesPerBatch, beginSample + SPP - firstSample);
+
+		GenerateCameraRays(camera, sampler, imageWidth, imageHeight, firstSample, numSamples);
+
+		for (int32 depth = 0; depth < settings.maxPathLength && rayQueue.Size() > 0; ++depth)
+		{
+			Intersect(world, settings.rayTMin, depth == 0);
+			if (depth == 0 && aovs.IsEnabled())
+			{
+				RecordPrimaryAOVs(world, settings.rayTMin);
+			}
+			ShadeMisses(world, depth);
+			SortHitsByMaterial();
+			ShadeHits(world, sampler, depth, settings);
+			TraceShadowRays(world, settings.rayTMin);
+
+			std::swap(rayQueue, nextRayQueue);
+		}
+
+		for (int32 i = 0; i < paths.Size(); ++i)
+		{
+			pixelAccum[paths.pixelIndex[i]] += vec3(paths.radianceR[i], paths.radianceG[i], paths.radianceB[i]);
+		}
+	}
+
+	const float invSPP = 1.0f / (float)SPP;
+	TileBuffer tile;
+	tile.Reset(x, y, width, height);
+	for (int32 i = 0; i < numPixels; ++i)
+	{
+		vec3 L = pixelAccum[i] * invSPP;
+		tile.SetPixel(i, Pixel(L.x, L.y, L.z));
+	}
+	tile.Publish(outImage);
+	aovs.Resolve(x, y, width, SPP, outAOVImages);
+}
+
+void WavefrontIntegrator::GenerateCameraRays(
+	const Camera* camera,
+	Sampler& sampler,
+	float imageWidth, float imageHeight,
+	int32 firstSample, int32 numSamples)
+{
+	const int32 numPaths = regionWidth * regionHeight * numSamples;
+	paths.Clear();
+	paths.Reserve(numPaths);
+	rayQueue.Clear();
+	rayQueue.Reserve(numPaths);
+	nextRayQueue.Clear();
+	nextRayQueue.Reserve(numPaths);
+	hitQueue.Reserve(numPaths);
+
+	for (int32 py = 0; py < regionHeight; ++py)
+	{
+		for (int32 px = 0; px < regionWidth; ++px)
+		{
+			for (int32 s = firstSample; s < firstSample + numSamples; ++s)
+			{
+				const int32 pathIx = paths.Push(py * regionWidth + px, s);
+				StartPathSample(sampler, pathIx, 0);
+				// Same jittering as the megakernel path.
+				float jitterU, jitterV;
+				sampler.Get2D(jitterU, jitterV);
+				float u = ((float)(regionX + px) + (jitterU - 0.5f) * 2.0f) / imageWidth;
+				float v = ((float)(regionY + py) + (jitterV - 0.5f) * 2.0f) / imageHeight;
+				ray cameraRay = camera->GetCameraRay(u, v, sampler);
+				rayQueue.Push(cameraRay.o, cameraRay.d, cameraRay.t, pathIx);
+			}
+		}
+	}
+}
+
+void WavefrontIntegrator::Intersect(const Scene* world, float rayTMin, bool bPrimaryRays)
+{
+	hitQueue.Clear();
+	missQueue.clear();
+
+	const int32 numRays = rayQueue.Size();
+
+	// Camera rays are coherent; trace them as packets. Later bounces are traced one by one.
+	static thread_local RayPacket packet;
+	packetHits.resize(RAY_PACKET_SIZE);
+	int32 packetBegin = -RAY_PACKET_SIZE;
+
+	for (int32 i = 0; i < numRays; ++i)
+	{
+		ray r(
+			vec3(rayQueue.ox[i], rayQueue.oy[i], rayQueue.oz[i]),
+			vec3(rayQueue.dx[i], rayQueue.dy[i], rayQueue.dz[i]),
+			rayQueue.time[i]);
+
+		bool bHit;
+		HitResult hitResult;
+		if (bPrimaryRays)
+		{
+			if (i >= packetBegin + RAY_PACKET_SIZE)
+			{
+				packetBegin = i;
+				const int32 packetSize = std::min(RAY_PACKET_SIZE, numRays - i);
+				for (int32 lane = 0; lane < packetSize; ++lane)
+				{
+					const int32 k = i + lane;
+					packet.SetRay(lane, ray(
+						vec3(rayQueue.ox[k], rayQueue.oy[k], rayQueue.oz[k]),
+						vec3(rayQueue.dx[k], rayQueue.dy[k], rayQueue.dz[k]),
+						rayQueue.time[k]));
+				}
+				packet.Finalize(packetSize);
+				world->GetAccelStruct()->HitPacket(packet, rayTMin, packetHits.data());
+			}
+			bHit = packet.hit[i - packetBegin];
+			if (bHit)
+			{
+				const TraversalHit& hit = packetHits[i - packetBegin];
+				hit.object->ComputeSurfaceInteraction(r, hit, hitResult);
+			}
+		}
+		else
+		{
+			bHit = world->GetAccelStruct()->Hit(r, rayTMin, FLOAT_MAX, hitResult);
+		}
+
+		if (bHit)
+		{
+			hitQueue.Push(hitResult, hitResult.object->GetMaterialID(), i);
+		}
+		else
+		{
+			missQueue.push_back(i);
+		}
+	}
+}
+
+void WavefrontIntegrator::RecordPrimaryAOVs(const Scene* world, float rayTMin)
+{
+	for (int32 hitIx = 0; hitIx < hitQueue.Size(); ++hitIx)
+	{
+		const int32 rayIx = hitQueue.rayIndex[hitIx];
+		const int32 pathIx = rayQueue.pathIndex[rayIx];
+		ray cameraRay(
+			vec3(rayQueue.ox[rayIx], rayQueue.oy[rayIx], rayQueue.oz[rayIx]),
+			vec3(rayQueue.dx[rayIx], rayQueue.dy[rayIx], rayQueue.dz[rayIx]),
+			rayQueue.time[rayIx]);
+
+		HitResult hitResult;
+		hitQueue.Get(hitIx, hitResult);
+		hitResult.BuildOrthonormalBasis();
+		hitResult.EvaluateBSDF();
+
+		AOVSample aov;
+		EvaluateAOVs(world, cameraRay, hitResult, rayTMin, aov);
+		aovs.AddSample(paths.pixelIndex[pathIx], paths.sampleIndex[pathIx], aov);
+	}
+}
+
+void WavefrontIntegrator::ShadeMisses(const Scene* world, int32 depth)
+{
+	// Distant lighting: Sky
+	// The Sun is only found by light sampling in ShadeHits().
+	for (int32 rayIx : missQueue)
+	{
+		const int32 pathIx = rayQueue.pathIndex[rayIx];
+		const vec3 throughput(paths.throughputR[pathIx], paths.throughputG[pathIx], paths.throughputB[pathIx]);
+
+		vec3 dir(rayQueue.dx[rayIx], rayQueue.dy[rayIx], rayQueue.dz[rayIx]);
+		float weight = 1.0f;
+		if (depth > 0 && paths.prevSpecular[pathIx] == 0)
+		{
+			weight = PowerHeuristic(paths.prevScatteringPdf[pathIx], world->SkyPdf(dir));
+		}
+		vec3 L = throughput * world->GetSkyRadiance(dir) * weight;
+		paths.radianceR[pathIx] += L.x;
+		paths.radianceG[pathIx] += L.y;
+		paths.radianceB[pathIx] += L.z;
+	}
+}
+
+void WavefrontIntegrator::SortHitsByMaterial()
+{
+	// Keys are (material ID, hit index): the sort is stable, to keep memory access of rays
+	// within a material group coherent, and its cost doesn't depend on the number of materials in the scene.
+	const int32 numHits = hitQueue.Size();
+	sortKeys.resize(numHits);
+	for (int32 i = 0; i < numHits; ++i)
+	{
+		sortKeys[i] = ((uint64)hitQueue.materialID[i] << 32) | (uint64)i;
+	}
+	std::sort(sortKeys.begin(), sortKeys.end());
+
+	sortedHits.resize(numHits);
+	for (int32 i = 0; i < numHits; ++i)
+	{
+		sortedHits[i] = (int32)(sortKeys[i] & 0xFFFFFFFF);
+	}
+}
+
+void WavefrontIntegrator::StartPathSample(Sampler& sampler, int32 pathIx, int32 dimension) const
+{
+	const int32 pixelIx = paths.pixelIndex[pathIx];
+	sampler.StartPixelSample(
+		regionX + (pixelIx % regionWidth),
+		regionY + (pixelIx / regionWidth),
+		paths.sampleIndex[pathIx],
+		dimension);
+}
+
+void WavefrontIntegrator::ShadeHits(const Scene* world, Sampler& sampler, int32 depth, const RendererSettings& settings)
+{
+	nextRayQueue.Clear();
+	shadowQueue.Clear();
+
+	// One group per run of the same material in sortedHits, so the material and its textures
+	// stay hot in the inner loop. Only materials that were hit are visited.
+	const MaterialTable& materialTable = world->GetMaterialTable();
+	const int32 numHits = (int32)sortedHits.size();
+	int32 groupBegin = 0;
+	while (groupBegin < numHits)
+	{
+		const uint32 materialID = hitQueue.materialID[sortedHits[groupBegin]];
+		int32 groupEnd = groupBegin + 1;
+		while (groupEnd < numHits && hitQueue.materialID[sortedHits[groupEnd]] == materialID)
+		{
+			++groupEnd;
+		}
+		ShadeMaterialGroup(world, sampler, depth, settings, materialTable, materialID, groupBegin, groupEnd);
+		groupBegin = groupEnd;
+	}
+}
+
+void WavefrontIntegrator::ShadeMaterialGroup(
+	const Scene* world,
+	Sampler& sampler,
+	int32 depth,
+	const RendererSettings& settings,
+	const MaterialTable& materialTable,
+	uint32 materialID,
+	int32 groupBegin, int32 groupEnd)
+{
+	const int32 bounceDimension = GetBounceDimension(depth);
+	// Hits of unregistered materials (ID 0) each carry their own.
+	const Material* groupMaterial = materialTable.materials[materialID];
+	const bool bEmissive = (materialTable.bEmissive[materialID] != 0);
+	// Resolved once for the group and called directly.
+	const EvaluateBSDFKernel evaluateBSDF = materialTable.evaluateBSDF[materialID];
+	// Without varying parameters, all hits have the same BSDF record.
+	const bool bConstantBSDF = (materialTable.features[materialID] == 0);
+	BSDFRecord constantBSDF;
+	materialTable.GetConstantBSDF(materialID, constantBSDF);
+
+	for (int32 sortIx = groupBegin; sortIx < groupEnd; ++sortIx)
+	{
+		const int32 hitIx = sortedHits[sortIx];
+		const int32 rayIx = hitQueue.rayIndex[hitIx];
+		const int32 pathIx = rayQueue.pathIndex[rayIx];
+
+		ray pathRay(
+			vec3(rayQueue.ox[rayIx], rayQueue.oy[rayIx], rayQueue.oz[rayIx]),
+			vec3(rayQueue.dx[rayIx], rayQueue.dy[rayIx], rayQueue.dz[rayIx]),
+			rayQueue.time[rayIx]);
+
+		HitResult hitResult;
+		hitQueue.Get(hitIx, hitResult);
+		hitResult.BuildOrthonormalBasis();
+		const Material* material = (groupMaterial != nullptr) ? groupMaterial : hitResult.material;
+		if (bConstantBSDF)
+		{
+			hitResult.bsdf = constantBSDF;
+		}
+		else
+		{
+			evaluateBSDF(*material, hitResult, hitResult.bsdf);
+		}
+
+		vec3 throughput(paths.throughputR[pathIx], paths.throughputG[pathIx], paths.throughputB[pathIx]);
+
+		// Emission from the surface itself.
+		vec3 Le = hitResult.bsdf.emission;
+		if (bEmissive && Le != vec3(0.0f))
+		{
+			float weight = 1.0f;
+			if (depth > 0 && paths.prevSpecular[pathIx] == 0)
+			{
+				vec3 prevPosition(paths.prevPx[pathIx], paths.prevPy[pathIx], paths.prevPz[pathIx]);
+				weight = PowerHeuristic(paths.prevScatteringPdf[pathIx], world->EmitterPdf(prevPosition, hitResult));
+			}
+			Le = throughput * Le * weight;
+			paths.radianceR[pathIx] += Le.x;
+			paths.radianceG[pathIx] += Le.y;
+			paths.radianceB[pathIx] += Le.z;
+		}
+
+		if (depth + 1 >= settings.maxPathLength)
+		{
+			continue;
+		}
+
+		// Light sampling (deferred to the shadow stage)
+		const bool bSpecular = !material->SupportsLightSampling(hitResult);
+		DirectLightSample lightSample;
+		StartPathSample(sampler, pathIx, bounceDimension + SAMPLER_OFFSET_LIGHT);
+		if (!bSpecular && SampleDirectLighting(world, pathRay, hitResult, sampler, lightSample))
+		{
+			shadowQueue.Push(lightSample.shadowRay, lightSample.shadowRayTMax, pathIx, throughput * lightSample.radiance);
+		}
+
+		// Extend the path.
+		vec3 reflectance;
+		ray scatteredRay;
+		float pdf;
+		sampler.SetDimension(bounceDimension + SAMPLER_OFFSET_SCATTERING);
+		if (material->Scatter(pathRay, hitResult, sampler, reflectance, scatteredRay, pdf) && pdf > 0.0f)
+		{
+			float scatteringPdf = material->ScatteringPdf(hitResult, -pathRay.d, scatteredRay.d);
+			throughput *= reflectance * scatteringPdf / pdf;
+			sampler.SetDimension(bounceDimension + SAMPLER_OFFSET_RUSSIAN_ROULETTE);
+			if (!RussianRoulette(throughput, depth + 1, settings.russianRouletteDepth, sampler.Get1D()))
+			{
+				continue;
+			}
+			paths.throughputR[pathIx] = throughput.x;
+			paths.throughputG[pathIx] = throughput.y;
+			paths.throughputB[pathIx] = throughput.z;
+			paths.prevSpecular[pathIx] = bSpecular ? 1 : 0;
+			paths.prevScatteringPdf[pathIx] = pdf;
+			paths.prevPx[pathIx] = hitResult.p.x;
+			paths.prevPy[pathIx] = hitResult.p.y;
+			paths.prevPz[pathIx] = hitResult.p.z;
+
+			nextRayQueue.Push(scatteredRay.o, scatteredRay.d, scatteredRay.t, pathIx);
+		}
+	}
+}
+
+void WavefrontIntegrator::TraceShadowRays(const Scene* world, float rayTMin)
+{
+	const RayQueue& shadowRays = shadowQueue.rays;
+	const int32 numRays = shadowRays.Size();
+	for (int32 i = 0; i < numRays; ++i)
+	{
+		ray r(
+			vec3(shadowRays.ox[i], shadowRays.oy[i], shadowRays.oz[i]),
+			vec3(shadowRays.dx[i], shadowRays.dy[i], shadowRays.dz[i]),
+			shadowRays.time[i]);
+
+		TraversalHit dummy;
+		if (!world->GetAccelStruct()->Intersect(r, rayTMin, shadowQueue.tMax[i], dummy))
+		{
+			const int32 pathIx = shadowRays.pathIndex[i];
+			paths.radianceR[pathIx] += shadowQueue.Lr[i];
+			paths.radianceG[pathIx] += shadowQueue.Lg[i];
+			paths.radianceB[pathIx] += shadowQueue.Lb[i];
+		}
+	}
+}
@@ -0,0 +1,150 @@
+// Wavefront (streaming) path tracer.
+//
+// Unlike TracePath() in renderer.cc, which follows one path
+// from the camera until it dies, this integrator advances a whole batch of
+// paths one bounce at a time and splits each bounce into stages:
+//
+//   generate camera rays -> intersect -> (miss) sky -> sort hits by material
+//   -> shade -> extend (next bounce) and shadow (light sampling) -> ...
+//
+// Stages exchange structure-of-arrays ray and hit buffers.
+
+#pragma once
+
+#include "raylib_types.h"
+#include "core/int_types.h"
+#include "core/vec3.h"
+#include "geom/hit.h"
+#include "render/path_tracing.h"
+
+#include <vector>
+
+class Scene;
+class Camera;
+class Image2D;
+class Material;
+class Sampler;
+struct MaterialTable;
+
+// SoA ray buffer.
+struct RayQueue
+{
+	std::vector<float> ox, oy, oz; // origin
+	std::vector<float> dx, dy, dz; // direction
+	std::vector<float> time;
+	std::vector<int32> pathIndex;
+
+	inline int32 Size() const { return (int32)pathIndex.size(); }
+	void Clear();
+	void Reserve(int32 n);
+	void Push(const vec3& origin, const vec3& direction, float worldTime, int32 inPathIndex);
+};
+
+// SoA buffer for closest hits.
+struct HitQueue
+{
+	std::vector<float> t;
+	std::vector<float> px, py, pz; // position
+	std::vector<float> nx, ny, nz; // normal
+	std::vector<float> paramU, paramV;
+	std::vector<Material*> material;
+	std::vector<uint32> materialID; // See Scene::GetMaterialTable().
+	std::vector<const Hitable*> object;
+	std::vector<int32> rayIndex;   // Index into the ray queue that produced this hit.
+
+	inline int32 Size() const { return (int32)rayIndex.size(); }
+	void Clear();
+	void Reserve(int32 n);
+	void Push(const HitResult& hitResult, uint32 inMaterialID, int32 inRayIndex);
+	// Orthonormal basis is not built.
+	void Get(int32 hitIx, HitResult& outHitResult) const;
+};
+
+// Shadow rays carry the radiance they deliver if unoccluded.
+struct ShadowQueue
+{
+	RayQueue rays;
+	std::vector<float> tMax;
+	std::vector<float> Lr, Lg, Lb;
+
+	inline int32 Size() const { return rays.Size(); }
+	void Clear();
+	void Push(const ray& shadowRay, float inTMax, int32 inPathIndex, const vec3& L);
+};
+
+// Per-path state, also SoA.
+struct PathStates
+{
+	std::vector<float> throughputR, throughputG, throughputB;
+	std::vector<float> radianceR, radianceG, radianceB;
+	std::vector<int32> pixelIndex; // Relative to the region being rendered.
+	std::vector<int32> sampleIndex;
+	// Previous bounce, for MIS weights of emission found by scattered rays.
+	std::vector<uint8> prevSpecular;
+	std::vector<float> prevScatteringPdf;
+	std::vector<float> prevPx, prevPy, prevPz;
+
+	inline int32 Size() const { return (int32)pixelIndex.size(); }
+	void Clear();
+	void Reserve(int32 n);
+	int32 Push(int32 inPixelIndex, int32 inSampleIndex);
+};
+
+// Not thread-safe; use one instance per worker thread.
+// Buffers are kept between calls to avoid reallocation.
+class WavefrontIntegrator
+{
+
+public:
+	// Path trace all pixels in [x, x + width) * [y, y + height) of outImage.
+	// outAOVImages is null or an array indexed by EAOV; see Renderer::RenderScene().
+	// The region should not have more than TILE_BUFFER_MAX_PIXELS pixels.
+	void RenderRegion(
+		const RendererSettings& settings,
+		const Scene* world,
+		const Camera* camera,
+		Sampler& sampler,
+		int32 x, int32 y, int32 width, int32 height,
+		Image2D* outImage,
+		Image2D* const* outAOVImages = nullptr);
+
+private:
+	void GenerateCameraRays(
+		const Camera* camera,
+		Sampler& sampler,
+		float imageWidth, float imageHeight,
+		int32 firstSample, int32 numSamples);
+	void Intersect(const Scene* world, float rayTMin, bool bPrimaryRays);
+	void RecordPrimaryAOVs(const Scene* world, float rayTMin);
+	void ShadeMisses(const Scene* world, int32 depth);
+	void SortHitsByMaterial();
+	void ShadeHits(const Scene* world, Sampler& sampler, int32 depth, const RendererSettings& settings);
+	// Shade sortedHits[groupBegin, groupEnd), which all have the given material ID.
+	void ShadeMaterialGroup(
+		const Scene* world,
+		Sampler& sampler,
+		int32 depth,
+		const RendererSettings& settings,
+		const MaterialTable& materialTable,
+		uint32 materialID,
+		int32 groupBegin, int32 groupEnd);
+	// Continue the sampler from the given dimension for the pixel sample of the path.
+	void StartPathSample(Sampler& sampler, int32 pathIx, int32 dimension) const;
+	void TraceShadowRays(const Scene* world, float rayTMin);
+
+private:
+	// Region being rendered.
+	int32 regionX = 0, regionY = 0, regionWidth = 0, regionHeight = 0;
+
+	PathStates paths;
+	RayQueue rayQueue;
+	RayQueue nextRayQueue;
+	HitQueue hitQueue;
+	std::vector<int32> missQueue; // Indices into the ray queue.
+	std::vector<int32> sortedHits; // Indices into the hit queue, grouped by material.
+	std::vector<uint64> sortKeys;
+	ShadowQueue shadowQueue;
+	std::vector<vec3> pixelAccum;
+	AOVAccumulator aovs;
+	std::vector<TraversalHit> packetHits;
+};
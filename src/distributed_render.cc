@@ -0,0 +1,421 @@
+#include "distributed_render.h"
+#include "transport.h"
+
+#include "render/image.h"
+#include "core/cpu_affinity.h"
+#include "core/vec3.h"
+#include "core/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Each worker gets this many sample ranges on average.
+#define SAMPLE_RANGES_PER_WORKER 4
+#define DISTRIBUTED_MESSAGE_MAGIC 0x52594C42 // 'RYLB'
+
+enum class EDistributedMessage : uint32
+{
+	Job,    // Coordinator -> worker: DistributedRenderJob for one sample range.
+	Result, // Worker -> coordinator: DistributedResultHeader and images.
+	Quit,   // Coordinator -> worker
+};
+
+struct DistributedMessageHeader
+{
+	uint32 magic;
+	EDistributedMessage type;
+};
+
+// Followed by (1 + number of AOVs in aovMask) images of width * height float RGBs.
+// AOV images are in the order of EAOV.
+struct DistributedResultHeader
+{
+	int32 firstSample;
+	int32 numSamples;
+	uint32 width;
+	uint32 height;
+	uint32 aovMask;
+};
+
+static bool SendMessageHeader(Transport* transport, EDistributedMessage type)
+{
+	DistributedMessageHeader header{ DISTRIBUTED_MESSAGE_MAGIC, type };
+	return transport->Send(&header, sizeof(header));
+}
+
+static bool ReceiveMessageHeader(Transport* transport, EDistributedMessage& outType)
+{
+	DistributedMessageHeader header;
+	if (!transport->Receive(&header, sizeof(header)) || header.magic != DISTRIBUTED_MESSAGE_MAGIC)
+	{
+		return false;
+	}
+	outType = header.type;
+	return true;
+}
+
+static bool IsAOVRequested(uint32 aovMask, int32 aov)
+{
+	return (aovMask & (1 << aov)) != 0;
+}
+
+// -----------------------------------------------------------------------
+// Coordinator
+
+struct SampleRange
+{
+	int32 firstSample;
+	int32 numSamples;
+};
+
+// Sum of results weighted by their sample counts.
+struct DistributedAccumulator
+{
+	void Initialize(const RendererSettings& settings, int32 inFirstSample)
+	{
+		width = settings.viewportWidth;
+		height = settings.viewportHeight;
+		settings.getCropRect(cropX, cropY, cropWidth, cropHeight);
+		aovMask = settings.aovMask;
+		firstSample = inFirstSample;
+		numMergedSamples = 0;
+		mainImage.assign(width * height * 3, 0.0f);
+		for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+		{
+			aovImages[aov].assign(IsAOVRequested(aovMask, aov) ? width * height * 3 : 0, 0.0f);
+		}
+	}
+
+	void Merge(const DistributedResultHeader& header, const std::vector<float>* images)
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		const float weight = (float)header.numSamples;
+		auto WeightedAdd = [weight](std::vector<float>& dst, const std::vector<float>& src) {
+			for (size_t i = 0; i < dst.size(); ++i) dst[i] += weight * src[i];
+		};
+		WeightedAdd(mainImage, images[0]);
+		int32 imageIx = 1;
+		for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+		{
+			if (!IsAOVRequested(aovMask, aov))
+			{
+				continue;
+			}
+			if (aov == RAYLIB_AOV_Albedo || aov == RAYLIB_AOV_Normal)
+			{
+				WeightedAdd(aovImages[aov], images[imageIx]);
+			}
+			else if (header.firstSample == firstSample)
+			{
+				aovImages[aov] = images[imageIx];
+			}
+			++imageIx;
+		}
+		numMergedSamples += header.numSamples;
+	}
+
+	// Only the crop window is written, same as Raylib_Render().
+	void Resolve(ImageHandle outMainImage, const ImageHandle* outAOVImages) const
+	{
+		const float invSamples = 1.0f / (float)std::max(1, numMergedSamples);
+		auto WriteImage = [this](ImageHandle dst, const std::vector<float>& src, float scale, bool bNormalize) {
+			Image2D* image = reinterpret_cast<Image2D*>(dst);
+			if (image->GetWidth() != width || image->GetHeight() != height)
+			{
+				image->Reallocate(width, height);
+			}
+			for (uint32 y = cropY; y < cropY + cropHeight; ++y)
+			{
+				for (uint32 x = cropX; x < cropX + cropWidth; ++x)
+				{
+					const float* rgb = &src[(y * width + x) * 3];
+					vec3 v = vec3(rgb[0], rgb[1], rgb[2]) * scale;
+					if (bNormalize && v.LengthSquared() > 0.0f)
+					{
+						v.Normalize();
+					}
+					image->SetPixel(x, y, Pixel(v.x, v.y, v.z));
+				}
+			}
+		};
+		WriteImage(outMainImage, mainImage, invSamples, false);
+		for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+		{
+			if (!IsAOVRequested(aovMask, aov))
+			{
+				continue;
+			}
+			const bool bAveraged = (aov == RAYLIB_AOV_Albedo || aov == RAYLIB_AOV_Normal);
+			WriteImage(outAOVImages[aov], aovImages[aov], bAveraged ? invSamples : 1.0f, aov == RAYLIB_AOV_Normal);
+		}
+	}
+
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 cropX = 0, cropY = 0, cropWidth = 0, cropHeight = 0;
+	uint32 aovMask = 0;
+	int32 firstSample = 0;
+	int32 numMergedSamples = 0;
+	std::vector<float> mainImage;
+	std::vector<float> aovImages[RAYLIB_AOV_MAX];
+	std::mutex lock;
+};
+
+// Pending sample ranges, shared by the threads that serve each worker.
+struct SampleRangeQueue
+{
+	enum class EPopResult { Popped, Wait, Finished };
+
+	// Wait if other workers still have ranges, which might come back if they fail.
+	EPopResult Pop(SampleRange& outRange)
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		if (ranges.empty())
+		{
+			return numInFlight > 0 ? EPopResult::Wait : EPopResult::Finished;
+		}
+		outRange = ranges.front();
+		ranges.pop_front();
+		++numInFlight;
+		return EPopResult::Popped;
+	}
+	void OnRangeFinished()
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		--numInFlight;
+	}
+	// Give the range of a failed worker to others.
+	void OnRangeFailed(const SampleRange& range)
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		ranges.push_back(range);
+		--numInFlight;
+	}
+
+	std::deque<SampleRange> ranges;
+	int32 numInFlight = 0;
+	std::mutex lock;
+};
+
+static bool ReceiveResult(Transport* transport, const DistributedRenderJob& job, DistributedResultHeader& outHeader, std::vector<float>* outImages)
+{
+	EDistributedMessage type;
+	if (!ReceiveMessageHeader(transport, type) || type != EDistributedMessage::Result)
+	{
+		return false;
+	}
+	if (!transport->Receive(&outHeader, sizeof(outHeader)))
+	{
+		return false;
+	}
+	if (outHeader.width != job.settings.viewportWidth
+		|| outHeader.height != job.settings.viewportHeight
+		|| outHeader.aovMask != job.settings.aovMask)
+	{
+		return false;
+	}
+	int32 numImages = 1;
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		numImages += IsAOVRequested(outHeader.aovMask, aov) ? 1 : 0;
+	}
+	for (int32 i = 0; i < numImages; ++i)
+	{
+		outImages[i].resize(outHeader.width * outHeader.height * 3);
+		if (!transport->Receive(outImages[i].data(), outImages[i].size() * sizeof(float)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Worker processes run on this host, so they share its cores instead of each taking all of them.
+static void AssignWorkerThreads(RendererSettings& settings, int32 workerIx, int32 numWorkers)
+{
+	if (settings.numThreads == 0)
+	{
+		settings.numThreads = std::max(1u, GetNumUsableCores() / (uint32)numWorkers);
+	}
+	settings.pinSlotOffset += (uint32)workerIx * settings.numThreads;
+}
+
+// Feed sample ranges to one worker until the queue is empty or the worker fails.
+static void ServeWorker(
+	Transport* transport,
+	int32 workerIx,
+	const DistributedRenderJob& job,
+	SampleRangeQueue& rangeQueue,
+	DistributedAccumulator& accumulator)
+{
+	std::vector<float> images[1 + RAYLIB_AOV_MAX];
+	while (true)
+	{
+		SampleRange range;
+		SampleRangeQueue::EPopResult popResult = rangeQueue.Pop(range);
+		if (popResult == SampleRangeQueue::EPopResult::Finished)
+		{
+			break;
+		}
+		if (popResult == SampleRangeQueue::EPopResult::Wait)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		DistributedRenderJob rangeJob = job;
+		rangeJob.settings.firstSample = range.firstSample;
+		rangeJob.settings.samplesPerPixel = range.numSamples;
+
+		DistributedResultHeader header;
+		bool bSuccess = SendMessageHeader(transport, EDistributedMessage::Job)
+			&& transport->Send(&rangeJob, sizeof(rangeJob))
+			&& ReceiveResult(transport, job, header, images)
+			&& header.firstSample == range.firstSample
+			&& header.numSamples == range.numSamples;
+		if (!bSuccess)
+		{
+			LOG("Worker %d failed; samples [%d, %d) are given to other workers",
+				workerIx, range.firstSample, range.firstSample + range.numSamples);
+			rangeQueue.OnRangeFailed(range);
+			return;
+		}
+		accumulator.Merge(header, images);
+		rangeQueue.OnRangeFinished();
+	}
+}
+
+bool RenderDistributed(
+	const std::string& executablePath,
+	const char* workerArgName,
+	int32 numWorkers,
+	const DistributedRenderJob& job,
+	ImageHandle outMainImage,
+	const ImageHandle* outAOVImages)
+{
+	const int32 SPP = std::max(1, job.settings.samplesPerPixel);
+	const int32 firstSample = std::max(0, job.settings.firstSample);
+	numWorkers = std::max(1, std::min(numWorkers, SPP));
+
+	std::vector<std::unique_ptr<ChildProcess>> workers;
+	for (int32 i = 0; i < numWorkers; ++i)
+	{
+		ChildProcess* worker = ChildProcess::Spawn(executablePath, {}, workerArgName);
+		if (worker != nullptr)
+		{
+			workers.emplace_back(worker);
+		}
+	}
+	if (workers.size() == 0)
+	{
+		LOG("%s: no worker could be started", __FUNCTION__);
+		return false;
+	}
+	LOG("Render with %d worker processes", (int32)workers.size());
+
+	SampleRangeQueue rangeQueue;
+	const int32 numRanges = std::min(SPP, (int32)workers.size() * SAMPLE_RANGES_PER_WORKER);
+	for (int32 i = 0; i < numRanges; ++i)
+	{
+		int32 begin = SPP * i / numRanges;
+		int32 end = SPP * (i + 1) / numRanges;
+		rangeQueue.ranges.push_back(SampleRange{ firstSample + begin, end - begin });
+	}
+
+	DistributedAccumulator accumulator;
+	accumulator.Initialize(job.settings, firstSample);
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		Transport* transport = workers[i]->GetTransport();
+		DistributedRenderJob workerJob = job;
+		AssignWorkerThreads(workerJob.settings, (int32)i, (int32)workers.size());
+		threads.emplace_back([transport, i, workerJob, &rangeQueue, &accumulator]() {
+			ServeWorker(transport, (int32)i, workerJob, rangeQueue, accumulator);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (auto& worker : workers)
+	{
+		SendMessageHeader(worker->GetTransport(), EDistributedMessage::Quit);
+		worker->Join();
+	}
+
+	if (accumulator.numMergedSamples != SPP)
+	{
+		LOG("%s: all workers failed before finishing (%d of %d samples merged)",
+			__FUNCTION__, accumulator.numMergedSamples, SPP);
+		return false;
+	}
+	accumulator.Resolve(outMainImage, outAOVImages);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Worker
+
+void RunDistributedRenderWorker(Transport* transport, const DistributedRenderFunction& renderFunction)
+{
+	ImageHandle mainImage = Raylib_CreateImage(0, 0);
+	ImageHandle aovImages[RAYLIB_AOV_MAX];
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		aovImages[aov] = Raylib_CreateImage(0, 0);
+	}
+
+	std::vector<float> pixels;
+	auto SendImage = [transport, &pixels](ImageHandle image) {
+		Raylib_DumpImageData(image, pixels.data());
+		return transport->Send(pixels.data(), pixels.size() * sizeof(float));
+	};
+
+	EDistributedMessage type;
+	while (ReceiveMessageHeader(transport, type) && type == EDistributedMessage::Job)
+	{
+		DistributedRenderJob job;
+		if (!transport->Receive(&job, sizeof(job)))
+		{
+			break;
+		}
+		renderFunction(job, mainImage, aovImages);
+		pixels.resize(job.settings.viewportWidth * job.settings.viewportHeight * 3);
+
+		DistributedResultHeader header{
+			job.settings.firstSample,
+			job.settings.samplesPerPixel,
+			job.settings.viewportWidth,
+			job.settings.viewportHeight,
+			job.settings.aovMask,
+		};
+		bool bSent = SendMessageHeader(transport, EDistributedMessage::Result)
+			&& transport->Send(&header, sizeof(header))
+			&& SendImage(mainImage);
+		for (int32 aov = 0; aov < RAYLIB_AOV_MAX && bSent; ++aov)
+		{
+			if (IsAOVRequested(job.settings.aovMask, aov))
+			{
+				bSent = SendImage(aovImages[aov]);
+			}
+		}
+		if (!bSent)
+		{
+			break;
+		}
+	}
+
+	Raylib_DestroyImage(mainImage);
+	for (int32 aov = 0; aov < RAYLIB_AOV_MAX; ++aov)
+	{
+		Raylib_DestroyImage(aovImages[aov]);
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Coordinator/worker rendering across processes.
+//
+// The coordinator splits the samples of each pixel into ranges and hands them out
+// to worker processes one range at a time, so faster workers take more ranges.
+// Workers build the same scene from the job, render their range with
+// RendererSettings::firstSample and send back float images.
+// The sampler only depends on (pixel, sample index, seed), so merging the ranges
+// weighted by their sample counts gives the same image as a single process.
+//
+// Workers are started as (executable, workerArgName, <encoded pipes>) and talk to
+// the coordinator through a Transport; see transport.h.
+
+#include "raylib/raylib.h"
+#include "core/int_types.h"
+
+#include <functional>
+#include <string>
+
+class Transport;
+
+// Sent to workers as raw bytes; both sides must be the same executable.
+struct DistributedRenderJob
+{
+	uint32 sceneID;
+	float cameraLocation[3];
+	float cameraLookAt[3];
+	// samplesPerPixel and firstSample are the sample range of the whole render.
+	RendererSettings settings;
+};
+
+// Render a job into outMainImage and the AOVs requested by job.settings.aovMask.
+using DistributedRenderFunction = std::function<void(const DistributedRenderJob& job, ImageHandle outMainImage, const ImageHandle* outAOVImages)>;
+
+// Coordinator side. Blocks until all sample ranges are merged.
+// Albedo and normal AOVs are averaged over all ranges; others come from the first range.
+// Workers share the cores of this host: numThreads 0 is split evenly between them,
+// and each worker pins its threads to its own range of core slots.
+// @param outAOVImages Same as Raylib_RenderWithAOVs().
+// @return false if no worker could be started or all workers died before finishing.
+bool RenderDistributed(
+	const std::string& executablePath,
+	const char* workerArgName,
+	int32 numWorkers,
+	const DistributedRenderJob& job,
+	ImageHandle outMainImage,
+	const ImageHandle* outAOVImages);
+
+// Worker side. Renders jobs from the coordinator until told to quit or the connection is lost.
+void RunDistributedRenderWorker(Transport* transport, const DistributedRenderFunction& renderFunction);
@@ -1,5 +1,7 @@
 #include "program_args.h"
 #include "resource_finder.h"
+#include "distributed_render.h"
+#include "transport.h"
 
 // #todo-raylib: All belongs to raylib
 #include "core/random.h"
@@ -27,6 +29,7 @@ static ProgramArguments g_programArgs;
 #define SAMPLES_PER_PIXEL          10
 #define MAX_RECURSION              5
 #define RAY_T_MIN                  0.0001f
+#define RUSSIAN_ROULETTE_DEPTH     3
 
 #define DEFAULT_VIEWPORT_WIDTH     1024
 #define DEFAULT_VIEWPORT_HEIGHT    512
@@ -34,6 +37,9 @@ static ProgramArguments g_programArgs;
 #define DEFAULT_CAMERA_LOOKAT      vec3(0.0f, 0.0f, -1.0f)
 #define DEFAULT_FOV_Y              45.0f
 
+// Command line option that starts the program as a render worker (see distributed_render.h)
+#define WORKER_PROCESS_ARG         "-worker"
+
 ImageHandle skyPanorama = NULL;
 
 // Demo scenes
@@ -189,10 +195,21 @@ OBJModelContainer g_objContainer;
 void ExecuteRenderer(
 	uint32 sceneID,
 	bool bRunDenoiser,
+	int32 numWorkerProcesses,
+	float checkpointIntervalSeconds,
+	const vec3& cameraLocation,
+	const vec3& cameraLookAt,
+	const RendererSettings& settings);
+
+SceneHandle CreateSceneForRender(uint32 sceneID);
+CameraHandle CreateCameraForRender(
+	uint32 sceneID,
 	const vec3& cameraLocation,
 	const vec3& cameraLookAt,
 	const RendererSettings& settings);
 
+void RunRenderWorker(const std::string& encodedTransport);
+
 int main(int argc, char** argv) {
 	LOG("=== Software Raytracer ===");
 
@@ -207,8 +224,17 @@ int main(int argc, char** argv) {
 	}
 	ResourceFinder::Get().AddDirectory("./content/");
 
+	if (g_programArgs.optionExists(WORKER_PROCESS_ARG))
+	{
+		RunRenderWorker(g_programArgs.optionValue(WORKER_PROCESS_ARG));
+		Raylib_Terminate();
+		return 0;
+	}
+
 	uint32 currentSceneID = 0;
 	bool bRunDenoiser = true;
+	int32 numWorkerProcesses = 0;
+	float checkpointIntervalSeconds = 0.0f;
 
 	vec3 cameraLocation = g_sceneDescs[currentSceneID].cameraLocation;
 	vec3 cameraLookAt = g_sceneDescs[currentSceneID].cameraLookat;
@@ -219,7 +245,11 @@ int main(int argc, char** argv) {
 	rendererSettings.samplesPerPixel = SAMPLES_PER_PIXEL;
 	rendererSettings.maxPathLength   = MAX_RECURSION;
 	rendererSettings.rayTMin         = RAY_T_MIN;
+	rendererSettings.russianRouletteDepth = RUSSIAN_ROULETTE_DEPTH;
+	rendererSettings.seed            = 0;
 	rendererSettings.renderMode      = ERenderMode::RAYLIB_RENDERMODE_Default;
+	rendererSettings.integrator      = EIntegrator::RAYLIB_INTEGRATOR_Megakernel;
+	rendererSettings.sampler         = ESampler::RAYLIB_SAMPLER_Sobol;
 
 	Raylib_FlushLogThread();
 	std::cout << "Type 'help' to see help message" << std::endl;
@@ -242,9 +272,18 @@ int main(int argc, char** argv) {
 			std::cout << "denoiser n   : toggle denoiser (0/1)" << std::endl;
 			std::cout << "spp n        : set samplers per pixel" << std::endl;
 			std::cout << "viewport w h : set viewport size" << std::endl;
+			std::cout << "crop x y w h : only render the given region of the viewport (0 0 0 0 = off)" << std::endl;
 			std::cout << "moveto x y z : change camera location" << std::endl;
 			std::cout << "lookat x y z : change camera lookat" << std::endl;
 			std::cout << "viewmode n   : change viewmode (enter -1 to see help)" << std::endl;
+			std::cout << "integrator n : change path tracing integrator (0 = megakernel, 1 = wavefront)" << std::endl;
+			std::cout << "sampler n    : change random number source (0 = independent, 1 = sobol)" << std::endl;
+			std::cout << "pathlen n    : set max path length" << std::endl;
+			std::cout << "rr n         : start Russian roulette after n bounces (-1 = never)" << std::endl;
+			std::cout << "seed n       : set random seed" << std::endl;
+			std::cout << "workers n    : render in n worker processes (0 = in this process)" << std::endl;
+			std::cout << "threads n p  : use n render threads (0 = usable cores) and pin them to cores if p = 1" << std::endl;
+			std::cout << "checkpoint n : save a checkpoint every n seconds and resume from it (0 = off)" << std::endl;
 			std::cout << "exit         : exit the program" << std::endl;
 		}
 		else if (command == "list")
@@ -281,6 +320,8 @@ int main(int argc, char** argv) {
 			ExecuteRenderer(
 				currentSceneID,
 				bRunDenoiser,
+				numWorkerProcesses,
+				checkpointIntervalSeconds,
 				cameraLocation,
 				cameraLookAt,
 				rendererSettings);
@@ -333,6 +374,22 @@ int main(int argc, char** argv) {
 				std::cout << "Invalid viewport size" << std::endl;
 			}
 		}
+		else if (command == "crop")
+		{
+			uint32 x, y, w, h;
+			std::cin >> x >> y >> w >> h;
+			if (std::cin.good())
+			{
+				rendererSettings.cropX = x;
+				rendererSettings.cropY = y;
+				rendererSettings.cropWidth = w;
+				rendererSettings.cropHeight = h;
+			}
+			else
+			{
+				std::cout << "Invalid crop window" << std::endl;
+			}
+		}
 		else if (command == "moveto")
 		{
 			float x, y, z;
@@ -385,6 +442,118 @@ int main(int argc, char** argv) {
 				std::cout << "Invalid viewmode; please enter a number" << std::endl;
 			}
 		}
+		else if (command == "integrator")
+		{
+			uint32 integrator;
+			std::cin >> integrator;
+			if (std::cin.good() && integrator < (uint32)EIntegrator::RAYLIB_INTEGRATOR_MAX)
+			{
+				rendererSettings.integrator = integrator;
+				std::cout << "Set integrator = " << (integrator == RAYLIB_INTEGRATOR_Wavefront ? "Wavefront" : "Megakernel") << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid integrator. Current: " << rendererSettings.integrator << std::endl;
+			}
+		}
+		else if (command == "sampler")
+		{
+			uint32 sampler;
+			std::cin >> sampler;
+			if (std::cin.good() && sampler < (uint32)ESampler::RAYLIB_SAMPLER_MAX)
+			{
+				rendererSettings.sampler = sampler;
+				std::cout << "Set sampler = " << (sampler == RAYLIB_SAMPLER_Sobol ? "Sobol" : "Independent") << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid sampler. Current: " << rendererSettings.sampler << std::endl;
+			}
+		}
+		else if (command == "pathlen")
+		{
+			int32 pathLength;
+			std::cin >> pathLength;
+			if (std::cin.good() && pathLength > 0)
+			{
+				rendererSettings.maxPathLength = pathLength;
+				std::cout << "Set max path length = " << pathLength << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid path length. Current: " << rendererSettings.maxPathLength << std::endl;
+			}
+		}
+		else if (command == "rr")
+		{
+			int32 rrDepth;
+			std::cin >> rrDepth;
+			if (std::cin.good())
+			{
+				rendererSettings.russianRouletteDepth = rrDepth;
+				std::cout << "Set Russian roulette depth = " << rrDepth << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid depth. Current: " << rendererSettings.russianRouletteDepth << std::endl;
+			}
+		}
+		else if (command == "seed")
+		{
+			uint32 seed;
+			std::cin >> seed;
+			if (std::cin.good())
+			{
+				rendererSettings.seed = seed;
+				std::cout << "Set seed = " << seed << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid seed. Current: " << rendererSettings.seed << std::endl;
+			}
+		}
+		else if (command == "workers")
+		{
+			int32 numWorkers;
+			std::cin >> numWorkers;
+			if (std::cin.good() && numWorkers >= 0)
+			{
+				numWorkerProcesses = numWorkers;
+				std::cout << "Set worker processes = " << numWorkers << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid number of workers. Current: " << numWorkerProcesses << std::endl;
+			}
+		}
+		else if (command == "threads")
+		{
+			uint32 n, pin;
+			std::cin >> n >> pin;
+			if (std::cin.good())
+			{
+				rendererSettings.numThreads = n;
+				rendererSettings.pinThreads = pin;
+			}
+			else
+			{
+				std::cout << "Invalid thread settings" << std::endl;
+			}
+		}
+		else if (command == "checkpoint")
+		{
+			float interval;
+			std::cin >> interval;
+			if (std::cin.good() && interval >= 0.0f)
+			{
+				checkpointIntervalSeconds = interval;
+				std::cout << "Set checkpoint interval = " << interval << " seconds" << std::endl;
+			}
+			else
+			{
+				std::cout << "Invalid checkpoint interval. Current: " << checkpointIntervalSeconds << std::endl;
+			}
+		}
 		else if (command == "exit")
 		{
 			break;
@@ -409,12 +578,7 @@ int main(int argc, char** argv) {
 	return 0;
 }
 
-void ExecuteRenderer(
-	uint32 sceneID,
-	bool bRunDenoiser,
-	const vec3& cameraLocation,
-	const vec3& cameraLookAt,
-	const RendererSettings& settings)
+SceneHandle CreateSceneForRender(uint32 sceneID)
 {
 	const SceneDesc& sceneDesc = g_sceneDescs[sceneID];
 
@@ -423,19 +587,6 @@ void ExecuteRenderer(
 		std::string filepath = ResourceFinder::Get().Find("content/Ridgecrest_Road_Ref.hdr");
 		skyPanorama = Raylib_LoadImage(filepath.c_str());
 	}
-	
-	auto makeFilename = [&sceneDesc](const char* prefix) {
-		std::string name = SOLUTION_DIR "test_";
-		name += sceneDesc.sceneName;
-		name += prefix;
-		return name;
-	};
-
-	LOG("Execute renderer for: %s", sceneDesc.sceneName.c_str());
-
-	const uint32 viewportWidth = settings.viewportWidth;
-	const uint32 viewportHeight = settings.viewportHeight;
-	const float focalDistance = (cameraLocation - cameraLookAt).Length();
 
 	SceneHandle scene = sceneDesc.createSceneFn();
 	Raylib_SetSkyPanorama(scene, sceneDesc.bUseSkyImage ? skyPanorama : NULL);
@@ -443,6 +594,18 @@ void ExecuteRenderer(
 	Raylib_SetSunDirection(scene, sceneDesc.sunDirection.x, sceneDesc.sunDirection.y, sceneDesc.sunDirection.z);
 	Raylib_FinalizeScene(scene);
 
+	return scene;
+}
+
+CameraHandle CreateCameraForRender(
+	uint32 sceneID,
+	const vec3& cameraLocation,
+	const vec3& cameraLookAt,
+	const RendererSettings& settings)
+{
+	const SceneDesc& sceneDesc = g_sceneDescs[sceneID];
+	const float focalDistance = (cameraLocation - cameraLookAt).Length();
+
 	CameraHandle camera = Raylib_CreateCamera();
 	Raylib_CameraSetPosition(camera, cameraLocation.x, cameraLocation.y, cameraLocation.z);
 	Raylib_CameraSetLookAt(camera, cameraLookAt.x, cameraLookAt.y, cameraLookAt.z);
@@ -450,30 +613,94 @@ void ExecuteRenderer(
 	Raylib_CameraSetLens(camera, CAMERA_APERTURE, focalDistance);
 	Raylib_CameraSetMotion(camera, CAMERA_BEGIN_CAPTURE, CAMERA_END_CAPTURE);
 
-	// Render default image
-	ImageHandle mainImage = Raylib_CreateImage(viewportWidth, viewportHeight);
+	return camera;
+}
+
+void ExecuteRenderer(
+	uint32 sceneID,
+	bool bRunDenoiser,
+	int32 numWorkerProcesses,
+	float checkpointIntervalSeconds,
+	const vec3& cameraLocation,
+	const vec3& cameraLookAt,
+	const RendererSettings& settings)
+{
+	const SceneDesc& sceneDesc = g_sceneDescs[sceneID];
+
+	auto makeFilename = [&sceneDesc](const char* prefix) {
+		std::string name = SOLUTION_DIR "test_";
+		name += sceneDesc.sceneName;
+		name += prefix;
+		return name;
+	};
+
+	LOG("Execute renderer for: %s", sceneDesc.sceneName.c_str());
 
-	Raylib_Render(&settings, scene, camera, mainImage);
+	const uint32 viewportWidth = settings.viewportWidth;
+	const uint32 viewportHeight = settings.viewportHeight;
 
-	if (Raylib_IsDenoiserSupported()
+	// Workers build their own scene, so don't build it here in that case.
+	// Checkpoints are only made by renders in this process.
+	const bool bDistributed = numWorkerProcesses > 0 && settings.renderMode == RAYLIB_RENDERMODE_Default;
+	SceneHandle scene = bDistributed ? NULL : CreateSceneForRender(sceneID);
+	CameraHandle camera = bDistributed ? NULL : CreateCameraForRender(sceneID, cameraLocation, cameraLookAt, settings);
+
+	// Render default image.
+	// Aux images for the denoiser are filled from the same primary hits.
+	const bool bRunDenoiserPass = Raylib_IsDenoiserSupported()
 		&& bRunDenoiser
-		&& settings.renderMode == RAYLIB_RENDERMODE_Default)
+		&& settings.renderMode == RAYLIB_RENDERMODE_Default;
+
+	ImageHandle mainImage = Raylib_CreateImage(viewportWidth, viewportHeight);
+	ImageHandle aovImages[RAYLIB_AOV_MAX] = { 0, };
+	RendererSettings mainSettings = settings;
+	if (bRunDenoiserPass)
 	{
-		LOG("Run denoiser");
+		aovImages[RAYLIB_AOV_Albedo] = Raylib_CreateImage(viewportWidth, viewportHeight);
+		aovImages[RAYLIB_AOV_Normal] = Raylib_CreateImage(viewportWidth, viewportHeight);
+		mainSettings.aovMask |= (1 << RAYLIB_AOV_Albedo) | (1 << RAYLIB_AOV_Normal);
+	}
 
-		// Render aux images
-		ImageHandle wNormalImage = Raylib_CreateImage(viewportWidth, viewportHeight);
-		ImageHandle albedoImage = Raylib_CreateImage(viewportWidth, viewportHeight);
+	bool bRendered = false;
+	if (bDistributed)
+	{
+		DistributedRenderJob job;
+		job.sceneID = sceneID;
+		job.cameraLocation[0] = cameraLocation.x; job.cameraLocation[1] = cameraLocation.y; job.cameraLocation[2] = cameraLocation.z;
+		job.cameraLookAt[0] = cameraLookAt.x; job.cameraLookAt[1] = cameraLookAt.y; job.cameraLookAt[2] = cameraLookAt.z;
+		job.settings = mainSettings;
+		bRendered = RenderDistributed(g_programArgs.programPath(), WORKER_PROCESS_ARG, numWorkerProcesses, job, mainImage, aovImages);
+		if (!bRendered)
+		{
+			LOG("Distributed rendering has failed; render in this process");
+		}
+	}
+	if (!bRendered)
+	{
+		if (scene == NULL)
+		{
+			scene = CreateSceneForRender(sceneID);
+			camera = CreateCameraForRender(sceneID, cameraLocation, cameraLookAt, settings);
+		}
+		if (checkpointIntervalSeconds > 0.0f)
+		{
+			std::string checkpointFilename = makeFilename(".checkpoint");
+			LOG("Checkpoint file: %s", checkpointFilename.c_str());
+			Raylib_RenderWithCheckpoints(&mainSettings, scene, camera, mainImage, aovImages,
+				checkpointFilename.c_str(), checkpointIntervalSeconds);
+		}
+		else
+		{
+			Raylib_RenderWithAOVs(&mainSettings, scene, camera, mainImage, aovImages);
+		}
+	}
 
-		CameraHandle debugCamera = Raylib_CreateCamera();
-		Raylib_CameraCopy((CameraHandle)camera, debugCamera);
-		Raylib_CameraSetLens(debugCamera, 0.0f, focalDistance);
+	if (bRunDenoiserPass)
+	{
+		LOG("Run denoiser");
 
-		RendererSettings debugSettings = settings;
-		debugSettings.renderMode = RAYLIB_RENDERMODE_Albedo;
-		Raylib_Render(&debugSettings, scene, debugCamera, albedoImage);
-		debugSettings.renderMode = RAYLIB_RENDERMODE_MicrosurfaceNormal;
-		Raylib_Render(&debugSettings, scene, debugCamera, wNormalImage);
+		ImageHandle albedoImage = aovImages[RAYLIB_AOV_Albedo];
+		ImageHandle wNormalImage = aovImages[RAYLIB_AOV_Normal];
 
 		std::string albedoFilenameJPG = makeFilename("_0.jpg");
 		std::string normalFilenameJPG = makeFilename("_1.jpg");
@@ -495,7 +722,6 @@ void ExecuteRenderer(
 		Raylib_WriteImageToDisk(denoisedOutput, denoiseFilenameJPG.c_str(), RAYLIB_IMAGEFILETYPE_Jpg);
 		LOG("Write denoised image to: %s", denoiseFilenameJPG.c_str());
 
-		Raylib_DestroyCamera(debugCamera);
 		Raylib_DestroyImage(wNormalImage);
 		Raylib_DestroyImage(albedoImage);
 		Raylib_DestroyImage(denoisedOutput);
@@ -511,14 +737,58 @@ void ExecuteRenderer(
 	LOG("Write main image to: %s", resultFilenameBMP.c_str());
 	LOG("Write main image to: %s", resultFilenameJPG.c_str());
 
-	Raylib_DestroyScene(scene);
-	Raylib_DestroyCamera(camera);
+	if (scene != NULL)
+	{
+		Raylib_DestroyScene(scene);
+		Raylib_DestroyCamera(camera);
+	}
 	Raylib_DestroyImage(mainImage);
 
 	LOG("=== Rendering has completed ===");
 	Raylib_FlushLogThread();
 }
 
+void RunRenderWorker(const std::string& encodedTransport)
+{
+	PipeTransport* transport = PipeTransport::FromEncodedEnds(encodedTransport);
+	if (transport == nullptr)
+	{
+		LOG("Invalid transport for the render worker: %s", encodedTransport.c_str());
+		return;
+	}
+
+	// Ranges of one render arrive one by one, so keep the scene between jobs.
+	uint32 cachedSceneID = 0;
+	SceneHandle scene = NULL;
+
+	RunDistributedRenderWorker(transport,
+		[&](const DistributedRenderJob& job, ImageHandle outMainImage, const ImageHandle* outAOVImages) {
+			if (scene == NULL || cachedSceneID != job.sceneID)
+			{
+				if (scene != NULL)
+				{
+					Raylib_DestroyScene(scene);
+					g_objContainer.clear();
+				}
+				cachedSceneID = std::min(job.sceneID, (uint32)_countof(g_sceneDescs) - 1);
+				scene = CreateSceneForRender(cachedSceneID);
+			}
+			vec3 cameraLocation(job.cameraLocation[0], job.cameraLocation[1], job.cameraLocation[2]);
+			vec3 cameraLookAt(job.cameraLookAt[0], job.cameraLookAt[1], job.cameraLookAt[2]);
+			CameraHandle camera = CreateCameraForRender(cachedSceneID, cameraLocation, cameraLookAt, job.settings);
+			Raylib_RenderWithAOVs(&job.settings, scene, camera, outMainImage, outAOVImages);
+			Raylib_DestroyCamera(camera);
+			Raylib_FlushLogThread();
+		});
+
+	if (scene != NULL)
+	{
+		Raylib_DestroyScene(scene);
+	}
+	g_objContainer.clear();
+	delete transport;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Demo scene generator functions
 
@@ -0,0 +1,310 @@
+#include "transport.h"
+#include "core/platform.h"
+#include "core/logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+////////////////////////////////////////////////////////
+// Platform-specific
+#if PLATFORM_WINDOWS
+
+#include <Windows.h>
+
+static bool WritePipe(intptr_t pipe, const uint8* data, size_t size)
+{
+	while (size > 0)
+	{
+		DWORD written = 0;
+		if (!WriteFile((HANDLE)pipe, data, (DWORD)size, &written, NULL))
+		{
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+static bool ReadPipe(intptr_t pipe, uint8* data, size_t size)
+{
+	while (size > 0)
+	{
+		DWORD numRead = 0;
+		if (!ReadFile((HANDLE)pipe, data, (DWORD)size, &numRead, NULL) || numRead == 0)
+		{
+			return false;
+		}
+		data += numRead;
+		size -= numRead;
+	}
+	return true;
+}
+
+static void ClosePipe(intptr_t pipe)
+{
+	CloseHandle((HANDLE)pipe);
+}
+
+// Both pipes are inheritable; the parent's ends are made private after creation.
+static bool CreatePipePair(intptr_t& outParentRead, intptr_t& outParentWrite, intptr_t& outChildRead, intptr_t& outChildWrite)
+{
+	SECURITY_ATTRIBUTES sa{ sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
+	HANDLE parentRead, parentWrite, childRead, childWrite;
+	if (!CreatePipe(&childRead, &parentWrite, &sa, 0))
+	{
+		return false;
+	}
+	if (!CreatePipe(&parentRead, &childWrite, &sa, 0))
+	{
+		CloseHandle(childRead);
+		CloseHandle(parentWrite);
+		return false;
+	}
+	SetHandleInformation(parentRead, HANDLE_FLAG_INHERIT, 0);
+	SetHandleInformation(parentWrite, HANDLE_FLAG_INHERIT, 0);
+	outParentRead = (intptr_t)parentRead;
+	outParentWrite = (intptr_t)parentWrite;
+	outChildRead = (intptr_t)childRead;
+	outChildWrite = (intptr_t)childWrite;
+	return true;
+}
+
+static bool StartProcess(const std::vector<std::string>& argv, intptr_t& outProcessHandle)
+{
+	std::string commandLine;
+	for (const std::string& arg : argv)
+	{
+		if (commandLine.size() > 0) commandLine += ' ';
+		commandLine += '"' + arg + '"';
+	}
+
+	STARTUPINFOA startupInfo{};
+	startupInfo.cb = sizeof(startupInfo);
+	PROCESS_INFORMATION processInfo{};
+	if (!CreateProcessA(NULL, &commandLine[0], NULL, NULL, TRUE, 0, NULL, NULL, &startupInfo, &processInfo))
+	{
+		return false;
+	}
+	CloseHandle(processInfo.hThread);
+	outProcessHandle = (intptr_t)processInfo.hProcess;
+	return true;
+}
+
+static void WaitProcess(intptr_t processHandle)
+{
+	WaitForSingleObject((HANDLE)processHandle, INFINITE);
+	CloseHandle((HANDLE)processHandle);
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static bool WritePipe(intptr_t pipe, const uint8* data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write((int)pipe, data, size);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0)
+		{
+			return false;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+	return true;
+}
+
+static bool ReadPipe(intptr_t pipe, uint8* data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t numRead = read((int)pipe, data, size);
+		if (numRead < 0 && errno == EINTR) continue;
+		if (numRead <= 0)
+		{
+			return false;
+		}
+		data += numRead;
+		size -= (size_t)numRead;
+	}
+	return true;
+}
+
+static void ClosePipe(intptr_t pipe)
+{
+	close((int)pipe);
+}
+
+// The parent's ends are closed on exec so that children don't hold each other's pipes.
+static bool CreatePipePair(intptr_t& outParentRead, intptr_t& outParentWrite, intptr_t& outChildRead, intptr_t& outChildWrite)
+{
+	int toChild[2], toParent[2];
+	if (pipe(toChild) != 0)
+	{
+		return false;
+	}
+	if (pipe(toParent) != 0)
+	{
+		close(toChild[0]);
+		close(toChild[1]);
+		return false;
+	}
+	fcntl(toChild[1], F_SETFD, FD_CLOEXEC);
+	fcntl(toParent[0], F_SETFD, FD_CLOEXEC);
+	outParentRead = toParent[0];
+	outParentWrite = toChild[1];
+	outChildRead = toChild[0];
+	outChildWrite = toParent[1];
+	return true;
+}
+
+static bool StartProcess(const std::vector<std::string>& argv, intptr_t& outProcessHandle)
+{
+	// A dead child should fail Send() instead of killing the parent.
+	signal(SIGPIPE, SIG_IGN);
+
+	std::vector<char*> argvPtrs;
+	for (const std::string& arg : argv)
+	{
+		argvPtrs.push_back(const_cast<char*>(arg.c_str()));
+	}
+	argvPtrs.push_back(nullptr);
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		return false;
+	}
+	if (pid == 0)
+	{
+		execvp(argvPtrs[0], argvPtrs.data());
+		_exit(127);
+	}
+	outProcessHandle = (intptr_t)pid;
+	return true;
+}
+
+static void WaitProcess(intptr_t processHandle)
+{
+	int status;
+	waitpid((pid_t)processHandle, &status, 0);
+}
+
+#endif
+////////////////////////////////////////////////////////
+
+PipeTransport::PipeTransport(intptr_t inReadEnd, intptr_t inWriteEnd)
+	: readEnd(inReadEnd)
+	, writeEnd(inWriteEnd)
+{
+}
+
+PipeTransport::~PipeTransport()
+{
+	Close();
+}
+
+bool PipeTransport::Send(const void* data, size_t size)
+{
+	return writeEnd != -1 && WritePipe(writeEnd, reinterpret_cast<const uint8*>(data), size);
+}
+
+bool PipeTransport::Receive(void* data, size_t size)
+{
+	return readEnd != -1 && ReadPipe(readEnd, reinterpret_cast<uint8*>(data), size);
+}
+
+void PipeTransport::Close()
+{
+	if (readEnd != -1)
+	{
+		ClosePipe(readEnd);
+		readEnd = -1;
+	}
+	if (writeEnd != -1)
+	{
+		ClosePipe(writeEnd);
+		writeEnd = -1;
+	}
+}
+
+std::string PipeTransport::EncodeEnds(intptr_t inReadEnd, intptr_t inWriteEnd)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%lld,%lld", (long long)inReadEnd, (long long)inWriteEnd);
+	return buf;
+}
+
+PipeTransport* PipeTransport::FromEncodedEnds(const std::string& encoded)
+{
+	long long inReadEnd, inWriteEnd;
+	if (sscanf(encoded.c_str(), "%lld,%lld", &inReadEnd, &inWriteEnd) != 2)
+	{
+		return nullptr;
+	}
+	return new PipeTransport((intptr_t)inReadEnd, (intptr_t)inWriteEnd);
+}
+
+ChildProcess* ChildProcess::Spawn(
+	const std::string& executablePath,
+	const std::vector<std::string>& args,
+	const char* transportArgName)
+{
+	intptr_t parentRead, parentWrite, childRead, childWrite;
+	if (!CreatePipePair(parentRead, parentWrite, childRead, childWrite))
+	{
+		LOG("%s: failed to create pipes", __FUNCTION__);
+		return nullptr;
+	}
+
+	std::vector<std::string> argv;
+	argv.push_back(executablePath);
+	argv.insert(argv.end(), args.begin(), args.end());
+	argv.push_back(transportArgName);
+	argv.push_back(PipeTransport::EncodeEnds(childRead, childWrite));
+
+	intptr_t processHandle;
+	bool bStarted = StartProcess(argv, processHandle);
+	// The child has its own copies now.
+	ClosePipe(childRead);
+	ClosePipe(childWrite);
+
+	if (!bStarted)
+	{
+		LOG("%s: failed to start %s", __FUNCTION__, executablePath.c_str());
+		ClosePipe(parentRead);
+		ClosePipe(parentWrite);
+		return nullptr;
+	}
+
+	ChildProcess* process = new ChildProcess;
+	process->transport = new PipeTransport(parentRead, parentWrite);
+	process->processHandle = processHandle;
+	return process;
+}
+
+ChildProcess::~ChildProcess()
+{
+	Join();
+}
+
+void ChildProcess::Join()
+{
+	if (transport != nullptr)
+	{
+		delete transport;
+		transport = nullptr;
+	}
+	if (processHandle != 0)
+	{
+		WaitProcess(processHandle);
+		processHandle = 0;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "core/int_types.h"
+#include "core/noncopyable.h"
+
+#include <string>
+#include <vector>
+
+// Reliable byte stream between two processes.
+// Only this interface is visible to distributed rendering,
+// so a TCP transport can be added later without touching it.
+class Transport : public Noncopyable
+{
+
+public:
+	virtual ~Transport() {}
+
+	// Blocks until all bytes are sent or received.
+	// @return false if the connection was closed or broken.
+	virtual bool Send(const void* data, size_t size) = 0;
+	virtual bool Receive(void* data, size_t size) = 0;
+
+	virtual void Close() = 0;
+};
+
+// A pair of anonymous pipes; one for each direction.
+class PipeTransport : public Transport
+{
+
+public:
+	// Pipe ends are OS handles on Windows and file descriptors elsewhere.
+	PipeTransport(intptr_t inReadEnd, intptr_t inWriteEnd);
+	~PipeTransport();
+
+	virtual bool Send(const void* data, size_t size) override;
+	virtual bool Receive(void* data, size_t size) override;
+	virtual void Close() override;
+
+	// Encode pipe ends as a command line argument for a child process and vice versa.
+	static std::string EncodeEnds(intptr_t inReadEnd, intptr_t inWriteEnd);
+	static PipeTransport* FromEncodedEnds(const std::string& encoded);
+
+private:
+	intptr_t readEnd;
+	intptr_t writeEnd;
+};
+
+// A child process that talks to its parent through a PipeTransport.
+class ChildProcess : public Noncopyable
+{
+
+public:
+	// Run executablePath with (args..., transportArgName, <encoded pipe ends>).
+	// The child should pass the encoded ends to PipeTransport::FromEncodedEnds().
+	// @return null if the process could not be started.
+	static ChildProcess* Spawn(
+		const std::string& executablePath,
+		const std::vector<std::string>& args,
+		const char* transportArgName);
+
+	~ChildProcess();
+
+	inline Transport* GetTransport() const { return transport; }
+
+	// Close the transport and wait for the process to exit.
+	void Join();
+
+private:
+	ChildProcess() {}
+
+	Transport* transport = nullptr;
+	intptr_t processHandle = 0; // HANDLE on Windows, pid elsewhere.
+};